@@ -64,6 +64,7 @@ var includes = [
 	'src/glsl/ir_hierarchical_visitor.cpp',
 	'src/glsl/ir_hv_accept.cpp',
 	'src/glsl/ir_import_prototypes.cpp',
+	'src/glsl/ir_liveness.cpp',
 	'src/glsl/ir_print_glsl_visitor.cpp',
 	'src/glsl/ir_print_metal_visitor.cpp',
 	'src/glsl/ir_print_visitor.cpp',
@@ -83,6 +84,7 @@ var includes = [
 	'src/glsl/linker.cpp',
 	'src/glsl/loop_analysis.cpp',
 	'src/glsl/loop_controls.cpp',
+	'src/glsl/loop_invariant.cpp',
 	'src/glsl/loop_unroll.cpp',
 	'src/glsl/lower_clip_distance.cpp',
 	'src/glsl/lower_discard.cpp',
@@ -117,9 +119,11 @@ var includes = [
 	'src/glsl/opt_dead_code.cpp',
 	'src/glsl/opt_dead_code_local.cpp',
 	'src/glsl/opt_dead_functions.cpp',
+	'src/glsl/opt_dead_stores.cpp',
 	'src/glsl/opt_flatten_nested_if_blocks.cpp',
 	'src/glsl/opt_flip_matrices.cpp',
 	'src/glsl/opt_function_inlining.cpp',
+	'src/glsl/opt_if_pre.cpp',
 	'src/glsl/opt_if_simplification.cpp',
 	'src/glsl/opt_minmax.cpp',
 	'src/glsl/opt_noop_swizzle.cpp',
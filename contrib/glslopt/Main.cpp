@@ -15,6 +15,10 @@ static int printhelp(const char* msg)
 	printf("\t-1 : target OpenGL (default)\n");
 	printf("\t-2 : target OpenGL ES 2.0\n");
 	printf("\t-3 : target OpenGL ES 3.0\n");
+	printf("\t-p : print compile profile (JSON) to stdout\n");
+	printf("\t-c : print estimated cost to stdout\n");
+	printf("\t-r : limit register pressure\n");
+	printf("\t-i : only inline functions when cheap, keep large ones called often\n");
 	printf("\n\tIf no output specified, output is to [input].out.\n");
 	return 1;
 }
@@ -75,7 +79,7 @@ static bool saveFile(const char* filename, const char* data)
 	return true;
 }
 
-static bool compileShader(const char* dstfilename, const char* srcfilename, bool vertexShader)
+static bool compileShader(const char* dstfilename, const char* srcfilename, bool vertexShader, bool profile, bool cost, unsigned options)
 {
 	const char* originalShader = loadFile(srcfilename);
 	if( !originalShader )
@@ -83,13 +87,23 @@ static bool compileShader(const char* dstfilename, const char* srcfilename, bool
 
 	const glslopt_shader_type type = vertexShader ? kGlslOptShaderVertex : kGlslOptShaderFragment;
 
-	glslopt_shader* shader = glslopt_optimize(gContext, type, originalShader, 0);
+	glslopt_shader* shader = glslopt_optimize(gContext, type, originalShader, options);
+	if( profile )
+		printf("%s\n", glslopt_shader_get_profile_json(shader));
 	if( !glslopt_get_status(shader) )
 	{
 		printf( "Failed to compile %s:\n\n%s\n", srcfilename, glslopt_get_log(shader));
 		return false;
 	}
 
+	if( cost )
+	{
+		glslopt_shader_cost c;
+		glslopt_shader_get_cost(shader, &c);
+		printf("cycles %.1f (alu %.1f, tex %.1f, flow %.1f), %i fetches, %i dependent, depth %i, %i live components (%i vec4)\n",
+			c.cycles, c.aluCycles, c.textureCycles, c.flowCycles, c.textureFetches, c.dependentFetches, c.textureDepth, c.liveComponents, c.liveVec4s);
+	}
+
 	const char* optimizedShader = glslopt_get_output(shader);
 
 	if( !saveFile(dstfilename, optimizedShader) )
@@ -104,7 +118,8 @@ int main(int argc, char* argv[])
 	if( argc < 3 )
 		return printhelp(NULL);
 
-	bool vertexShader = false, freename = false;
+	bool vertexShader = false, freename = false, profile = false, cost = false, inlineBudget = false;
+	unsigned options = 0;
 	glslopt_target languageTarget = kGlslTargetOpenGL;
 	const char* source = 0;
 	char* dest = 0;
@@ -123,6 +138,14 @@ int main(int argc, char* argv[])
 				languageTarget = kGlslTargetOpenGLES20;
 			else if( 0 == strcmp("-3", argv[i]) )
 				languageTarget = kGlslTargetOpenGLES30;
+			else if( 0 == strcmp("-p", argv[i]) )
+				profile = true;
+			else if( 0 == strcmp("-c", argv[i]) )
+				cost = true;
+			else if( 0 == strcmp("-r", argv[i]) )
+				options |= kGlslOptionLimitRegisterPressure;
+			else if( 0 == strcmp("-i", argv[i]) )
+				inlineBudget = true;
 		}
 		else
 		{
@@ -141,6 +164,9 @@ int main(int argc, char* argv[])
 		printf("Failed to initialize glslopt!\n");
 		return 1;
 	}
+	glslopt_set_profiling(gContext, profile);
+	if( inlineBudget )
+		glslopt_set_inline_budget(gContext, 64, 8, 20);
 
 	if ( !dest ) {
 		dest = (char *) calloc(strlen(source)+5, sizeof(char));
@@ -149,7 +175,7 @@ int main(int argc, char* argv[])
 	}
 
 	int result = 0;
-	if( !compileShader(dest, source, vertexShader) )
+	if( !compileShader(dest, source, vertexShader, profile, cost, options) )
 		result = 1;
 
 	if( freename ) free(dest);
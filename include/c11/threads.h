@@ -0,0 +1,220 @@
+/*
+ * Minimal C11 <threads.h> emulation.
+ *
+ * Only the subset used by the GLSL optimizer is provided: plain mutexes
+ * and thread creation/joining.  Backed by pthreads on POSIX systems
+ * (including emscripten) and by the Win32 API on Windows.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef EMULATED_THREADS_H_INCLUDED_
+#define EMULATED_THREADS_H_INCLUDED_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+   thrd_success = 0,
+   thrd_error
+};
+
+enum {
+   mtx_plain = 0
+};
+
+typedef int (*thrd_start_t)(void *);
+
+
+#ifdef _WIN32
+
+typedef CRITICAL_SECTION mtx_t;
+typedef HANDLE thrd_t;
+
+/* Statically initialized critical section; see the comment in Mesa's
+ * threads_win32.h for why this layout works.
+ */
+#define _MTX_INITIALIZER_NP {(PCRITICAL_SECTION_DEBUG)-1, -1, 0, 0, 0, 0}
+
+static inline int
+mtx_init(mtx_t *mtx, int type)
+{
+   (void) type;
+   InitializeCriticalSection(mtx);
+   return thrd_success;
+}
+
+static inline void
+mtx_destroy(mtx_t *mtx)
+{
+   DeleteCriticalSection(mtx);
+}
+
+static inline int
+mtx_lock(mtx_t *mtx)
+{
+   EnterCriticalSection(mtx);
+   return thrd_success;
+}
+
+static inline int
+mtx_unlock(mtx_t *mtx)
+{
+   LeaveCriticalSection(mtx);
+   return thrd_success;
+}
+
+struct impl_thrd_param {
+   thrd_start_t func;
+   void *arg;
+};
+
+static unsigned __stdcall
+impl_thrd_routine(void *p)
+{
+   struct impl_thrd_param pack = *(struct impl_thrd_param *) p;
+   free(p);
+   return (unsigned) pack.func(pack.arg);
+}
+
+static inline int
+thrd_create(thrd_t *thr, thrd_start_t func, void *arg)
+{
+   struct impl_thrd_param *pack =
+      (struct impl_thrd_param *) malloc(sizeof(struct impl_thrd_param));
+   uintptr_t handle;
+   if (!pack)
+      return thrd_error;
+   pack->func = func;
+   pack->arg = arg;
+   handle = _beginthreadex(NULL, 0, impl_thrd_routine, pack, 0, NULL);
+   if (handle == 0) {
+      free(pack);
+      return thrd_error;
+   }
+   *thr = (thrd_t) handle;
+   return thrd_success;
+}
+
+static inline int
+thrd_join(thrd_t thr, int *res)
+{
+   DWORD code;
+   if (WaitForSingleObject(thr, INFINITE) != WAIT_OBJECT_0)
+      return thrd_error;
+   if (res) {
+      if (!GetExitCodeThread(thr, &code)) {
+         CloseHandle(thr);
+         return thrd_error;
+      }
+      *res = (int) code;
+   }
+   CloseHandle(thr);
+   return thrd_success;
+}
+
+#else /* POSIX */
+
+typedef pthread_mutex_t mtx_t;
+typedef pthread_t thrd_t;
+
+#define _MTX_INITIALIZER_NP PTHREAD_MUTEX_INITIALIZER
+
+static inline int
+mtx_init(mtx_t *mtx, int type)
+{
+   (void) type;
+   return pthread_mutex_init(mtx, NULL) == 0 ? thrd_success : thrd_error;
+}
+
+static inline void
+mtx_destroy(mtx_t *mtx)
+{
+   pthread_mutex_destroy(mtx);
+}
+
+static inline int
+mtx_lock(mtx_t *mtx)
+{
+   return pthread_mutex_lock(mtx) == 0 ? thrd_success : thrd_error;
+}
+
+static inline int
+mtx_unlock(mtx_t *mtx)
+{
+   return pthread_mutex_unlock(mtx) == 0 ? thrd_success : thrd_error;
+}
+
+struct impl_thrd_param {
+   thrd_start_t func;
+   void *arg;
+};
+
+static inline void *
+impl_thrd_routine(void *p)
+{
+   struct impl_thrd_param pack = *(struct impl_thrd_param *) p;
+   free(p);
+   return (void *) (intptr_t) pack.func(pack.arg);
+}
+
+static inline int
+thrd_create(thrd_t *thr, thrd_start_t func, void *arg)
+{
+   struct impl_thrd_param *pack =
+      (struct impl_thrd_param *) malloc(sizeof(struct impl_thrd_param));
+   if (!pack)
+      return thrd_error;
+   pack->func = func;
+   pack->arg = arg;
+   if (pthread_create(thr, NULL, impl_thrd_routine, pack) != 0) {
+      free(pack);
+      return thrd_error;
+   }
+   return thrd_success;
+}
+
+static inline int
+thrd_join(thrd_t thr, int *res)
+{
+   void *code;
+   if (pthread_join(thr, &code) != 0)
+      return thrd_error;
+   if (res)
+      *res = (int) (intptr_t) code;
+   return thrd_success;
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EMULATED_THREADS_H_INCLUDED_ */
@@ -1104,6 +1104,26 @@ private:
 extern void
 _mesa_ast_to_hir(exec_list *instructions, struct _mesa_glsl_parse_state *state);
 
+/**
+ * Convert the AST of a prelude, source that other shaders are compiled as
+ * following.  This is what \c _mesa_ast_to_hir does, short of the checks
+ * and rearranging it does over the complete shader at the end.
+ */
+extern void
+_mesa_ast_to_hir_prelude(exec_list *instructions,
+                         struct _mesa_glsl_parse_state *state);
+
+/**
+ * Convert the AST of a shader that follows a prelude, continuing from a copy
+ * of the instructions and symbols \c _mesa_ast_to_hir_prelude left.  The
+ * state has to be one made by \c _mesa_glsl_parse_state_after_prelude.
+ */
+extern void
+_mesa_ast_to_hir_after_prelude(exec_list *instructions,
+                               struct _mesa_glsl_parse_state *state,
+                               const exec_list *prelude_instructions,
+                               struct glsl_symbol_table *prelude_symbols);
+
 extern ir_rvalue *
 _mesa_ast_field_selection_to_hir(const ast_expression *expr,
 				 exec_list *instructions,
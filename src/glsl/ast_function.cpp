@@ -453,7 +453,7 @@ generate_call(exec_list *instructions, ir_function_signature *sig,
     * 1.20 and GLSL ES 3.00.
     */
    if (state->is_version(120, 300)) {
-      ir_constant *value = sig->constant_expression_value(actual_parameters, NULL);
+      ir_constant *value = sig->constant_expression_value(ctx, actual_parameters, NULL);
       if (value != NULL) {
 	 return value;
       }
@@ -570,11 +570,10 @@ no_matching_function_error(const char *name,
 			   exec_list *actual_parameters,
 			   _mesa_glsl_parse_state *state)
 {
-   gl_shader *sh = _mesa_glsl_get_builtin_function_shader();
+   ir_function *builtin = state->uses_builtin_functions
+      ? _mesa_glsl_get_builtin_function(name) : NULL;
 
-   if (state->symbols->get_function(name) == NULL
-      && (!state->uses_builtin_functions
-          || sh->symbols->get_function(name) == NULL)) {
+   if (state->symbols->get_function(name) == NULL && builtin == NULL) {
       _mesa_glsl_error(loc, state, "no function with name '%s'", name);
    } else {
       char *str = prototype_string(NULL, name, actual_parameters);
@@ -585,8 +584,8 @@ no_matching_function_error(const char *name,
 
       print_function_prototypes(state, loc, state->symbols->get_function(name));
 
-      if (state->uses_builtin_functions) {
-         print_function_prototypes(state, loc, sh->symbols->get_function(name));
+      if (builtin != NULL) {
+         print_function_prototypes(state, loc, builtin);
       }
    }
 }
@@ -67,8 +67,8 @@ remove_per_vertex_blocks(exec_list *instructions,
                          _mesa_glsl_parse_state *state, ir_variable_mode mode);
 
 
-void
-_mesa_ast_to_hir(exec_list *instructions, struct _mesa_glsl_parse_state *state)
+static void
+begin_hir(exec_list *instructions, struct _mesa_glsl_parse_state *state)
 {
    _mesa_glsl_initialize_variables(instructions, state);
 
@@ -76,8 +76,6 @@ _mesa_ast_to_hir(exec_list *instructions, struct _mesa_glsl_parse_state *state)
 
    state->current_function = NULL;
 
-   state->toplevel_ir = instructions;
-
    state->gs_input_prim_type_specified = false;
    state->cs_input_local_size_specified = false;
 
@@ -95,15 +93,28 @@ _mesa_ast_to_hir(exec_list *instructions, struct _mesa_glsl_parse_state *state)
     * by the linker.
     */
    state->symbols->push_scope();
+}
+
+
+static void
+translation_unit_to_hir(exec_list *instructions,
+                        struct _mesa_glsl_parse_state *state)
+{
+   state->toplevel_ir = instructions;
 
    foreach_list_typed (ast_node, ast, link, & state->translation_unit)
       ast->hir(instructions, state);
 
+   state->toplevel_ir = NULL;
+}
+
+
+static void
+end_hir(exec_list *instructions, struct _mesa_glsl_parse_state *state)
+{
    detect_recursion_unlinked(state, instructions);
    detect_conflicting_assignments(state, instructions);
 
-   state->toplevel_ir = NULL;
-
    /* Move all of the variable declarations to the front of the IR list, and
     * reverse the order.  This has the (intended!) side effect that vertex
     * shader inputs and fragment shader outputs will appear in the IR in the
@@ -177,6 +188,47 @@ _mesa_ast_to_hir(exec_list *instructions, struct _mesa_glsl_parse_state *state)
 }
 
 
+void
+_mesa_ast_to_hir(exec_list *instructions, struct _mesa_glsl_parse_state *state)
+{
+   begin_hir(instructions, state);
+   translation_unit_to_hir(instructions, state);
+   end_hir(instructions, state);
+}
+
+
+void
+_mesa_ast_to_hir_prelude(exec_list *instructions,
+                         struct _mesa_glsl_parse_state *state)
+{
+   begin_hir(instructions, state);
+   translation_unit_to_hir(instructions, state);
+}
+
+
+void
+_mesa_ast_to_hir_after_prelude(exec_list *instructions,
+                               struct _mesa_glsl_parse_state *state,
+                               const exec_list *prelude_instructions,
+                               glsl_symbol_table *prelude_symbols)
+{
+   struct hash_table *ht =
+      hash_table_ctor(0, hash_table_pointer_hash, hash_table_pointer_compare);
+
+   /* The symbols have to refer to the copies of the prelude's variables and
+    * functions, not to the originals.
+    */
+   clone_ir_list(state, instructions, prelude_instructions, ht);
+   delete state->symbols;
+   state->symbols = prelude_symbols->clone(ralloc_parent(state), ht);
+
+   hash_table_dtor(ht);
+
+   translation_unit_to_hir(instructions, state);
+   end_hir(instructions, state);
+}
+
+
 static ir_expression_operation
 get_conversion_operation(const glsl_type *to, const glsl_type *from,
                          struct _mesa_glsl_parse_state *state)
@@ -60,6 +60,8 @@
 #include "ir_builder.h"
 #include "glsl_parser_extras.h"
 #include "program/prog_instruction.h"
+#include "c11/threads.h"
+#include "util/hash_table.h"
 #include <limits>
 
 #define M_PIf   ((float) M_PI)
@@ -442,6 +444,22 @@ public:
 private:
    void *mem_ctx;
 
+   /**
+    * Built-ins are created lazily, one name at a time, the first time a
+    * shader asks for them.  While create_builtins() runs on behalf of
+    * find(), \c lazy_name holds the requested name and every other
+    * add_function() call is skipped without building its signatures.
+    */
+   const char *lazy_name;
+
+   /** Names find() has already built (or found not to be built-ins). */
+   struct hash_table *created_names;
+
+   bool wants_function(const char *name) const
+   {
+      return lazy_name == NULL || strcmp(name, lazy_name) == 0;
+   }
+
    /** Global variables used by built-in functions. */
    ir_variable *gl_ModelViewProjectionMatrix;
    ir_variable *gl_Vertex;
@@ -719,6 +737,8 @@ private:
  */
 builtin_builder::builtin_builder()
    : shader(NULL),
+     lazy_name(NULL),
+     created_names(NULL),
      gl_ModelViewProjectionMatrix(NULL),
      gl_Vertex(NULL)
 {
@@ -744,8 +764,26 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
    state->uses_builtin_functions = true;
 
    ir_function *f = shader->symbols->get_function(name);
-   if (f == NULL)
-      return NULL;
+   if (f == NULL) {
+      /* Only run the generators for a given name once; user-defined
+       * functions end up here too and must not rescan every time.
+       */
+      if (_mesa_hash_table_search(created_names, _mesa_hash_string(name),
+                                  name) != NULL)
+         return NULL;
+
+      const char *key = ralloc_strdup(mem_ctx, name);
+      _mesa_hash_table_insert(created_names, _mesa_hash_string(key), key,
+                              NULL);
+
+      lazy_name = key;
+      create_builtins();
+      lazy_name = NULL;
+
+      f = shader->symbols->get_function(name);
+      if (f == NULL)
+         return NULL;
+   }
 
    ir_function_signature *sig =
       f->matching_signature(state, actual_parameters, true);
@@ -763,9 +801,11 @@ builtin_builder::initialize()
       return;
 
    mem_ctx = ralloc_context(NULL);
+   created_names = _mesa_hash_table_create(mem_ctx, _mesa_key_string_equal);
    create_shader();
    create_intrinsics();
-   create_builtins();
+
+   /* The built-ins themselves are created on demand by find(). */
 }
 
 void
@@ -773,6 +813,7 @@ builtin_builder::release()
 {
    ralloc_free(mem_ctx);
    mem_ctx = NULL;
+   created_names = NULL;
 
    ralloc_free(shader);
    shader = NULL;
@@ -828,11 +869,19 @@ builtin_builder::create_intrinsics()
 /**
  * Create ir_function and ir_function_signature objects for each built-in.
  *
- * Contains a list of every available built-in.
+ * Contains a list of every available built-in.  When \c lazy_name is set
+ * only that built-in is created; the add_function() wrapper below keeps the
+ * signature generators of all the others from being evaluated at all.
  */
 void
 builtin_builder::create_builtins()
 {
+#define add_function(NAME, ...)                 \
+   do {                                         \
+      if (wants_function(NAME))                 \
+         add_function(NAME, __VA_ARGS__);       \
+   } while (0)
+
 #define F(NAME)                                 \
    add_function(#NAME,                          \
                 _##NAME(glsl_type::float_type), \
@@ -2367,6 +2416,7 @@ builtin_builder::create_builtins()
 #undef FIU
 #undef FIUB
 #undef FIU2_MIXED
+#undef add_function
 }
 
 void
@@ -2436,6 +2486,10 @@ builtin_builder::add_image_function(const char *name,
       glsl_type::uimage2DMS_type,
       glsl_type::uimage2DMSArray_type
    };
+
+   if (!wants_function(name))
+      return;
+
    ir_function *f = new(mem_ctx) ir_function(name);
 
    for (unsigned i = 0; i < Elements(types); ++i) {
@@ -4625,14 +4679,12 @@ builtin_builder::_memory_barrier(builtin_available_predicate avail)
 
 /******************************************************************************/
 
-//@TODO: implement
-typedef int mtx_t;
-#define _MTX_INITIALIZER_NP 0
-#define mtx_lock(name)
-#define mtx_unlock(name)
-
-
-/* The singleton instance of builtin_builder. */
+/* The singleton instance of builtin_builder.
+ *
+ * Built-ins are added to it on demand, so every access to its symbol table
+ * has to go through builtins_lock; compiles running on other threads only
+ * look up and clone from it.
+ */
 static builtin_builder builtins;
 static mtx_t builtins_lock = _MTX_INITIALIZER_NP;
 
@@ -4667,6 +4719,16 @@ _mesa_glsl_find_builtin_function(_mesa_glsl_parse_state *state,
    return s;
 }
 
+ir_function *
+_mesa_glsl_get_builtin_function(const char *name)
+{
+   ir_function *f;
+   mtx_lock(&builtins_lock);
+   f = builtins.shader->symbols->get_function(name);
+   mtx_unlock(&builtins_lock);
+   return f;
+}
+
 gl_shader *
 _mesa_glsl_get_builtin_function_shader()
 {
@@ -636,6 +636,20 @@ void glcpp_set_column (int  column_no , yyscan_t yyscanner);
 
 #define YY_NO_INPUT
 
+/* Read the shader straight from where the caller has it, which need not be
+ * NUL-terminated, rather than from a full copy made up front.  flex only
+ * copies what fits its buffer at a time. */
+#define YY_INPUT(buf, result, max_size)					\
+	do {								\
+		size_t n = yyextra->input_length;			\
+		if (n > (size_t) (max_size))				\
+			n = (size_t) (max_size);			\
+		memcpy(buf, yyextra->input, n);				\
+		yyextra->input += n;					\
+		yyextra->input_length -= n;				\
+		result = n;						\
+	} while (0)
+
 #define YY_USER_ACTION							\
 	do {								\
 		if (parser->has_new_line_number)			\
@@ -759,7 +773,7 @@ match longer strings take priority over those matching shorter
 strings, we have to be careful to avoid OTHER matching and hiding
 something that CPP does care about. So we simply exclude all
 characters that appear in any other expressions. */
-#line 763 "src/glsl/glcpp/glcpp-lex.c"
+#line 777 "src/glsl/glcpp/glcpp-lex.c"
 
 #define INITIAL 0
 #define COMMENT 1
@@ -1002,7 +1016,7 @@ YY_DECL
 	register int yy_act;
     struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 
-#line 195 "src/glsl/glcpp/glcpp-lex.l"
+#line 209 "src/glsl/glcpp/glcpp-lex.l"
 
 
 	glcpp_parser_t *parser = yyextra;
@@ -1063,7 +1077,7 @@ YY_DECL
 	}
 
 	/* Single-line comments */
-#line 1067 "src/glsl/glcpp/glcpp-lex.c"
+#line 1081 "src/glsl/glcpp/glcpp-lex.c"
 
     yylval = yylval_param;
 
@@ -1148,41 +1162,41 @@ do_action:	/* This label is used only to access EOF actions. */
 
 case 1:
 YY_RULE_SETUP
-#line 255 "src/glsl/glcpp/glcpp-lex.l"
+#line 269 "src/glsl/glcpp/glcpp-lex.l"
 {
 }
 	YY_BREAK
 /* Multi-line comments */
 case 2:
 YY_RULE_SETUP
-#line 259 "src/glsl/glcpp/glcpp-lex.l"
+#line 273 "src/glsl/glcpp/glcpp-lex.l"
 { yy_push_state(COMMENT, yyscanner); }
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 260 "src/glsl/glcpp/glcpp-lex.l"
+#line 274 "src/glsl/glcpp/glcpp-lex.l"
 
 	YY_BREAK
 case 4:
 /* rule 4 can match eol */
 YY_RULE_SETUP
-#line 261 "src/glsl/glcpp/glcpp-lex.l"
+#line 275 "src/glsl/glcpp/glcpp-lex.l"
 { yylineno++; yycolumn = 0; parser->commented_newlines++; }
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 262 "src/glsl/glcpp/glcpp-lex.l"
+#line 276 "src/glsl/glcpp/glcpp-lex.l"
 
 	YY_BREAK
 case 6:
 /* rule 6 can match eol */
 YY_RULE_SETUP
-#line 263 "src/glsl/glcpp/glcpp-lex.l"
+#line 277 "src/glsl/glcpp/glcpp-lex.l"
 { yylineno++; yycolumn = 0; parser->commented_newlines++; }
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 264 "src/glsl/glcpp/glcpp-lex.l"
+#line 278 "src/glsl/glcpp/glcpp-lex.l"
 {
 	yy_pop_state(yyscanner);
 	/* In the <HASH> start condition, we don't want any SPACE token. */
@@ -1192,7 +1206,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 271 "src/glsl/glcpp/glcpp-lex.l"
+#line 285 "src/glsl/glcpp/glcpp-lex.l"
 {
 
 	/* If the '#' is the first non-whitespace, non-comment token on this
@@ -1210,7 +1224,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 286 "src/glsl/glcpp/glcpp-lex.l"
+#line 300 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	yyextra->space_tokens = 0;
@@ -1231,7 +1245,7 @@ case 10:
 yyg->yy_c_buf_p = yy_cp -= 1;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 300 "src/glsl/glcpp/glcpp-lex.l"
+#line 314 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 }
@@ -1240,7 +1254,7 @@ YY_RULE_SETUP
 	 * Simply pass them through to the main compiler's lexer/parser. */
 case 11:
 YY_RULE_SETUP
-#line 306 "src/glsl/glcpp/glcpp-lex.l"
+#line 320 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	RETURN_STRING_TOKEN (PRAGMA);
@@ -1248,7 +1262,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 311 "src/glsl/glcpp/glcpp-lex.l"
+#line 325 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	RETURN_TOKEN (LINE);
@@ -1257,7 +1271,7 @@ YY_RULE_SETUP
 case 13:
 /* rule 13 can match eol */
 YY_RULE_SETUP
-#line 316 "src/glsl/glcpp/glcpp-lex.l"
+#line 330 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	RETURN_TOKEN_NEVER_SKIP (NEWLINE);
@@ -1267,7 +1281,7 @@ YY_RULE_SETUP
 	 * even when we are otherwise skipping. */
 case 14:
 YY_RULE_SETUP
-#line 323 "src/glsl/glcpp/glcpp-lex.l"
+#line 337 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	yyextra->lexing_directive = 1;
@@ -1277,7 +1291,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 330 "src/glsl/glcpp/glcpp-lex.l"
+#line 344 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	yyextra->lexing_directive = 1;
@@ -1291,7 +1305,7 @@ case 16:
 yyg->yy_c_buf_p = yy_cp = yy_bp + 2;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 337 "src/glsl/glcpp/glcpp-lex.l"
+#line 351 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	yyextra->lexing_directive = 1;
@@ -1305,7 +1319,7 @@ case 17:
 yyg->yy_c_buf_p = yy_cp = yy_bp + 4;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 344 "src/glsl/glcpp/glcpp-lex.l"
+#line 358 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	yyextra->lexing_directive = 1;
@@ -1315,7 +1329,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-#line 351 "src/glsl/glcpp/glcpp-lex.l"
+#line 365 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	yyextra->space_tokens = 0;
@@ -1324,7 +1338,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-#line 357 "src/glsl/glcpp/glcpp-lex.l"
+#line 371 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	yyextra->space_tokens = 0;
@@ -1333,7 +1347,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 363 "src/glsl/glcpp/glcpp-lex.l"
+#line 377 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	RETURN_STRING_TOKEN (ERROR_TOKEN);
@@ -1359,7 +1373,7 @@ YY_RULE_SETUP
 	 */
 case 21:
 YY_RULE_SETUP
-#line 386 "src/glsl/glcpp/glcpp-lex.l"
+#line 400 "src/glsl/glcpp/glcpp-lex.l"
 {
 	if (! parser->skipping) {
 		BEGIN DEFINE;
@@ -1370,7 +1384,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 22:
 YY_RULE_SETUP
-#line 394 "src/glsl/glcpp/glcpp-lex.l"
+#line 408 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	yyextra->space_tokens = 0;
@@ -1379,7 +1393,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 23:
 YY_RULE_SETUP
-#line 400 "src/glsl/glcpp/glcpp-lex.l"
+#line 414 "src/glsl/glcpp/glcpp-lex.l"
 {
 	/* Nothing to do here. Importantly, don't leave the <HASH>
 	 * start condition, since it's legal to have space between the
@@ -1389,7 +1403,7 @@ YY_RULE_SETUP
 /* This will catch any non-directive garbage after a HASH */
 case 24:
 YY_RULE_SETUP
-#line 407 "src/glsl/glcpp/glcpp-lex.l"
+#line 421 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	RETURN_TOKEN (GARBAGE);
@@ -1401,7 +1415,7 @@ case 25:
 yyg->yy_c_buf_p = yy_cp -= 1;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 413 "src/glsl/glcpp/glcpp-lex.l"
+#line 427 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	RETURN_STRING_TOKEN (FUNC_IDENTIFIER);
@@ -1410,7 +1424,7 @@ YY_RULE_SETUP
 /* An identifier not immediately followed by '(' */
 case 26:
 YY_RULE_SETUP
-#line 419 "src/glsl/glcpp/glcpp-lex.l"
+#line 433 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	RETURN_STRING_TOKEN (OBJ_IDENTIFIER);
@@ -1419,7 +1433,7 @@ YY_RULE_SETUP
 /* Whitespace */
 case 27:
 YY_RULE_SETUP
-#line 425 "src/glsl/glcpp/glcpp-lex.l"
+#line 439 "src/glsl/glcpp/glcpp-lex.l"
 {
 	/* Just ignore it. Nothing to do here. */
 }
@@ -1428,7 +1442,7 @@ YY_RULE_SETUP
 case 28:
 /* rule 28 can match eol */
 YY_RULE_SETUP
-#line 430 "src/glsl/glcpp/glcpp-lex.l"
+#line 444 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	glcpp_error(yylloc, yyextra, "#define followed by a non-identifier: %s", yytext);
@@ -1439,7 +1453,7 @@ YY_RULE_SETUP
 	 * space. This is an error. */
 case 29:
 YY_RULE_SETUP
-#line 438 "src/glsl/glcpp/glcpp-lex.l"
+#line 452 "src/glsl/glcpp/glcpp-lex.l"
 {
 	BEGIN INITIAL;
 	glcpp_error(yylloc, yyextra, "#define followed by a non-identifier: %s", yytext);
@@ -1448,98 +1462,98 @@ YY_RULE_SETUP
 	YY_BREAK
 case 30:
 YY_RULE_SETUP
-#line 444 "src/glsl/glcpp/glcpp-lex.l"
+#line 458 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_STRING_TOKEN (INTEGER_STRING);
 }
 	YY_BREAK
 case 31:
 YY_RULE_SETUP
-#line 448 "src/glsl/glcpp/glcpp-lex.l"
+#line 462 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_STRING_TOKEN (INTEGER_STRING);
 }
 	YY_BREAK
 case 32:
 YY_RULE_SETUP
-#line 452 "src/glsl/glcpp/glcpp-lex.l"
+#line 466 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_STRING_TOKEN (INTEGER_STRING);
 }
 	YY_BREAK
 case 33:
 YY_RULE_SETUP
-#line 456 "src/glsl/glcpp/glcpp-lex.l"
+#line 470 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (LEFT_SHIFT);
 }
 	YY_BREAK
 case 34:
 YY_RULE_SETUP
-#line 460 "src/glsl/glcpp/glcpp-lex.l"
+#line 474 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (RIGHT_SHIFT);
 }
 	YY_BREAK
 case 35:
 YY_RULE_SETUP
-#line 464 "src/glsl/glcpp/glcpp-lex.l"
+#line 478 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (LESS_OR_EQUAL);
 }
 	YY_BREAK
 case 36:
 YY_RULE_SETUP
-#line 468 "src/glsl/glcpp/glcpp-lex.l"
+#line 482 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (GREATER_OR_EQUAL);
 }
 	YY_BREAK
 case 37:
 YY_RULE_SETUP
-#line 472 "src/glsl/glcpp/glcpp-lex.l"
+#line 486 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (EQUAL);
 }
 	YY_BREAK
 case 38:
 YY_RULE_SETUP
-#line 476 "src/glsl/glcpp/glcpp-lex.l"
+#line 490 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (NOT_EQUAL);
 }
 	YY_BREAK
 case 39:
 YY_RULE_SETUP
-#line 480 "src/glsl/glcpp/glcpp-lex.l"
+#line 494 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (AND);
 }
 	YY_BREAK
 case 40:
 YY_RULE_SETUP
-#line 484 "src/glsl/glcpp/glcpp-lex.l"
+#line 498 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (OR);
 }
 	YY_BREAK
 case 41:
 YY_RULE_SETUP
-#line 488 "src/glsl/glcpp/glcpp-lex.l"
+#line 502 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (PLUS_PLUS);
 }
 	YY_BREAK
 case 42:
 YY_RULE_SETUP
-#line 492 "src/glsl/glcpp/glcpp-lex.l"
+#line 506 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (MINUS_MINUS);
 }
 	YY_BREAK
 case 43:
 YY_RULE_SETUP
-#line 496 "src/glsl/glcpp/glcpp-lex.l"
+#line 510 "src/glsl/glcpp/glcpp-lex.l"
 {
 	if (! parser->skipping) {
 		if (parser->is_gles)
@@ -1550,42 +1564,42 @@ YY_RULE_SETUP
 	YY_BREAK
 case 44:
 YY_RULE_SETUP
-#line 504 "src/glsl/glcpp/glcpp-lex.l"
+#line 518 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (DEFINED);
 }
 	YY_BREAK
 case 45:
 YY_RULE_SETUP
-#line 508 "src/glsl/glcpp/glcpp-lex.l"
+#line 522 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_STRING_TOKEN (IDENTIFIER);
 }
 	YY_BREAK
 case 46:
 YY_RULE_SETUP
-#line 512 "src/glsl/glcpp/glcpp-lex.l"
+#line 526 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_STRING_TOKEN (OTHER);
 }
 	YY_BREAK
 case 47:
 YY_RULE_SETUP
-#line 516 "src/glsl/glcpp/glcpp-lex.l"
+#line 530 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_TOKEN (yytext[0]);
 }
 	YY_BREAK
 case 48:
 YY_RULE_SETUP
-#line 520 "src/glsl/glcpp/glcpp-lex.l"
+#line 534 "src/glsl/glcpp/glcpp-lex.l"
 {
 	RETURN_STRING_TOKEN (OTHER);
 }
 	YY_BREAK
 case 49:
 YY_RULE_SETUP
-#line 524 "src/glsl/glcpp/glcpp-lex.l"
+#line 538 "src/glsl/glcpp/glcpp-lex.l"
 {
 	if (yyextra->space_tokens) {
 		RETURN_TOKEN (SPACE);
@@ -1597,7 +1611,7 @@ YY_RULE_SETUP
 case 50:
 /* rule 50 can match eol */
 YY_RULE_SETUP
-#line 532 "src/glsl/glcpp/glcpp-lex.l"
+#line 546 "src/glsl/glcpp/glcpp-lex.l"
 {
 	if (parser->commented_newlines) {
 		BEGIN NEWLINE_CATCHUP;
@@ -1615,7 +1629,7 @@ case YY_STATE_EOF(INITIAL):
 case YY_STATE_EOF(COMMENT):
 case YY_STATE_EOF(DEFINE):
 case YY_STATE_EOF(HASH):
-#line 545 "src/glsl/glcpp/glcpp-lex.l"
+#line 559 "src/glsl/glcpp/glcpp-lex.l"
 {
 	if (YY_START == COMMENT)
 		glcpp_error(yylloc, yyextra, "Unterminated comment");
@@ -1631,7 +1645,7 @@ case YY_STATE_EOF(HASH):
 	 * of the preceding patterns to match that input. */
 case 51:
 YY_RULE_SETUP
-#line 559 "src/glsl/glcpp/glcpp-lex.l"
+#line 573 "src/glsl/glcpp/glcpp-lex.l"
 {
 	glcpp_error(yylloc, yyextra, "Internal compiler error: Unexpected character: %s", yytext);
 
@@ -1647,10 +1661,10 @@ YY_RULE_SETUP
 	YY_BREAK
 case 52:
 YY_RULE_SETUP
-#line 572 "src/glsl/glcpp/glcpp-lex.l"
+#line 586 "src/glsl/glcpp/glcpp-lex.l"
 YY_FATAL_ERROR( "flex scanner jammed" );
 	YY_BREAK
-#line 1654 "src/glsl/glcpp/glcpp-lex.c"
+#line 1668 "src/glsl/glcpp/glcpp-lex.c"
 case YY_STATE_EOF(DONE):
 case YY_STATE_EOF(NEWLINE_CATCHUP):
 case YY_STATE_EOF(UNREACHABLE):
@@ -2867,13 +2881,406 @@ void glcpp_free (void * ptr , yyscan_t yyscanner)
 
 #define YYTABLES_NAME "yytables"
 
-#line 572 "src/glsl/glcpp/glcpp-lex.l"
+#line 586 "src/glsl/glcpp/glcpp-lex.l"
 
 
 
 void
-glcpp_lex_set_source_string(glcpp_parser_t *parser, const char *shader)
+glcpp_lex_set_source(glcpp_parser_t *parser, const char *shader, size_t length)
 {
-	glcpp__scan_string(shader,parser->scanner);
+	struct yyguts_t *yyg = (struct yyguts_t *) parser->scanner;
+
+	parser->input = shader;
+	parser->input_length = length;
+	if (YY_CURRENT_BUFFER)
+		glcpp__delete_buffer(YY_CURRENT_BUFFER, parser->scanner);
+	glcpp__switch_to_buffer(glcpp__create_buffer(NULL,YY_BUF_SIZE,parser->scanner),
+			    parser->scanner);
+
+	/* The scanner may have lexed another source to the end before. */
+	BEGIN INITIAL;
+	glcpp_set_lineno(1, parser->scanner);
+	glcpp_set_column(0, parser->scanner);
 }
 
+/* When skipping, "#define" leaves the lexer in the <HASH> start condition,
+ * where a macro name that starts like one of these would be taken for a
+ * directive, or swallow the rest of the line. */
+static bool
+_name_looks_like_directive(const char *name)
+{
+	static const char *const directives[] = {
+		"if", "el", "endif", "define", "error", "pragma", "extension"
+	};
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(directives); i++) {
+		if (strncmp(name, directives[i], strlen(directives[i])) == 0)
+			return true;
+	}
+	return false;
+}
+
+/* How _token_print prints a recorded token of a text line, or NULL if
+ * the parser might do more with the line than print it. */
+static const char *
+_recorded_token_text(const glcpp_recorded_token_t *t, char *c)
+{
+	if (t->type < 256) {
+		c[0] = (char) t->type;
+		c[1] = '\0';
+		return c;
+	}
+
+	switch (t->type) {
+	case IDENTIFIER:
+		if (strcmp(t->str, "__LINE__") == 0 ||
+		    strcmp(t->str, "__FILE__") == 0)
+			return NULL;
+		return t->str;
+	case INTEGER_STRING:
+	case OTHER:
+		return t->str;
+	case SPACE:
+		return " ";
+	case DEFINED:
+		return "defined";
+	case LEFT_SHIFT:
+		return "<<";
+	case RIGHT_SHIFT:
+		return ">>";
+	case LESS_OR_EQUAL:
+		return "<=";
+	case GREATER_OR_EQUAL:
+		return ">=";
+	case EQUAL:
+		return "==";
+	case NOT_EQUAL:
+		return "!=";
+	case AND:
+		return "&&";
+	case OR:
+		return "||";
+	case PLUS_PLUS:
+		return "++";
+	case MINUS_MINUS:
+		return "--";
+	default:
+		return NULL;
+	}
+}
+
+/* Finds the recorded lines that are plain text and what the parser prints
+ * for each, so that glcpp_lex_replay can hand those out whole. */
+static void
+_record_lines(glcpp_token_cache_t *cache)
+{
+	int capacity = 64;
+	int first, i;
+
+	cache->lines = ralloc_array(cache, glcpp_recorded_line_t, capacity);
+	cache->line_count = 0;
+
+	for (first = 0; first < cache->count; first = i + 1) {
+		glcpp_recorded_line_t *line;
+		char *text = ralloc_strdup(cache, "");
+		size_t length = 0, non_space_length = 0;
+		bool plain = true;
+		char c[2];
+
+		for (i = first; cache->tokens[i].type != NEWLINE; i++) {
+			const glcpp_recorded_token_t *t = &cache->tokens[i];
+			const char *str = _recorded_token_text(t, c);
+
+			if (str == NULL) {
+				plain = false;
+				continue;
+			}
+			/* The lexer returns a single SPACE for a run. */
+			if (t->type == SPACE && i > first &&
+			    cache->tokens[i - 1].type == SPACE)
+				continue;
+			ralloc_str_append(&text, str, length, strlen(str));
+			length += strlen(str);
+			if (t->type != SPACE)
+				non_space_length = length;
+		}
+
+		if (! plain || cache->tokens[i].at_eof) {
+			ralloc_free(text);
+			continue;
+		}
+
+		/* Trailing space is trimmed, unless it is all there is. */
+		if (non_space_length > 0)
+			length = non_space_length;
+		text[length] = '\0';
+		ralloc_str_append(&text, "\n", length, 1);
+		length++;
+
+		if (cache->line_count == capacity) {
+			capacity *= 2;
+			cache->lines = reralloc(cache, cache->lines,
+						glcpp_recorded_line_t, capacity);
+		}
+		line = &cache->lines[cache->line_count++];
+		line->first = first;
+		line->end = i + 1;
+		line->text = text;
+		line->length = length;
+	}
+}
+
+/* Lexes all of the parser's input into a list of tokens that
+ * glcpp_lex_replay can hand out again, any number of times.
+ *
+ * Whatever the lexer would do differently depending on the parser's state
+ * is left to the replay: every SPACE token is kept, and each token notes
+ * what the lexer set space_tokens and lexing_directive to on the way, so
+ * that suppressing spaces and skipping can be redone for each parse.
+ *
+ * Returns NULL if skipping could change more than which tokens get dropped
+ * (a '#' that is not the first thing on its line, or a macro name that
+ * looks like a directive) or the source has errors. Such sources have to
+ * be lexed anew each time.
+ */
+glcpp_token_cache_t *
+glcpp_lex_record(glcpp_parser_t *parser, void *ralloc_ctx)
+{
+	glcpp_token_cache_t *cache;
+	YYSTYPE lval;
+	YYLTYPE lloc;
+	int capacity = 256;
+	bool after_define = false;
+
+	cache = ralloc(ralloc_ctx, glcpp_token_cache_t);
+	cache->tokens = ralloc_array(cache, glcpp_recorded_token_t, capacity);
+	cache->count = 0;
+	memset(&lloc, 0, sizeof(lloc));
+
+	for (;;) {
+		glcpp_recorded_token_t *t;
+		int first_non_space = parser->first_non_space_token_this_line;
+		int commented_newlines = parser->commented_newlines;
+		int line_before = glcpp_get_lineno(parser->scanner);
+		int type;
+
+		/* Have the lexer return every space and the NEWLINE at the
+		 * end of the input, and see what it changes. */
+		parser->space_tokens = -1;
+		parser->lexing_directive = -1;
+		parser->last_token_was_space = 0;
+		parser->last_token_was_newline = 0;
+		lval.str = NULL;
+
+		type = glcpp_lex(&lval, &lloc, parser->scanner);
+		if (type == 0)
+			break;
+
+		if (type == HASH_TOKEN && ! first_non_space)
+			goto unreplayable;
+		if (after_define && type != SPACE) {
+			if ((type != OBJ_IDENTIFIER && type != FUNC_IDENTIFIER) ||
+			    _name_looks_like_directive(lval.str))
+				goto unreplayable;
+			after_define = false;
+		}
+		if (type == DEFINE_TOKEN)
+			after_define = true;
+
+		if (cache->count == capacity) {
+			capacity *= 2;
+			cache->tokens = reralloc(cache, cache->tokens,
+						 glcpp_recorded_token_t,
+						 capacity);
+		}
+		t = &cache->tokens[cache->count++];
+		t->type = type;
+		t->location = lloc;
+		if (type == NEWLINE &&
+		    parser->commented_newlines == commented_newlines - 1)
+			t->line_before = -1;
+		else
+			t->line_before = line_before;
+		t->space_tokens = parser->space_tokens;
+		t->lexing_directive = parser->lexing_directive;
+		t->never_skip = type == NEWLINE || type == HASH_TOKEN ||
+				type == IF || type == IFDEF || type == IFNDEF ||
+				type == ELIF || type == ELSE || type == ENDIF;
+		t->at_eof = false;
+		t->str = lval.str ? ralloc_strdup(cache, lval.str) : NULL;
+	}
+
+	if (parser->error)
+		goto unreplayable;
+
+	/* If the input ends right after a macro name, skipping would make
+	 * the lexer end up somewhere else in the name. */
+	if (cache->count >= 2 &&
+	    (cache->tokens[cache->count - 2].type == OBJ_IDENTIFIER ||
+	     cache->tokens[cache->count - 2].type == FUNC_IDENTIFIER))
+		goto unreplayable;
+
+	/* The last one is the NEWLINE the lexer adds at the end, which is
+	 * dropped like any other token when skipping. */
+	assert(cache->count > 0);
+	cache->tokens[cache->count - 1].never_skip = false;
+	cache->tokens[cache->count - 1].at_eof = true;
+	cache->end_location = lloc;
+
+	_record_lines(cache);
+
+	return cache;
+
+unreplayable:
+	ralloc_free(cache);
+	return NULL;
+}
+
+/* Same as what the lexer sets and the parser prints for the whole of a
+ * plain text line, if the next tokens are one and the parser is between
+ * lines, in which case it returns true. */
+static bool
+_replay_plain_line(glcpp_parser_t *parser, YYLTYPE *llocp)
+{
+	const glcpp_token_cache_t *cache = parser->replay;
+	const glcpp_recorded_line_t *line;
+	int i;
+
+	if (parser->replay_next > 0 && ! parser->last_token_was_newline)
+		return false;
+	if (parser->newline_as_space)
+		return false;
+
+	while (parser->replay_line < cache->line_count &&
+	       cache->lines[parser->replay_line].first < parser->replay_next)
+		parser->replay_line++;
+	if (parser->replay_line == cache->line_count)
+		return false;
+	line = &cache->lines[parser->replay_line];
+	if (line->first != parser->replay_next)
+		return false;
+
+	if (! parser->skipping) {
+		if (parser->space_tokens != 1)
+			return false;
+		for (i = line->first; i < line->end; i++) {
+			const glcpp_recorded_token_t *t = &cache->tokens[i];
+
+			if (t->type == IDENTIFIER &&
+			    hash_table_find(parser->defines, t->str))
+				return false;
+		}
+	}
+
+	for (i = line->first; i < line->end; i++) {
+		const glcpp_recorded_token_t *t = &cache->tokens[i];
+
+		if (t->line_before >= 0) {
+			if (parser->has_new_line_number)
+				parser->replay_line_delta =
+					parser->new_line_number - t->line_before;
+			if (parser->has_new_source_number)
+				llocp->source = parser->new_source_number;
+			parser->has_new_line_number = 0;
+			parser->has_new_source_number = 0;
+		}
+		if (t->space_tokens >= 0)
+			parser->space_tokens = t->space_tokens;
+		if (t->lexing_directive >= 0)
+			parser->lexing_directive = t->lexing_directive;
+	}
+
+	/* A skipped line leaves just its NEWLINE, an empty text_line. */
+	if (parser->skipping) {
+		ralloc_str_append(&parser->output, "\n",
+				  parser->output_length, 1);
+		parser->output_length++;
+	} else {
+		ralloc_str_append(&parser->output, line->text,
+				  parser->output_length, line->length);
+		parser->output_length += line->length;
+	}
+
+	glcpp_lex_update_state_per_token(parser, NEWLINE);
+	parser->replay_next = line->end;
+	parser->replay_line++;
+
+	return true;
+}
+
+/* Hands out the tokens that glcpp_lex_record got from a source in place of
+ * glcpp_lex, skipping them, suppressing spaces and renumbering lines after
+ * a #line exactly as the lexer does while lexing that source. */
+int
+glcpp_lex_replay(YYSTYPE *lvalp, YYLTYPE *llocp, glcpp_parser_t *parser)
+{
+	const glcpp_token_cache_t *cache = parser->replay;
+
+	do {
+		/* See the top of the rules section. */
+		if (parser->skip_stack &&
+		    parser->skip_stack->type != SKIP_NO_SKIP &&
+		    ! parser->lexing_directive)
+		{
+			parser->skipping = 1;
+		} else {
+			parser->skipping = 0;
+		}
+	} while (_replay_plain_line(parser, llocp));
+
+	while (parser->replay_next < cache->count) {
+		const glcpp_recorded_token_t *t;
+
+		t = &cache->tokens[parser->replay_next++];
+
+		/* What YY_USER_ACTION does when matching the first rule. */
+		if (t->line_before >= 0) {
+			if (parser->has_new_line_number)
+				parser->replay_line_delta =
+					parser->new_line_number - t->line_before;
+			if (parser->has_new_source_number)
+				llocp->source = parser->new_source_number;
+			parser->has_new_line_number = 0;
+			parser->has_new_source_number = 0;
+		}
+
+		if (t->space_tokens >= 0)
+			parser->space_tokens = t->space_tokens;
+		if (t->lexing_directive >= 0)
+			parser->lexing_directive = t->lexing_directive;
+
+		if (t->type == SPACE && ! parser->space_tokens)
+			continue;
+		if (parser->skipping && ! t->never_skip)
+			continue;
+		if (t->at_eof && parser->last_token_was_newline)
+			continue;
+		if (! glcpp_lex_update_state_per_token(parser, t->type))
+			continue;
+
+		llocp->first_line = t->location.first_line +
+				     parser->replay_line_delta;
+		llocp->first_column = t->location.first_column;
+		llocp->last_line = t->location.last_line +
+				    parser->replay_line_delta;
+		llocp->last_column = t->location.last_column;
+
+		if (t->type == PASTE && parser->is_gles)
+			glcpp_error(llocp, parser, "Token pasting (##) is illegal in GLES");
+		if (t->str)
+			lvalp->str = ralloc_strdup(parser, t->str);
+
+		return t->type;
+	}
+
+	/* Where the lexer was when running out of input. */
+	llocp->first_line = cache->end_location.first_line +
+			    parser->replay_line_delta;
+	llocp->first_column = cache->end_location.first_column;
+	llocp->last_line = cache->end_location.last_line +
+			   parser->replay_line_delta;
+	llocp->last_column = cache->end_location.last_column;
+
+	return 0;
+}
@@ -108,6 +108,9 @@ _parser_active_list_pop (glcpp_parser_t *parser);
 static int
 _parser_active_list_contains (glcpp_parser_t *parser, const char *identifier);
 
+static void
+_string_append (char **out, size_t *len, const char *str, size_t n);
+
 typedef enum {
 	EXPANSION_MODE_IGNORE_DEFINED,
 	EXPANSION_MODE_EVALUATE_DEFINED
@@ -212,7 +215,7 @@ line:
 |	SPACE control_line
 |	text_line {
 		_glcpp_parser_print_expanded_token_list (parser, $1);
-		ralloc_asprintf_rewrite_tail (&parser->output, &parser->output_length, "\n");
+		_string_append (&parser->output, &parser->output_length, "\n", 1);
 		ralloc_free ($1);
 	}
 |	expanded_line
@@ -263,7 +266,7 @@ define:
 
 control_line:
 	control_line_success {
-		ralloc_asprintf_rewrite_tail (&parser->output, &parser->output_length, "\n");
+		_string_append (&parser->output, &parser->output_length, "\n", 1);
 	}
 |	control_line_error
 |	HASH_TOKEN LINE {
@@ -1109,11 +1112,21 @@ _token_list_equal_ignoring_space (token_list_t *a, token_list_t *b)
 	return 1;
 }
 
+/* Appends n bytes of str to the string *out of length *len.  Output is
+ * built from many small pieces, so this skips the printf machinery. */
+static void
+_string_append (char **out, size_t *len, const char *str, size_t n)
+{
+	ralloc_str_append (out, str, *len, n);
+	*len += n;
+}
+
 static void
 _token_print (char **out, size_t *len, token_t *token)
 {
 	if (token->type < 256) {
-		ralloc_asprintf_rewrite_tail (out, len, "%c", token->type);
+		char c = (char) token->type;
+		_string_append (out, len, &c, 1);
 		return;
 	}
 
@@ -1124,46 +1137,46 @@ _token_print (char **out, size_t *len, token_t *token)
 	case IDENTIFIER:
 	case INTEGER_STRING:
 	case OTHER:
-		ralloc_asprintf_rewrite_tail (out, len, "%s", token->value.str);
+		_string_append (out, len, token->value.str, strlen (token->value.str));
 		break;
 	case SPACE:
-		ralloc_asprintf_rewrite_tail (out, len, " ");
+		_string_append (out, len, " ", 1);
 		break;
 	case LEFT_SHIFT:
-		ralloc_asprintf_rewrite_tail (out, len, "<<");
+		_string_append (out, len, "<<", 2);
 		break;
 	case RIGHT_SHIFT:
-		ralloc_asprintf_rewrite_tail (out, len, ">>");
+		_string_append (out, len, ">>", 2);
 		break;
 	case LESS_OR_EQUAL:
-		ralloc_asprintf_rewrite_tail (out, len, "<=");
+		_string_append (out, len, "<=", 2);
 		break;
 	case GREATER_OR_EQUAL:
-		ralloc_asprintf_rewrite_tail (out, len, ">=");
+		_string_append (out, len, ">=", 2);
 		break;
 	case EQUAL:
-		ralloc_asprintf_rewrite_tail (out, len, "==");
+		_string_append (out, len, "==", 2);
 		break;
 	case NOT_EQUAL:
-		ralloc_asprintf_rewrite_tail (out, len, "!=");
+		_string_append (out, len, "!=", 2);
 		break;
 	case AND:
-		ralloc_asprintf_rewrite_tail (out, len, "&&");
+		_string_append (out, len, "&&", 2);
 		break;
 	case OR:
-		ralloc_asprintf_rewrite_tail (out, len, "||");
+		_string_append (out, len, "||", 2);
 		break;
 	case PASTE:
-		ralloc_asprintf_rewrite_tail (out, len, "##");
+		_string_append (out, len, "##", 2);
 		break;
         case PLUS_PLUS:
-		ralloc_asprintf_rewrite_tail (out, len, "++");
+		_string_append (out, len, "++", 2);
 		break;
         case MINUS_MINUS:
-		ralloc_asprintf_rewrite_tail (out, len, "--");
+		_string_append (out, len, "--", 2);
 		break;
 	case DEFINED:
-		ralloc_asprintf_rewrite_tail (out, len, "defined");
+		_string_append (out, len, "defined", 7);
 		break;
 	case PLACEHOLDER:
 		/* Nothing to print. */
@@ -1340,7 +1353,9 @@ glcpp_parser_create (const struct gl_extensions *extensions, gl_api api)
 {
 	glcpp_parser_t *parser;
 
-	parser = ralloc (NULL, glcpp_parser_t);
+	/* Tokens, macros and the output all die with the parser, so it gets
+	 * an arena of its own. */
+	parser = ralloc (ralloc_arena_context (NULL), glcpp_parser_t);
 
 	glcpp_lex_init_extra (parser, &parser->scanner);
 	parser->defines = hash_table_ctor (32, hash_table_string_hash,
@@ -1362,6 +1377,13 @@ glcpp_parser_create (const struct gl_extensions *extensions, gl_api api)
 	parser->lex_from_list = NULL;
 	parser->lex_from_node = NULL;
 
+	parser->input = NULL;
+	parser->input_length = 0;
+	parser->replay = NULL;
+	parser->replay_next = 0;
+	parser->replay_line = 0;
+	parser->replay_line_delta = 0;
+
 	parser->output = ralloc_strdup(parser, "");
 	parser->output_length = 0;
 	parser->info_log = ralloc_strdup(parser, "");
@@ -1385,7 +1407,7 @@ glcpp_parser_destroy (glcpp_parser_t *parser)
 {
 	glcpp_lex_destroy (parser->scanner);
 	hash_table_dtor (parser->defines);
-	ralloc_free (parser);
+	ralloc_free (ralloc_parent (parser));
 }
 
 typedef enum function_status
@@ -2187,6 +2209,66 @@ _define_function_macro (glcpp_parser_t *parser,
 	hash_table_insert (parser->defines, macro, identifier);
 }
 
+typedef struct copy_defines {
+	void *ctx;
+	struct hash_table *defines;
+} copy_defines_t;
+
+static void
+_copy_define (const void *key, void *data, void *closure)
+{
+	copy_defines_t *copy = closure;
+	macro_t *macro = data, *macro_copy;
+	token_node_t *node;
+
+	macro_copy = ralloc (copy->ctx, macro_t);
+	macro_copy->is_function = macro->is_function;
+	macro_copy->identifier = ralloc_strdup (macro_copy, macro->identifier);
+
+	macro_copy->parameters = NULL;
+	if (macro->parameters) {
+		string_node_t *parameter;
+
+		macro_copy->parameters = _string_list_create (macro_copy);
+		for (parameter = macro->parameters->head; parameter;
+		     parameter = parameter->next)
+			_string_list_append_item (macro_copy->parameters,
+						  parameter->str);
+	}
+
+	/* Unlike _token_list_copy, with copies of the strings too, so the
+	 * copy can outlive the parser it comes from. */
+	macro_copy->replacements = NULL;
+	if (macro->replacements) {
+		macro_copy->replacements = _token_list_create (macro_copy);
+		for (node = macro->replacements->head; node; node = node->next) {
+			token_t *token = ralloc (macro_copy->replacements,
+						 token_t);
+
+			*token = *node->token;
+			if (token->type == IDENTIFIER ||
+			    token->type == INTEGER_STRING ||
+			    token->type == OTHER)
+				token->value.str = ralloc_strdup (token,
+								  token->value.str);
+			_token_list_append (macro_copy->replacements, token);
+		}
+	}
+
+	hash_table_replace (copy->defines, macro_copy, macro_copy->identifier);
+}
+
+/* Copies all macros in 'from' into 'to', allocated out of 'ctx'. */
+void
+glcpp_copy_defines (void *ctx, struct hash_table *to, struct hash_table *from)
+{
+	copy_defines_t copy;
+
+	copy.ctx = ctx;
+	copy.defines = to;
+	hash_table_call_foreach (from, _copy_define, &copy);
+}
+
 static int
 glcpp_parser_lex (YYSTYPE *yylval, YYLTYPE *yylloc, glcpp_parser_t *parser)
 {
@@ -2194,7 +2276,10 @@ glcpp_parser_lex (YYSTYPE *yylval, YYLTYPE *yylloc, glcpp_parser_t *parser)
 	int ret;
 
 	if (parser->lex_from_list == NULL) {
-		ret = glcpp_lex (yylval, yylloc, parser->scanner);
+		if (parser->replay)
+			ret = glcpp_lex_replay (yylval, yylloc, parser);
+		else
+			ret = glcpp_lex (yylval, yylloc, parser->scanner);
 
 		/* XXX: This ugly block of code exists for the sole
 		 * purpose of converting a NEWLINE token into a SPACE
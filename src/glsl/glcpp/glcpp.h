@@ -167,6 +167,51 @@ typedef struct skip_node {
 	struct skip_node *next;
 } skip_node_t;
 
+/* A token as glcpp_lex_record got it from the lexer. */
+typedef struct glcpp_recorded_token {
+	int type;
+	YYLTYPE location;
+	/* yylineno when the lexer started on this token, which a #line
+	 * right before it renumbers from; -1 for the NEWLINEs standing in
+	 * for commented-out ones, which don't come from any input. */
+	int line_before;
+	/* What the lexer set these to on the way, or -1 if nothing. */
+	signed char space_tokens;
+	signed char lexing_directive;
+	bool never_skip;
+	/* The NEWLINE added at the end of input not ending in one. */
+	bool at_eof;
+	const char *str;
+} glcpp_recorded_token_t;
+
+/* A line of recorded tokens that is plain text: no directive, no
+ * __LINE__ or __FILE__, and nothing else the parser does anything with
+ * besides expanding macros. */
+typedef struct glcpp_recorded_line {
+	int first;	/* its first token */
+	int end;	/* the token after its NEWLINE */
+	/* What the parser prints for it if none of its identifiers is a
+	 * macro, newline included. */
+	const char *text;
+	size_t length;
+} glcpp_recorded_line_t;
+
+typedef struct glcpp_token_cache {
+	glcpp_recorded_token_t *tokens;
+	int count;
+	glcpp_recorded_line_t *lines;
+	int line_count;
+	/* Where the lexer was when running out of input. */
+	YYLTYPE end_location;
+} glcpp_token_cache_t;
+
+/* The macros defined at the end of a prelude, and whether it is GLSL ES,
+ * for preprocessing shaders as following it; see glcpp_preprocess_prelude. */
+typedef struct glcpp_prelude {
+	struct hash_table *defines;
+	bool is_gles;
+} glcpp_prelude_t;
+
 typedef struct active_list {
 	const char *identifier;
 	token_node_t *marker;
@@ -190,6 +235,16 @@ struct glcpp_parser {
 	int skipping;
 	token_list_t *lex_from_list;
 	token_node_t *lex_from_node;
+	/* What the lexer has yet to read of the shader, which is not copied
+	 * and need not be NUL-terminated; see glcpp_lex_set_source. */
+	const char *input;
+	size_t input_length;
+	/* Recorded tokens to parse instead of lexing the input, and where
+	 * glcpp_lex_replay is in them. */
+	const glcpp_token_cache_t *replay;
+	int replay_next;
+	int replay_line;
+	int replay_line_delta;
 	char *output;
 	char *info_log;
 	size_t output_length;
@@ -219,10 +274,38 @@ glcpp_parser_destroy (glcpp_parser_t *parser);
 void
 glcpp_parser_resolve_implicit_version(glcpp_parser_t *parser);
 
+void
+glcpp_copy_defines (void *ctx, struct hash_table *to, struct hash_table *from);
+
 int
 glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
 	   const struct gl_extensions *extensions, struct gl_context *g_ctx);
 
+int
+glcpp_preprocess_n(void *ralloc_ctx, const char **shader, size_t length,
+		   char **info_log, const struct gl_extensions *extensions,
+		   struct gl_context *gl_ctx);
+
+glcpp_token_cache_t *
+glcpp_token_cache_create(void *ralloc_ctx, const char *shader, size_t length,
+			 struct gl_context *gl_ctx);
+
+int
+glcpp_preprocess_prelude(void *ralloc_ctx, const char **shader, size_t length,
+			 char **info_log,
+			 const struct gl_extensions *extensions,
+			 struct gl_context *gl_ctx,
+			 glcpp_prelude_t **prelude);
+
+int
+glcpp_preprocess_variant(void *ralloc_ctx, const char **shader, size_t length,
+			 const glcpp_prelude_t *prelude,
+			 const char *defines,
+			 const glcpp_token_cache_t *tokens,
+			 char **info_log,
+			 const struct gl_extensions *extensions,
+			 struct gl_context *gl_ctx);
+
 /* Functions for writing to the info log */
 
 void
@@ -237,11 +320,17 @@ int
 glcpp_lex_init_extra (glcpp_parser_t *parser, yyscan_t* scanner);
 
 void
-glcpp_lex_set_source_string(glcpp_parser_t *parser, const char *shader);
+glcpp_lex_set_source(glcpp_parser_t *parser, const char *shader, size_t length);
 
 int
 glcpp_lex (YYSTYPE *lvalp, YYLTYPE *llocp, yyscan_t scanner);
 
+glcpp_token_cache_t *
+glcpp_lex_record(glcpp_parser_t *parser, void *ralloc_ctx);
+
+int
+glcpp_lex_replay(YYSTYPE *lvalp, YYLTYPE *llocp, glcpp_parser_t *parser);
+
 int
 glcpp_lex_destroy (yyscan_t scanner);
 
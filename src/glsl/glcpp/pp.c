@@ -72,6 +72,7 @@ glcpp_warning (YYLTYPE *locp, glcpp_parser_t *parser, const char *fmt, ...)
 
 /* Given str, (that's expected to start with a newline terminator of some
  * sort), return a pointer to the first character in str after the newline.
+ * str ends at end.
  *
  * A newline terminator can be any of the following sequences:
  *
@@ -83,41 +84,68 @@ glcpp_warning (YYLTYPE *locp, glcpp_parser_t *parser, const char *fmt, ...)
  * And the longest such sequence will be skipped.
  */
 static const char *
-skip_newline (const char *str)
+skip_newline (const char *str, const char *end)
 {
 	const char *ret = str;
 
 	if (ret == NULL)
 		return ret;
 
-	if (*ret == '\0')
+	if (ret == end)
 		return ret;
 
 	if (*ret == '\r') {
 		ret++;
-		if (*ret && *ret == '\n')
+		if (ret < end && *ret == '\n')
 			ret++;
 	} else if (*ret == '\n') {
 		ret++;
-		if (*ret && *ret == '\r')
+		if (ret < end && *ret == '\r')
 			ret++;
 	}
 
 	return ret;
 }
 
+/* Like strchr, for the part of a string before end. */
+static const char *
+find_char (const char *str, const char *end, char c)
+{
+	return (const char *) memchr(str, c, end - str);
+}
+
 /* Remove any line continuation characters in the shader, (whether in
- * preprocessing directives or in GLSL code).
+ * preprocessing directives or in GLSL code).  The shader has *length
+ * characters and need not be NUL-terminated; it's returned as it is when
+ * there's nothing to remove, otherwise a copy is, and *length updated.
  */
-static char *
-remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
+static const char *
+remove_line_continuations(glcpp_parser_t *ctx, const char *shader,
+			  size_t *length)
 {
-	char *clean = ralloc_strdup(ctx, "");
+	char *clean;
+	size_t clean_length = 0;
+	const char *end = shader + *length;
 	const char *backslash, *newline, *search_start;
         const char *cr, *lf;
         char newline_separator[3];
 	int collapsed_newlines = 0;
 
+	/* Most shaders have no line continuations at all; leave those alone
+	 * rather than copy them.
+	 */
+	search_start = shader;
+	while (true) {
+		backslash = find_char(search_start, end, '\\');
+		if (backslash == NULL)
+			return shader;
+		if (backslash + 1 < end &&
+		    (backslash[1] == '\r' || backslash[1] == '\n'))
+			break;
+		search_start = backslash + 1;
+	}
+
+	clean = ralloc_strdup(ctx, "");
 	search_start = shader;
 
 	/* Determine what flavor of newlines this shader is using. GLSL
@@ -138,8 +166,8 @@ remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
 	 * examining the first encountered newline terminator, and using the
 	 * same terminator for any newlines we insert.
 	 */
-	cr = strchr(search_start, '\r');
-	lf = strchr(search_start, '\n');
+	cr = find_char(search_start, end, '\r');
+	lf = find_char(search_start, end, '\n');
 
 	newline_separator[0] = '\n';
 	newline_separator[1] = '\0';
@@ -158,7 +186,7 @@ remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
 	}
 
 	while (true) {
-		backslash = strchr(search_start, '\\');
+		backslash = find_char(search_start, end, '\\');
 
 		/* If we have previously collapsed any line-continuations,
 		 * then we want to insert additional newlines at the next
@@ -166,8 +194,8 @@ remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
 		 * line numbers.
 		 */
 		if (collapsed_newlines) {
-			cr = strchr (search_start, '\r');
-			lf = strchr (search_start, '\n');
+			cr = find_char (search_start, end, '\r');
+			lf = find_char (search_start, end, '\n');
 			if (cr && lf)
 				newline = cr < lf ? cr : lf;
 			else if (cr)
@@ -177,13 +205,17 @@ remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
 			if (newline &&
 			    (backslash == NULL || newline < backslash))
 			{
-				ralloc_strncat(&clean, shader,
-					       newline - shader + 1);
+				ralloc_str_append(&clean, shader, clean_length,
+						  newline - shader + 1);
+				clean_length += newline - shader + 1;
 				while (collapsed_newlines) {
-					ralloc_strcat(&clean, newline_separator);
+					ralloc_str_append(&clean, newline_separator,
+							  clean_length,
+							  strlen(newline_separator));
+					clean_length += strlen(newline_separator);
 					collapsed_newlines--;
 				}
-				shader = skip_newline (newline);
+				shader = skip_newline (newline, end);
 				search_start = shader;
 			}
 		}
@@ -198,31 +230,131 @@ remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
 		 * advance the shader pointer to the character after the
 		 * newline.
 		 */
-		if (backslash[1] == '\r' || backslash[1] == '\n')
+		if (backslash + 1 < end &&
+		    (backslash[1] == '\r' || backslash[1] == '\n'))
 		{
 			collapsed_newlines++;
-			ralloc_strncat(&clean, shader, backslash - shader);
-			shader = skip_newline (backslash + 1);
+			ralloc_str_append(&clean, shader, clean_length,
+					  backslash - shader);
+			clean_length += backslash - shader;
+			shader = skip_newline (backslash + 1, end);
 			search_start = shader;
 		}
 	}
 
-	ralloc_strcat(&clean, shader);
+	ralloc_str_append(&clean, shader, clean_length, end - shader);
+	clean_length += end - shader;
 
+	*length = clean_length;
 	return clean;
 }
 
 int
 glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
 	   const struct gl_extensions *extensions, struct gl_context *gl_ctx)
+{
+	return glcpp_preprocess_n(ralloc_ctx, shader, strlen(*shader), info_log,
+				  extensions, gl_ctx);
+}
+
+int
+glcpp_preprocess_n(void *ralloc_ctx, const char **shader, size_t length,
+		   char **info_log, const struct gl_extensions *extensions,
+		   struct gl_context *gl_ctx)
+{
+	return glcpp_preprocess_variant(ralloc_ctx, shader, length, NULL, NULL,
+					NULL, info_log, extensions, gl_ctx);
+}
+
+/* Lexes a shader once for any number of glcpp_preprocess_variant calls.
+ * Returns NULL when the shader can't be preprocessed that way; see
+ * glcpp_lex_record.
+ */
+glcpp_token_cache_t *
+glcpp_token_cache_create(void *ralloc_ctx, const char *shader, size_t length,
+			 struct gl_context *gl_ctx)
+{
+	glcpp_token_cache_t *tokens;
+	glcpp_parser_t *parser = glcpp_parser_create (NULL, gl_ctx->API);
+
+	if (! gl_ctx->Const.DisableGLSLLineContinuations)
+		shader = remove_line_continuations(parser, shader, &length);
+
+	glcpp_lex_set_source (parser, shader, length);
+	tokens = glcpp_lex_record (parser, ralloc_ctx);
+
+	glcpp_parser_destroy (parser);
+	return tokens;
+}
+
+/* Puts the parser back to where it was before lexing and parsing
+ * anything, except for the macros it knows. */
+static void
+restart_parser(glcpp_parser_t *parser)
+{
+	parser->lexing_directive = 0;
+	parser->space_tokens = 1;
+	parser->last_token_was_newline = 0;
+	parser->last_token_was_space = 0;
+	parser->first_non_space_token_this_line = 1;
+	parser->newline_as_space = 0;
+	parser->in_control_line = 0;
+	parser->paren_count = 0;
+	parser->commented_newlines = 0;
+	parser->skip_stack = NULL;
+	parser->has_new_line_number = 0;
+	parser->has_new_source_number = 0;
+	parser->output[0] = '\0';
+	parser->output_length = 0;
+}
+
+static void
+destroy_prelude(void *prelude)
+{
+	hash_table_dtor(((glcpp_prelude_t *) prelude)->defines);
+}
+
+static int
+preprocess(void *ralloc_ctx, const char **shader, size_t length,
+	   const glcpp_prelude_t *prelude,
+	   const char *defines,
+	   const glcpp_token_cache_t *tokens,
+	   char **info_log,
+	   const struct gl_extensions *extensions,
+	   struct gl_context *gl_ctx,
+	   glcpp_prelude_t **prelude_out)
 {
 	int errors;
 	glcpp_parser_t *parser = glcpp_parser_create (extensions, gl_ctx->API);
 
-	if (! gl_ctx->Const.DisableGLSLLineContinuations)
-		*shader = remove_line_continuations(parser, *shader);
+	if (prelude) {
+		glcpp_copy_defines (parser, parser->defines, prelude->defines);
+		parser->is_gles = prelude->is_gles;
+	}
+
+	if (defines && *defines) {
+		/* Nothing but the prelude or the shader itself decides on the
+		 * #version. */
+		parser->version_resolved = true;
+		glcpp_lex_set_source (parser, defines, strlen(defines));
+		glcpp_parser_parse (parser);
+		if (parser->skip_stack)
+			glcpp_error (&parser->skip_stack->loc, parser,
+				     "Unterminated #if\n");
+		restart_parser (parser);
+	}
 
-	glcpp_lex_set_source_string (parser, *shader);
+	/* A prelude has had its #version already. */
+	parser->version_resolved = prelude != NULL;
+
+	if (tokens) {
+		parser->replay = tokens;
+	} else {
+		if (! gl_ctx->Const.DisableGLSLLineContinuations)
+			*shader = remove_line_continuations(parser, *shader,
+							    &length);
+		glcpp_lex_set_source (parser, *shader, length);
+	}
 
 	glcpp_parser_parse (parser);
 
@@ -233,10 +365,70 @@ glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
 
 	ralloc_strcat(info_log, parser->info_log);
 
-	ralloc_steal(ralloc_ctx, parser->output);
-	*shader = parser->output;
+	/* The parser's memory is an arena, so the output is copied out of it
+	 * rather than stolen.  It ends in two NULs, which lets the GLSL lexer
+	 * scan it in place (see _mesa_glsl_lexer_ctor_in_place). */
+	char *output = ralloc_array(ralloc_ctx, char, parser->output_length + 2);
+	memcpy(output, parser->output, parser->output_length);
+	output[parser->output_length] = '\0';
+	output[parser->output_length + 1] = '\0';
+	*shader = output;
 
 	errors = parser->error;
+
+	/* So are the macros, which is why they are copied out too. */
+	if (prelude_out && ! errors) {
+		glcpp_prelude_t *p = ralloc(ralloc_ctx, glcpp_prelude_t);
+
+		p->defines = hash_table_ctor(32, hash_table_string_hash,
+					     hash_table_string_compare);
+		ralloc_set_destructor(p, destroy_prelude);
+		glcpp_copy_defines (p, p->defines, parser->defines);
+		p->is_gles = parser->is_gles;
+		*prelude_out = p;
+	}
+
 	glcpp_parser_destroy (parser);
 	return errors;
 }
+
+/* Preprocesses a prelude: source that any number of shaders are to be
+ * preprocessed as following, as if pasted in front of each of them.  On
+ * success, *prelude is set to what glcpp_preprocess_variant needs to carry
+ * on after it, allocated out of ralloc_ctx; otherwise it is set to NULL.
+ */
+int
+glcpp_preprocess_prelude(void *ralloc_ctx, const char **shader, size_t length,
+			 char **info_log,
+			 const struct gl_extensions *extensions,
+			 struct gl_context *gl_ctx,
+			 glcpp_prelude_t **prelude)
+{
+	*prelude = NULL;
+	return preprocess(ralloc_ctx, shader, length, NULL, NULL, NULL,
+			  info_log, extensions, gl_ctx, prelude);
+}
+
+/* Preprocesses a shader with the macros of \c defines, a bunch of #define
+ * lines, defined up front.  That is much like pasting them in front of the
+ * shader, except that they neither move its #version off the first line
+ * nor change its line numbers.
+ *
+ * If a prelude is given, the shader is preprocessed as following it, with
+ * its macros and #version, and \c defines after those.
+ *
+ * If the shader's tokens are given, they are parsed instead of the length
+ * characters at *shader, which then aren't looked at.
+ */
+int
+glcpp_preprocess_variant(void *ralloc_ctx, const char **shader, size_t length,
+			 const glcpp_prelude_t *prelude,
+			 const char *defines,
+			 const glcpp_token_cache_t *tokens,
+			 char **info_log,
+			 const struct gl_extensions *extensions,
+			 struct gl_context *gl_ctx)
+{
+	return preprocess(ralloc_ctx, shader, length, prelude, defines, tokens,
+			  info_log, extensions, gl_ctx, NULL);
+}
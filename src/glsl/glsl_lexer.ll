@@ -51,6 +51,19 @@ static int classify_identifier(struct _mesa_glsl_parse_state *, const char *);
 
 #define YY_USER_INIT yylineno = 0; yycolumn = 0;
 
+/* Source set up by _mesa_glsl_lexer_ctor_n is read straight from where the
+ * caller has it, a buffer at a time, rather than from a full copy. */
+#define YY_INPUT(buf, result, max_size)				\
+   do {								\
+      size_t n = yyextra->lexer_input_length;			\
+      if (n > (size_t) (max_size))				\
+	 n = (size_t) (max_size);				\
+      memcpy(buf, yyextra->lexer_input, n);			\
+      yyextra->lexer_input += n;				\
+      yyextra->lexer_input_length -= n;				\
+      result = n;						\
+   } while (0)
+
 /* A macro for handling reserved words and keywords across language versions.
  *
  * Certain words start out as identifiers, become reserved words in
@@ -584,9 +597,28 @@ classify_identifier(struct _mesa_glsl_parse_state *state, const char *name)
 
 void
 _mesa_glsl_lexer_ctor(struct _mesa_glsl_parse_state *state, const char *string)
+{
+   _mesa_glsl_lexer_ctor_n(state, string, strlen(string));
+}
+
+void
+_mesa_glsl_lexer_ctor_n(struct _mesa_glsl_parse_state *state,
+                        const char *string, size_t length)
+{
+   yylex_init_extra(state, & state->scanner);
+   state->lexer_input = string;
+   state->lexer_input_length = length;
+   yy_switch_to_buffer(yy_create_buffer(NULL, YY_BUF_SIZE, state->scanner),
+                       state->scanner);
+}
+
+void
+_mesa_glsl_lexer_ctor_in_place(struct _mesa_glsl_parse_state *state,
+                               char *string)
 {
    yylex_init_extra(state, & state->scanner);
-   yy_scan_string(string, state->scanner);
+   /* flex scans a buffer that ends in two NULs without copying it first. */
+   yy_scan_buffer(string, strlen(string) + 2, state->scanner);
 }
 
 void
@@ -7,10 +7,23 @@
 #include "ir_print_glsl_visitor.h"
 #include "ir_print_visitor.h"
 #include "ir_stats.h"
+#include "ir_variable_refcount.h"
 #include "loop_analysis.h"
 #include "program.h"
 #include "linker.h"
 #include "standalone_scaffolding.h"
+#include "c11/threads.h"
+#include "util/blob.h"
+#include "util/hash_table.h"
+#include "util/mesa-sha1.h"
+#include <stdio.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 
 extern "C" struct gl_shader *
@@ -67,6 +80,26 @@ initialize_mesa_context(struct gl_context *ctx, glslopt_target api)
 	}
 
 
+   // Loop unrolling budgets. Many ES2 GPUs can't loop dynamically, and unroll
+   // (or reject) loops themselves, so unroll more there. Elsewhere looping is
+   // cheap; only partially unroll loops whose body is small next to the loop
+   // test and branch, instead of growing code by whole loops.
+   for (int i = 0; i < MESA_SHADER_STAGES; ++i)
+   {
+      gl_shader_compiler_options& options = ctx->Const.ShaderCompilerOptions[i];
+      if (api == kGlslTargetOpenGLES20)
+      {
+         options.MaxUnrollSizePerIteration = 50;
+         options.MaxUnrollTemps = 256;
+      }
+      else
+      {
+         options.MaxUnrollFactor = 4;
+         options.MinUnrollGain = 15;
+      }
+      options.MaxInlineGrowth = kGlslInlineAll;
+   }
+
    // allow high amount of texcoords
    ctx->Const.MaxTextureCoordUnits = 16;
 
@@ -82,29 +115,58 @@ initialize_mesa_context(struct gl_context *ctx, glslopt_target api)
 }
 
 
+// The builtin function module and the glsl_type caches are global and shared
+// by all contexts; only release them when the last context is cleaned up.
+static mtx_t s_context_lock = _MTX_INITIALIZER_NP;
+static int s_context_count = 0;
+
+
+struct glslopt_cache;
+static void cache_destroy (glslopt_cache* cache);
+struct glslopt_prelude;
+
 struct glslopt_ctx {
 	glslopt_ctx (glslopt_target target) {
 		this->target = target;
 		mem_ctx = ralloc_context (NULL);
+		mtx_init (&mem_lock, mtx_plain);
+		cache = NULL;
+		prelude = NULL;
+		profiling = false;
 		initialize_mesa_context (&mesa_ctx, target);
 	}
 	~glslopt_ctx() {
+		cache_destroy (cache);
+		ralloc_free (prelude);
 		ralloc_free (mem_ctx);
+		mtx_destroy (&mem_lock);
 	}
 	struct gl_context mesa_ctx;
 	void* mem_ctx;
+	// guards mem_ctx; shaders from one context can be created and deleted
+	// from several threads at once
+	mtx_t mem_lock;
 	glslopt_target target;
+	glslopt_cache* cache;
+	glslopt_prelude* prelude;
+	bool profiling;
 };
 
 glslopt_ctx* glslopt_initialize (glslopt_target target)
 {
+	mtx_lock (&s_context_lock);
+	++s_context_count;
+	mtx_unlock (&s_context_lock);
 	return new glslopt_ctx(target);
 }
 
 void glslopt_cleanup (glslopt_ctx* ctx)
 {
 	delete ctx;
-	_mesa_destroy_shader_compiler();
+	mtx_lock (&s_context_lock);
+	if (--s_context_count == 0)
+		_mesa_destroy_shader_compiler();
+	mtx_unlock (&s_context_lock);
 }
 
 void glslopt_set_max_unroll_iterations (glslopt_ctx* ctx, unsigned iterations)
@@ -113,6 +175,22 @@ void glslopt_set_max_unroll_iterations (glslopt_ctx* ctx, unsigned iterations)
 		ctx->mesa_ctx.Const.ShaderCompilerOptions[i].MaxUnrollIterations = iterations;
 }
 
+void glslopt_set_inline_budget (glslopt_ctx* ctx, unsigned maxGrowth, unsigned maxCalleeSize, unsigned constantArgBonus)
+{
+	for (int i = 0; i < MESA_SHADER_STAGES; ++i)
+	{
+		gl_shader_compiler_options& options = ctx->mesa_ctx.Const.ShaderCompilerOptions[i];
+		options.MaxInlineGrowth = maxGrowth;
+		options.MaxInlineSize = maxCalleeSize;
+		options.InlineConstantArgBonus = constantArgBonus;
+	}
+}
+
+void glslopt_set_profiling (glslopt_ctx* ctx, bool enable)
+{
+	ctx->profiling = enable;
+}
+
 struct glslopt_shader_var
 {
 	const char* name;
@@ -124,6 +202,8 @@ struct glslopt_shader_var
 	int location;
 };
 
+struct glslopt_profile;
+
 struct glslopt_shader
 {
 	static void* operator new(size_t size, void *ctx)
@@ -138,10 +218,15 @@ struct glslopt_shader
 		ralloc_free(node);
 	}
 
-	glslopt_shader ()
-		: rawOutput(0)
+	glslopt_shader (glslopt_ctx* ctx)
+		: ctx(ctx)
+		, rawOutput(0)
 		, optimizedOutput(0)
+		, profile(0)
 		, status(false)
+		, uniforms(0)
+		, inputs(0)
+		, textures(0)
 		, uniformCount(0)
 		, uniformsSize(0)
 		, inputCount(0)
@@ -151,6 +236,7 @@ struct glslopt_shader
 		, statsFlow(0)
 	{
 		infoLog = "Shader not compiled yet";
+		memset (&cost, 0, sizeof(cost));
 		
 		whole_program = rzalloc (NULL, struct gl_shader_program);
 		assert(whole_program != NULL);
@@ -175,26 +261,465 @@ struct glslopt_shader
 		ralloc_free(optimizedOutput);
 	}
 	
+	glslopt_ctx* ctx;
 	struct gl_shader_program* whole_program;
 	struct gl_shader* shader;
 
-	static const int kMaxShaderUniforms = 1024;
-	static const int kMaxShaderInputs = 128;
-	static const int kMaxShaderTextures = 128;
-	glslopt_shader_var uniforms[kMaxShaderUniforms];
-	glslopt_shader_var inputs[kMaxShaderInputs];
-	glslopt_shader_var textures[kMaxShaderInputs];
+	// Reflection info; arrays are ralloc'ed off the shader, sized exactly
+	glslopt_shader_var* uniforms;
+	glslopt_shader_var* inputs;
+	glslopt_shader_var* textures;
 	int uniformCount, uniformsSize;
 	int inputCount;
 	int textureCount;
 	int statsMath, statsTex, statsFlow;
+	glslopt_shader_cost cost;
 
 	char*	rawOutput;
 	char*	optimizedOutput;
+	glslopt_profile* profile; // NULL unless profiling was on
 	const char*	infoLog;
 	bool	status;
 };
 
+
+// ---- Result cache
+//
+// Results are keyed by a SHA-1 of everything that affects them: preprocessed
+// source, shader type, target, options and unroll limit. A cache entry is the
+// serialized form of a glslopt_shader (outputs, reflection info and stats).
+// Entries are kept in memory in LRU order, and optionally also as files in a
+// directory so that they survive across processes.
+
+static const uint32_t kCacheMagic = 0x43504f47; // "GOPC"
+static const uint32_t kCacheVersion = 3;
+static const int kCacheKeySize = 20;
+
+struct glslopt_cache_entry : public exec_node
+{
+	unsigned char key[kCacheKeySize];
+	uint8_t* data;
+	size_t size;
+};
+
+struct glslopt_cache
+{
+	mtx_t lock;
+	void* mem_ctx;
+	struct hash_table* entries; // key -> glslopt_cache_entry
+	exec_list lru; // most recently used first
+	int entryCount;
+	int maxEntries;
+	char* diskPath;
+	int hits, misses;
+};
+
+static bool cache_key_equal (const void* a, const void* b)
+{
+	return memcmp (a, b, kCacheKeySize) == 0;
+}
+
+static uint32_t cache_key_hash (const unsigned char* key)
+{
+	// key is a SHA-1 already, any part of it is a good hash
+	uint32_t hash;
+	memcpy (&hash, key, sizeof(hash));
+	return hash;
+}
+
+static void cache_destroy (glslopt_cache* cache)
+{
+	if (!cache)
+		return;
+	mtx_destroy (&cache->lock);
+	ralloc_free (cache->mem_ctx);
+}
+
+// preludeHash: that of the prelude the source follows, or NULL
+static void cache_compute_key (glslopt_ctx* ctx, gl_shader_stage stage, const char* source, size_t length, unsigned options, const unsigned char* preludeHash, unsigned char* outKey)
+{
+	struct mesa_sha1 sha;
+	_mesa_sha1_init (&sha);
+	const gl_shader_compiler_options& compilerOptions = ctx->mesa_ctx.Const.ShaderCompilerOptions[stage];
+	const uint32_t params[8] = {
+		kCacheVersion,
+		(uint32_t)ctx->target,
+		(uint32_t)stage,
+		options,
+		compilerOptions.MaxUnrollIterations,
+		compilerOptions.MaxInlineGrowth,
+		compilerOptions.MaxInlineSize,
+		compilerOptions.InlineConstantArgBonus,
+	};
+	_mesa_sha1_update (&sha, params, sizeof(params));
+	if (preludeHash)
+		_mesa_sha1_update (&sha, preludeHash, kCacheKeySize);
+	_mesa_sha1_update (&sha, source, length);
+	_mesa_sha1_final (&sha, outKey);
+}
+
+static char* cache_file_path (glslopt_cache* cache, void* mem_ctx, const unsigned char* key)
+{
+	char hex[41];
+	_mesa_sha1_format (hex, key);
+	return ralloc_asprintf (mem_ctx, "%s/%s.glslopt", cache->diskPath, hex);
+}
+
+static void write_opt_string (struct blob* blob, const char* str)
+{
+	blob_write_uint32 (blob, str != NULL);
+	if (str)
+		blob_write_string (blob, str);
+}
+
+static const char* read_opt_string (struct blob_reader* blob)
+{
+	if (!blob_read_uint32 (blob))
+		return NULL;
+	return blob_read_string (blob);
+}
+
+static void write_shader_vars (struct blob* blob, const glslopt_shader_var* vars, int count)
+{
+	blob_write_uint32 (blob, count);
+	for (int i = 0; i < count; ++i)
+	{
+		const glslopt_shader_var& v = vars[i];
+		blob_write_string (blob, v.name);
+		const uint32_t fields[6] = { (uint32_t)v.type, (uint32_t)v.prec, (uint32_t)v.vectorSize, (uint32_t)v.matrixSize, (uint32_t)v.arraySize, (uint32_t)v.location };
+		blob_write_bytes (blob, fields, sizeof(fields));
+	}
+}
+
+static int read_shader_vars (struct blob_reader* blob, glslopt_shader* sh, glslopt_shader_var** outVars)
+{
+	*outVars = NULL;
+	uint32_t count = blob_read_uint32 (blob);
+	// each entry takes at least a string terminator and 6 ints; reject counts
+	// the remaining data can't possibly hold before allocating anything
+	if (blob->overrun || count > (size_t)(blob->end - blob->current) / (1 + 6 * sizeof(uint32_t)))
+	{
+		blob->overrun = true;
+		return 0;
+	}
+	if (count == 0)
+		return 0;
+	glslopt_shader_var* vars = ralloc_array (sh, glslopt_shader_var, count);
+	*outVars = vars;
+	for (uint32_t i = 0; i < count && !blob->overrun; ++i)
+	{
+		glslopt_shader_var& v = vars[i];
+		const char* name = blob_read_string (blob);
+		const uint32_t* fields = (const uint32_t*)blob_read_bytes (blob, 6 * sizeof(uint32_t));
+		if (!name || !fields)
+			return 0;
+		uint32_t f[6];
+		memcpy (f, fields, sizeof(f));
+		v.name = ralloc_strdup (vars, name);
+		v.type = (glslopt_basic_type)f[0];
+		v.prec = (glslopt_precision)f[1];
+		v.vectorSize = (int)f[2];
+		v.matrixSize = (int)f[3];
+		v.arraySize = (int)f[4];
+		v.location = (int)f[5];
+	}
+	return (int)count;
+}
+
+static void cache_serialize_shader (const glslopt_shader* sh, struct blob* blob)
+{
+	blob_write_uint32 (blob, kCacheMagic);
+	blob_write_uint32 (blob, kCacheVersion);
+	blob_write_uint32 (blob, sh->status);
+	write_opt_string (blob, sh->infoLog);
+	write_opt_string (blob, sh->rawOutput);
+	write_opt_string (blob, sh->optimizedOutput);
+	const uint32_t ints[4] = { (uint32_t)sh->uniformsSize, (uint32_t)sh->statsMath, (uint32_t)sh->statsTex, (uint32_t)sh->statsFlow };
+	blob_write_bytes (blob, ints, sizeof(ints));
+	blob_write_bytes (blob, &sh->cost, sizeof(sh->cost));
+	write_shader_vars (blob, sh->inputs, sh->inputCount);
+	write_shader_vars (blob, sh->uniforms, sh->uniformCount);
+	write_shader_vars (blob, sh->textures, sh->textureCount);
+}
+
+static bool cache_deserialize_shader (const uint8_t* data, size_t size, glslopt_shader* sh)
+{
+	struct blob_reader blob;
+	blob_reader_init (&blob, data, size);
+	if (blob_read_uint32 (&blob) != kCacheMagic || blob_read_uint32 (&blob) != kCacheVersion)
+		return false;
+
+	// Everything is read before any of it goes into the shader: on a
+	// truncated or corrupt entry, the shader gets compiled for real and has
+	// to be as untouched as a new one.
+	const bool status = blob_read_uint32 (&blob) != 0;
+	const char* infoLog = read_opt_string (&blob);
+	const char* rawOutput = read_opt_string (&blob);
+	const char* optimizedOutput = read_opt_string (&blob);
+	const uint32_t* ints = (const uint32_t*)blob_read_bytes (&blob, 4 * sizeof(uint32_t));
+	const void* cost = blob_read_bytes (&blob, sizeof(sh->cost));
+	if (blob.overrun)
+		return false;
+	glslopt_shader_var *inputs, *uniforms, *textures;
+	const int inputCount = read_shader_vars (&blob, sh, &inputs);
+	const int uniformCount = read_shader_vars (&blob, sh, &uniforms);
+	const int textureCount = read_shader_vars (&blob, sh, &textures);
+	if (blob.overrun)
+	{
+		ralloc_free (inputs);
+		ralloc_free (uniforms);
+		ralloc_free (textures);
+		return false;
+	}
+
+	sh->status = status;
+	uint32_t i[4];
+	memcpy (i, ints, sizeof(i));
+	sh->uniformsSize = (int)i[0];
+	sh->statsMath = (int)i[1];
+	sh->statsTex = (int)i[2];
+	sh->statsFlow = (int)i[3];
+	memcpy (&sh->cost, cost, sizeof(sh->cost));
+	sh->inputs = inputs;
+	sh->inputCount = inputCount;
+	sh->uniforms = uniforms;
+	sh->uniformCount = uniformCount;
+	sh->textures = textures;
+	sh->textureCount = textureCount;
+	sh->infoLog = infoLog ? ralloc_strdup (sh, infoLog) : NULL;
+	sh->rawOutput = rawOutput ? ralloc_strdup (sh, rawOutput) : NULL;
+	sh->optimizedOutput = optimizedOutput ? ralloc_strdup (sh, optimizedOutput) : NULL;
+	return true;
+}
+
+// adds an entry to the memory tier; expects cache->lock to be held
+static void cache_insert_locked (glslopt_cache* cache, const unsigned char* key, const uint8_t* data, size_t size)
+{
+	if (cache->maxEntries <= 0)
+		return;
+	const uint32_t hash = cache_key_hash (key);
+	if (_mesa_hash_table_search (cache->entries, hash, key))
+		return;
+
+	while (cache->entryCount >= cache->maxEntries)
+	{
+		glslopt_cache_entry* oldest = (glslopt_cache_entry*)cache->lru.get_tail();
+		_mesa_hash_table_remove (cache->entries, _mesa_hash_table_search (cache->entries, cache_key_hash (oldest->key), oldest->key));
+		oldest->remove();
+		ralloc_free (oldest);
+		--cache->entryCount;
+	}
+
+	glslopt_cache_entry* e = rzalloc (cache->mem_ctx, glslopt_cache_entry);
+	memcpy (e->key, key, kCacheKeySize);
+	e->data = (uint8_t*)ralloc_size (e, size);
+	memcpy (e->data, data, size);
+	e->size = size;
+	_mesa_hash_table_insert (cache->entries, hash, e->key, e);
+	cache->lru.push_head (e);
+	++cache->entryCount;
+}
+
+static bool cache_lookup (glslopt_cache* cache, const unsigned char* key, glslopt_shader* sh)
+{
+	bool found = false;
+
+	mtx_lock (&cache->lock);
+	struct hash_entry* he = _mesa_hash_table_search (cache->entries, cache_key_hash (key), key);
+	if (he)
+	{
+		glslopt_cache_entry* e = (glslopt_cache_entry*)he->data;
+		e->remove();
+		cache->lru.push_head (e);
+		found = cache_deserialize_shader (e->data, e->size, sh);
+	}
+	mtx_unlock (&cache->lock);
+
+	if (!found && cache->diskPath)
+	{
+		char* path = cache_file_path (cache, sh, key);
+		FILE* f = fopen (path, "rb");
+		if (f)
+		{
+			fseek (f, 0, SEEK_END);
+			long size = ftell (f);
+			fseek (f, 0, SEEK_SET);
+			uint8_t* data = size > 0 ? (uint8_t*)ralloc_size (sh, size) : NULL;
+			if (data && fread (data, 1, size, f) == (size_t)size && cache_deserialize_shader (data, size, sh))
+			{
+				found = true;
+				mtx_lock (&cache->lock);
+				cache_insert_locked (cache, key, data, size);
+				mtx_unlock (&cache->lock);
+			}
+			fclose (f);
+			ralloc_free (data);
+		}
+		ralloc_free (path);
+	}
+
+	mtx_lock (&cache->lock);
+	if (found)
+		++cache->hits;
+	else
+		++cache->misses;
+	mtx_unlock (&cache->lock);
+	return found;
+}
+
+static void cache_store (glslopt_cache* cache, const unsigned char* key, const glslopt_shader* sh)
+{
+	struct blob blob;
+	blob_init (&blob);
+	cache_serialize_shader (sh, &blob);
+	if (blob.out_of_memory)
+	{
+		blob_finish (&blob);
+		return;
+	}
+
+	mtx_lock (&cache->lock);
+	cache_insert_locked (cache, key, blob.data, blob.size);
+	mtx_unlock (&cache->lock);
+
+	if (cache->diskPath)
+	{
+		// write to a temporary file first, so that other processes never
+		// see partially written entries
+		char* path = cache_file_path (cache, NULL, key);
+		char* tmpPath = ralloc_asprintf (path, "%s.%p.tmp", path, (void*)&blob);
+		FILE* f = fopen (tmpPath, "wb");
+		if (f)
+		{
+			const bool ok = fwrite (blob.data, 1, blob.size, f) == blob.size;
+			fclose (f);
+			if (!ok || rename (tmpPath, path) != 0)
+				remove (tmpPath);
+		}
+		ralloc_free (path);
+	}
+	blob_finish (&blob);
+}
+
+void glslopt_set_cache (glslopt_ctx* ctx, int memoryEntries, const char* diskPath)
+{
+	cache_destroy (ctx->cache);
+	ctx->cache = NULL;
+	if (memoryEntries <= 0 && !diskPath)
+		return;
+
+	void* mem_ctx = ralloc_context (NULL);
+	glslopt_cache* cache = rzalloc (mem_ctx, glslopt_cache);
+	cache->mem_ctx = mem_ctx;
+	mtx_init (&cache->lock, mtx_plain);
+	cache->entries = _mesa_hash_table_create (mem_ctx, cache_key_equal);
+	cache->lru.make_empty();
+	cache->maxEntries = memoryEntries;
+	cache->diskPath = diskPath ? ralloc_strdup (mem_ctx, diskPath) : NULL;
+	ctx->cache = cache;
+}
+
+void glslopt_get_cache_stats (glslopt_ctx* ctx, int* outHits, int* outMisses)
+{
+	*outHits = 0;
+	*outMisses = 0;
+	if (!ctx->cache)
+		return;
+	mtx_lock (&ctx->cache->lock);
+	*outHits = ctx->cache->hits;
+	*outMisses = ctx->cache->misses;
+	mtx_unlock (&ctx->cache->lock);
+}
+
+
+// A prelude compiled for one shader stage, up to where a shader following it
+// takes over: its macros, and the parser state, instructions and symbols that
+// converting it to HIR left
+struct prelude_stage
+{
+	glcpp_prelude* macros;
+	_mesa_glsl_parse_state* state;
+	exec_list* ir;
+};
+
+struct glslopt_prelude
+{
+	char* source;
+	size_t length;
+	unsigned char hash[kCacheKeySize];
+	prelude_stage* stages[MESA_SHADER_STAGES]; // NULL where the prelude doesn't compile
+};
+
+static prelude_stage* prelude_compile (glslopt_ctx* ctx, glslopt_prelude* prelude, gl_shader_stage stage)
+{
+	// Not an arena: this is kept around, and copied from by every compile
+	void* mem_ctx = ralloc_context (prelude);
+	prelude_stage* ps = rzalloc (mem_ctx, prelude_stage);
+
+	_mesa_glsl_parse_state* state = new (mem_ctx) _mesa_glsl_parse_state (&ctx->mesa_ctx, stage, mem_ctx);
+	if (ctx->target == kGlslTargetMetal)
+		state->metal_target = true;
+	state->error = 0;
+
+	const char* source = prelude->source;
+	state->error = !!glcpp_preprocess_prelude (state, &source, prelude->length, &state->info_log, state->extensions, &ctx->mesa_ctx, &ps->macros);
+	if (!state->error)
+	{
+		// Shaders get parsed with the symbols the prelude was parsed with
+		state->keep_parse_symbols = true;
+		_mesa_glsl_lexer_ctor_in_place (state, (char*)source);
+		_mesa_glsl_parse (state);
+		_mesa_glsl_lexer_dtor (state);
+	}
+
+	ps->ir = new (mem_ctx) exec_list();
+	if (!state->error)
+		_mesa_ast_to_hir_prelude (ps->ir, state);
+
+	if (state->error || !state->parse_symbols)
+	{
+		ralloc_free (mem_ctx);
+		return NULL;
+	}
+	ps->state = state;
+	return ps;
+}
+
+void glslopt_set_prelude (glslopt_ctx* ctx, const char* preludeSource)
+{
+	ralloc_free (ctx->prelude);
+	ctx->prelude = NULL;
+	if (!preludeSource)
+		return;
+
+	glslopt_prelude* prelude = rzalloc (NULL, glslopt_prelude);
+	prelude->length = strlen (preludeSource);
+	prelude->source = ralloc_strndup (prelude, preludeSource, prelude->length);
+
+	struct mesa_sha1 sha;
+	_mesa_sha1_init (&sha);
+	_mesa_sha1_update (&sha, prelude->source, prelude->length);
+	_mesa_sha1_final (&sha, prelude->hash);
+
+	prelude->stages[MESA_SHADER_VERTEX] = prelude_compile (ctx, prelude, MESA_SHADER_VERTEX);
+	prelude->stages[MESA_SHADER_FRAGMENT] = prelude_compile (ctx, prelude, MESA_SHADER_FRAGMENT);
+	ctx->prelude = prelude;
+}
+
+// What a shader following the prelude stands for: the prelude, the defines and
+// the shader pasted together, with the shader's lines numbered from 1 again
+static char* prelude_paste (const glslopt_prelude* prelude, const char* defines, const char* source, size_t length)
+{
+	if (!defines)
+		defines = "";
+	const size_t definesLength = strlen (defines);
+	char* pasted = ralloc_asprintf (NULL, "%s%s%s%s#line 0\n",
+		prelude->source, prelude->length && prelude->source[prelude->length - 1] != '\n' ? "\n" : "",
+		defines, definesLength && defines[definesLength - 1] != '\n' ? "\n" : "");
+	ralloc_strncat (&pasted, source, length);
+	return pasted;
+}
+
 static inline void debug_print_ir (const char* name, exec_list* ir, _mesa_glsl_parse_state* state, void* memctx)
 {
 	#if 0
@@ -207,13 +732,75 @@ static inline void debug_print_ir (const char* name, exec_list* ir, _mesa_glsl_p
 }
 
 
+// Precision propagation runs the rules below over "units": the statements of
+// function bodies (plus if conditions), in the order visit_tree reaches them.
+// Each unit records the variables without precision it reads; a unit is only
+// rerun while it is still changing, or when one of those variables got its
+// precision from some other unit.
+struct precision_unit : public exec_node
+{
+	ir_instruction* ir;
+	ir_instruction* root; // top level instruction the unit is in
+	bool dirty; // needs to run in the current round
+	bool dirtyNext; // needs to run in the next round
+};
+
+struct precision_use : public exec_node
+{
+	precision_unit* unit;
+};
+
 struct precision_ctx
 {
-	exec_list* root_ir;
+	void* mem_ctx;
+	hash_table* uses; // ir_variable -> exec_list of precision_use
+	exec_list* units;
+	precision_unit* unit; // unit being run
 	bool res;
 };
 
 
+static void precision_add_use(precision_ctx* ctx, ir_variable* var)
+{
+	if (var->data.precision != glsl_precision_undefined)
+		return;
+	hash_entry* e = _mesa_hash_table_search (ctx->uses, _mesa_hash_pointer (var), var);
+	exec_list* list;
+	if (e)
+	{
+		list = (exec_list*)e->data;
+		// units are collected in order, so a repeated use is always at the tail
+		if (((precision_use*)list->get_tail())->unit == ctx->unit)
+			return;
+	}
+	else
+	{
+		list = new(ctx->mem_ctx) exec_list;
+		_mesa_hash_table_insert (ctx->uses, _mesa_hash_pointer (var), var, list);
+	}
+	precision_use* use = new(ctx->mem_ctx) precision_use;
+	use->unit = ctx->unit;
+	list->push_tail (use);
+}
+
+// A variable got its precision changed: rerun every unit that reads it,
+// both later in this round and in the next one.
+static void precision_var_changed(precision_ctx* ctx, ir_variable* var)
+{
+	hash_entry* e = _mesa_hash_table_search (ctx->uses, _mesa_hash_pointer (var), var);
+	if (e)
+	{
+		foreach_in_list(precision_use, use, (exec_list*)e->data)
+			use->unit->dirty = use->unit->dirtyNext = true;
+		return;
+	}
+	// An assignment through an array or record dereference can still change a
+	// variable that had precision; uses of those are not tracked, so rerun all.
+	foreach_in_list(precision_unit, unit, ctx->units)
+		unit->dirty = unit->dirtyNext = true;
+}
+
+
 static void propagate_precision_deref(ir_instruction *ir, void *data)
 {
 	// variable deref with undefined precision: take from variable itself
@@ -280,27 +867,6 @@ static void propagate_precision_texture(ir_instruction *ir, void *data)
 	((precision_ctx*)data)->res = true;
 }
 
-struct undefined_ass_ctx
-{
-	ir_variable* var;
-	bool res;
-};
-
-static void has_only_undefined_precision_assignments(ir_instruction *ir, void *data)
-{
-	ir_assignment* ass = ir->as_assignment();
-	if (!ass)
-		return;
-	undefined_ass_ctx* ctx = (undefined_ass_ctx*)data;
-	if (ass->whole_variable_written() != ctx->var)
-		return;
-	glsl_precision prec = ass->rhs->get_precision();
-	if (prec == glsl_precision_undefined)
-		return;
-	ctx->res = false;
-}
-
-
 static void propagate_precision_assign(ir_instruction *ir, void *data)
 {
 	ir_assignment* ass = ir->as_assignment();
@@ -316,8 +882,11 @@ static void propagate_precision_assign(ir_instruction *ir, void *data)
 		ir_variable* lhs_var = ass->lhs->variable_referenced();
 		if (lp == glsl_precision_undefined)
 		{		
-			if (lhs_var)
+			if (lhs_var && lhs_var->data.precision != rp)
+			{
 				lhs_var->data.precision = rp;
+				precision_var_changed ((precision_ctx*)data, lhs_var);
+			}
 			ass->lhs->set_precision (rp);
 			((precision_ctx*)data)->res = true;
 		}
@@ -325,8 +894,7 @@ static void propagate_precision_assign(ir_instruction *ir, void *data)
 	}
 	
 	// for assignments where LHS has precision, but RHS is a temporary variable
-	// with undefined precision that's only assigned from other undefined precision
-	// sources -> make the RHS variable take LHS precision
+	// with undefined precision -> make the RHS variable take LHS precision
 	if (lp != glsl_precision_undefined && rp == glsl_precision_undefined)
 	{
 		ir_dereference* deref = ass->rhs->as_dereference();
@@ -335,21 +903,10 @@ static void propagate_precision_assign(ir_instruction *ir, void *data)
 			ir_variable* rhs_var = deref->variable_referenced();
 			if (rhs_var && rhs_var->data.mode == ir_var_temporary && rhs_var->data.precision == glsl_precision_undefined)
 			{
-				undefined_ass_ctx ctx;
-				ctx.var = rhs_var;
-				// find if we only assign to it from undefined precision sources
-				ctx.res = true;
-				exec_list* root_ir = ((precision_ctx*)data)->root_ir;
-				foreach_in_list(ir_instruction, inst, root_ir)
-				{
-					visit_tree (ir, has_only_undefined_precision_assignments, &ctx);
-				}
-				if (ctx.res)
-				{
-					rhs_var->data.precision = lp;
-					ass->rhs->set_precision(lp);
-					((precision_ctx*)data)->res = true;
-				}
+				rhs_var->data.precision = lp;
+				precision_var_changed ((precision_ctx*)data, rhs_var);
+				ass->rhs->set_precision(lp);
+				((precision_ctx*)data)->res = true;
 			}
 		}
 		return;
@@ -386,35 +943,135 @@ static void propagate_precision_call(ir_instruction *ir, void *data)
 	}
 }
 
+// The first round's texture rule also records which variables each unit uses.
+static void precision_collect_uses(ir_instruction *ir, void *data)
+{
+	precision_ctx* ctx = (precision_ctx*)data;
+	ir_dereference_variable* der = ir->as_dereference_variable();
+	if (der)
+		precision_add_use (ctx, der->var);
+	// call return precision comes from the callee's parameters
+	ir_call* call = ir->as_call();
+	if (call)
+	{
+		foreach_in_list(ir_variable, sig_param, &call->callee->parameters)
+			precision_add_use (ctx, sig_param);
+	}
+	propagate_precision_texture (ir, data);
+}
+
+static void precision_collect_units(precision_ctx* ctx, exec_list* units, exec_list* list, ir_instruction* root)
+{
+	foreach_in_list(ir_instruction, ir, list)
+	{
+		ir_instruction* r = root ? root : ir;
+		ir_instruction* unit_ir = ir;
+		switch (ir->ir_type)
+		{
+		case ir_type_variable:
+			continue;
+		case ir_type_function:
+			foreach_in_list(ir_function_signature, sig, &((ir_function*)ir)->signatures)
+				precision_collect_units (ctx, units, &sig->body, r);
+			continue;
+		case ir_type_if:
+			unit_ir = ((ir_if*)ir)->condition;
+			break;
+		case ir_type_loop:
+			precision_collect_units (ctx, units, &((ir_loop*)ir)->body_instructions, r);
+			continue;
+		default:
+			break;
+		}
+		precision_unit* unit = new(ctx->mem_ctx) precision_unit;
+		unit->ir = unit_ir;
+		unit->root = r;
+		unit->dirty = true;
+		unit->dirtyNext = false;
+		units->push_tail (unit);
+		if (ir->ir_type == ir_type_if)
+		{
+			precision_collect_units (ctx, units, &((ir_if*)ir)->then_instructions, r);
+			precision_collect_units (ctx, units, &((ir_if*)ir)->else_instructions, r);
+		}
+	}
+}
+
+// Runs one rule over the dirty units of [first, end); returns whether any
+// of them changed.
+static bool precision_run_rule(precision_ctx* ctx, ir_hierarchical_visitor* v, precision_unit* first, exec_node* end, void (*rule)(ir_instruction*, void*))
+{
+	bool progress = false;
+	v->callback_enter = rule;
+	for (exec_node* n = first; n != end; n = n->next)
+	{
+		precision_unit* unit = (precision_unit*)n;
+		if (!unit->dirty)
+			continue;
+		ctx->res = false;
+		ctx->unit = unit;
+		unit->ir->accept (v);
+		if (ctx->res)
+		{
+			unit->dirtyNext = true;
+			progress = true;
+		}
+	}
+	return progress;
+}
+
 static bool propagate_precision(exec_list* list, bool assign_high_to_undefined)
 {
 	bool anyProgress = false;
 	precision_ctx ctx;
-	
+	ctx.mem_ctx = ralloc_arena_context (NULL);
+	ctx.uses = _mesa_hash_table_create (ctx.mem_ctx, _mesa_key_pointer_equal);
+	ctx.unit = NULL;
+	ctx.res = false;
+
+	exec_list units;
+	ctx.units = &units;
+	precision_collect_units (&ctx, &units, list, NULL);
+
+	ir_hierarchical_visitor v;
+	v.data_enter = &ctx;
+
+	// Same rule order as sweeping every top level instruction each round, but
+	// units that can't change are skipped; the result is identical.
+	bool progress;
+	bool firstRound = true;
 	do {
-		ctx.res = false;
-		ctx.root_ir = list;
-		foreach_in_list(ir_instruction, ir, list)
+		progress = false;
+		exec_node* first = units.head;
+		while (!first->is_tail_sentinel())
 		{
-			visit_tree (ir, propagate_precision_texture, &ctx);
-			visit_tree (ir, propagate_precision_deref, &ctx);
-			bool hadProgress = ctx.res;
-			ctx.res = false;
-			visit_tree (ir, propagate_precision_assign, &ctx);
-			if (ctx.res)
+			exec_node* end = first->next;
+			while (!end->is_tail_sentinel() && ((precision_unit*)end)->root == ((precision_unit*)first)->root)
+				end = end->next;
+			precision_unit* u = (precision_unit*)first;
+			progress |= precision_run_rule (&ctx, &v, u, end, firstRound ? precision_collect_uses : propagate_precision_texture);
+			progress |= precision_run_rule (&ctx, &v, u, end, propagate_precision_deref);
+			if (precision_run_rule (&ctx, &v, u, end, propagate_precision_assign))
 			{
 				// assignment precision propagation might have added precision
 				// to some variables; need to propagate dereference precision right
 				// after that too.
-				visit_tree (ir, propagate_precision_deref, &ctx);
+				precision_run_rule (&ctx, &v, u, end, propagate_precision_deref);
+				progress = true;
 			}
-			ctx.res |= hadProgress;
-			visit_tree (ir, propagate_precision_call, &ctx);
-			visit_tree (ir, propagate_precision_expr, &ctx);
+			progress |= precision_run_rule (&ctx, &v, u, end, propagate_precision_call);
+			progress |= precision_run_rule (&ctx, &v, u, end, propagate_precision_expr);
+			first = end;
 		}
-		anyProgress |= ctx.res;
-	} while (ctx.res);
-	anyProgress |= ctx.res;
+		foreach_in_list(precision_unit, unit, &units)
+		{
+			unit->dirty = unit->dirtyNext;
+			unit->dirtyNext = false;
+		}
+		anyProgress |= progress;
+		firstRound = false;
+	} while (progress);
+	ralloc_free (ctx.mem_ctx);
 	
 	// for globals that have undefined precision, set it to highp
 	if (assign_high_to_undefined)
@@ -437,71 +1094,347 @@ static bool propagate_precision(exec_list* list, bool assign_high_to_undefined)
 }
 
 
-static void do_optimization_passes(exec_list* ir, bool linked, _mesa_glsl_parse_state* state, void* mem_ctx)
+// Optimization passes, in the order they run within a round.
+enum opt_pass_id
+{
+	kPassInlining,
+	kPassDeadFunctions,
+	kPassStructureSplitting,
+	kPassIfSimplification,
+	kPassFlattenNestedIfs,
+	kPassPrecisionPropagation,
+	kPassCopyPropagation,
+	kPassCopyPropagationElements,
+	kPassVectorize,
+	kPassDeadCode,
+	kPassDeadCodeLocal,
+	kPassDeadStores,
+	kPassTreeGrafting,
+	kPassConstantPropagation,
+	kPassConstantVariable,
+	kPassConstantFolding,
+	kPassMinMaxPrune,
+	kPassCSE,
+	kPassIfPRE,
+	kPassRebalanceTree,
+	kPassAlgebraic,
+	kPassLowerJumps,
+	kPassVecIndexToSwizzle,
+	kPassLowerVectorInsert,
+	kPassSwizzleSwizzle,
+	kPassNoopSwizzle,
+	kPassSplitArrays,
+	kPassRedundantJumps,
+	kPassLoops,
+	kPassCount
+};
+
+static const char* const kPassNames[kPassCount] =
+{
+	"inlining",
+	"dead functions",
+	"structure splitting",
+	"if simplification",
+	"flatten nested ifs",
+	"precision propagation",
+	"copy propagation",
+	"copy propagation elements",
+	"vectorize",
+	"dead code",
+	"dead code local",
+	"dead stores",
+	"tree grafting",
+	"constant propagation",
+	"constant variable",
+	"constant folding",
+	"minmax prune",
+	"CSE",
+	"if PRE",
+	"rebalance tree",
+	"algebraic",
+	"lower jumps",
+	"vec index to swizzle",
+	"lower vector insert",
+	"swizzle swizzle",
+	"noop swizzle",
+	"split arrays",
+	"redundant jumps",
+	"loops",
+};
+
+
+// ---- Profiling
+//
+// With profiling on, each shader records wall time and invocation counts of
+// the compile phases and of every optimization pass. Profile entries are the
+// phases first, then the passes, in the order they run.
+
+enum opt_phase_id
+{
+	kPhasePreprocess,
+	kPhaseParse,
+	kPhaseAstToHir,
+	kPhaseLink,
+	kPhaseOptimize,
+	kPhasePrint,
+	kPhaseCount
+};
+
+static const char* const kPhaseNames[kPhaseCount] =
+{
+	"preprocess",
+	"parse",
+	"ast to hir",
+	"link",
+	"optimize",
+	"print",
+};
+
+struct glslopt_profile_entry
+{
+	double ms;
+	int invocations;
+	int progress;
+};
+
+struct glslopt_profile
+{
+	glslopt_profile_entry phases[kPhaseCount];
+	glslopt_profile_entry passes[kPassCount];
+	char* json; // built on first request
+};
+
+static double get_time_ms ()
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, t;
+	QueryPerformanceFrequency (&freq);
+	QueryPerformanceCounter (&t);
+	return t.QuadPart * 1000.0 / freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1.0e6;
+#endif
+}
+
+// Times one compile phase for the duration of a scope; does nothing when the
+// shader is not being profiled.
+struct profile_phase_scope
+{
+	profile_phase_scope (glslopt_profile* profile, opt_phase_id phase)
+		: entry(profile ? &profile->phases[phase] : NULL)
+		, start(profile ? get_time_ms() : 0.0)
+	{
+	}
+	~profile_phase_scope ()
+	{
+		if (!entry)
+			return;
+		entry->ms += get_time_ms() - start;
+		++entry->invocations;
+	}
+	glslopt_profile_entry* entry;
+	double start;
+};
+
+// Appends str to json as a quoted JSON string, with " and \ escaped
+static void json_append_string (char** json, const char* str)
+{
+	ralloc_strcat (json, "\"");
+	while (*str)
+	{
+		const size_t plain = strcspn (str, "\"\\");
+		ralloc_strncat (json, str, plain);
+		str += plain;
+		if (!*str)
+			break;
+		ralloc_asprintf_append (json, "\\%c", *str);
+		++str;
+	}
+	ralloc_strcat (json, "\"");
+}
+
+static const char* profile_to_json (glslopt_profile* profile)
+{
+	if (profile->json)
+		return profile->json;
+	char* json = ralloc_strdup (profile, "{\n  \"phases\": [");
+	for (int i = 0; i < kPhaseCount; ++i)
+	{
+		const glslopt_profile_entry& e = profile->phases[i];
+		ralloc_asprintf_append (&json, "%s\n    { \"name\": ", i ? "," : "");
+		json_append_string (&json, kPhaseNames[i]);
+		ralloc_asprintf_append (&json, ", \"ms\": %.4f, \"invocations\": %d }", e.ms, e.invocations);
+	}
+	ralloc_strcat (&json, "\n  ],\n  \"passes\": [");
+	for (int i = 0; i < kPassCount; ++i)
+	{
+		const glslopt_profile_entry& e = profile->passes[i];
+		ralloc_asprintf_append (&json, "%s\n    { \"name\": ", i ? "," : "");
+		json_append_string (&json, kPassNames[i]);
+		ralloc_asprintf_append (&json, ", \"ms\": %.4f, \"invocations\": %d, \"progress\": %d }", e.ms, e.invocations, e.progress);
+	}
+	ralloc_strcat (&json, "\n  ]\n}");
+	profile->json = json;
+	return json;
+}
+
+
+// Decides which passes need to run again.
+//
+// Passes are deterministic functions of the IR, so a pass that found nothing to
+// do will keep finding nothing until some pass changes the IR. Every change
+// bumps the IR generation; a pass is skipped while it is clean at the current
+// generation. Compared to rerunning everything until a whole round makes no
+// progress, this drops the final no-op round and every pass that already ran
+// after the last change, with identical results.
+//
+// The manager also owns the variable use/def counts that dead code, tree
+// grafting and constant variable work from. They are counted once and then
+// shared between passes until a pass changes the IR without updating them.
+struct opt_pass_manager
 {
+	opt_pass_manager (exec_list* ir, _mesa_glsl_parse_state* state, void* mem_ctx, glslopt_profile* profile)
+		: ir(ir), state(state), mem_ctx(mem_ctx), profile(profile), generation(1), current(kPassCount), start(0.0), invocations(0), progress(false)
+		, refs(NULL), refsGeneration(0)
+	{
+		memset (cleanAt, 0, sizeof(cleanAt));
+	}
+
+	~opt_pass_manager ()
+	{
+		delete refs;
+	}
+
+	ir_variable_refcount_visitor* get_refs ()
+	{
+		if (refsGeneration != generation)
+		{
+			delete refs;
+			refs = new ir_variable_refcount_visitor ();
+			refs->run (ir);
+			refsGeneration = generation;
+		}
+		return refs;
+	}
+
+	bool begin (opt_pass_id id)
+	{
+		if (cleanAt[id] == generation)
+			return false;
+		current = id;
+		++invocations;
+		if (profile)
+			start = get_time_ms();
+		return true;
+	}
+
+	// keptRefs: the pass kept the counts from get_refs() up to date (or
+	// can't change them), so they stay valid after its changes.
+	void end (bool passProgress, bool keptRefs = false)
+	{
+		if (profile)
+		{
+			glslopt_profile_entry& e = profile->passes[current];
+			e.ms += get_time_ms() - start;
+			++e.invocations;
+			if (passProgress)
+				++e.progress;
+		}
+		if (passProgress)
+		{
+			if (keptRefs && refsGeneration == generation)
+				++refsGeneration;
+			++generation;
+			progress = true;
+			char name[64];
+			snprintf (name, sizeof(name), "After %s", kPassNames[current]);
+			debug_print_ir (name, ir, state, mem_ctx);
+		}
+		else
+			cleanAt[current] = generation;
+		current = kPassCount;
+	}
+
+	exec_list* ir;
+	_mesa_glsl_parse_state* state;
+	void* mem_ctx;
+	glslopt_profile* profile;
+	unsigned generation;
+	unsigned cleanAt[kPassCount];
+	opt_pass_id current;
+	double start;
+	int invocations;
 	bool progress;
-	// FIXME: Shouldn't need to bound the number of passes
-	int passes = 0,
-		kMaximumPasses = 1000;
+	ir_variable_refcount_visitor* refs;
+	unsigned refsGeneration;
+};
+
+static void do_optimization_passes(exec_list* ir, bool linked, bool limitPressure, _mesa_glsl_parse_state* state, void* mem_ctx, glslopt_profile* profile)
+{
+	opt_pass_manager pm (ir, state, mem_ctx, profile);
+	// FIXME: Shouldn't need to bound the number of rounds
+	int rounds = 0,
+		kMaximumRounds = 1000;
 	do {
-		progress = false;
-		++passes;
-		bool progress2;
+		pm.progress = false;
+		++rounds;
 		debug_print_ir ("Initial", ir, state, mem_ctx);
 		if (linked) {
-			progress2 = do_function_inlining(ir); progress |= progress2; if (progress2) debug_print_ir ("After inlining", ir, state, mem_ctx);
-			progress2 = do_dead_functions(ir); progress |= progress2; if (progress2) debug_print_ir ("After dead functions", ir, state, mem_ctx);
-			progress2 = do_structure_splitting(ir); progress |= progress2; if (progress2) debug_print_ir ("After struct splitting", ir, state, mem_ctx);
+			// Metal output only has the uniforms and inputs in main; inline everything there
+			if (pm.begin (kPassInlining)) pm.end (do_function_inlining(ir, state->metal_target ? NULL : &state->ctx->Const.ShaderCompilerOptions[state->stage]));
+			if (pm.begin (kPassDeadFunctions)) pm.end (do_dead_functions(ir));
+			if (pm.begin (kPassStructureSplitting)) pm.end (do_structure_splitting(ir));
 		}
-		progress2 = do_if_simplification(ir); progress |= progress2; if (progress2) debug_print_ir ("After if simpl", ir, state, mem_ctx);
-		progress2 = opt_flatten_nested_if_blocks(ir); progress |= progress2; if (progress2) debug_print_ir ("After if flatten", ir, state, mem_ctx);
-		progress2 = propagate_precision (ir, state->metal_target); progress |= progress2; if (progress2) debug_print_ir ("After prec propagation", ir, state, mem_ctx);
-		progress2 = do_copy_propagation(ir); progress |= progress2; if (progress2) debug_print_ir ("After copy propagation", ir, state, mem_ctx);
-		progress2 = do_copy_propagation_elements(ir); progress |= progress2; if (progress2) debug_print_ir ("After copy propagation elems", ir, state, mem_ctx);
+		if (pm.begin (kPassIfSimplification)) pm.end (do_if_simplification(ir));
+		if (pm.begin (kPassFlattenNestedIfs)) pm.end (opt_flatten_nested_if_blocks(ir));
+		if (pm.begin (kPassPrecisionPropagation)) pm.end (propagate_precision (ir, state->metal_target), true);
+		if (pm.begin (kPassCopyPropagation)) pm.end (do_copy_propagation(ir));
+		if (pm.begin (kPassCopyPropagationElements)) pm.end (do_copy_propagation_elements(ir));
 
 		if (linked)
 		{
-			progress2 = do_vectorize(ir); progress |= progress2; if (progress2) debug_print_ir ("After vectorize", ir, state, mem_ctx);
-		}
-		if (linked) {
-			progress2 = do_dead_code(ir,false); progress |= progress2; if (progress2) debug_print_ir ("After dead code", ir, state, mem_ctx);
-		} else {
-			progress2 = do_dead_code_unlinked(ir); progress |= progress2; if (progress2) debug_print_ir ("After dead code unlinked", ir, state, mem_ctx);
-		}
-		progress2 = do_dead_code_local(ir); progress |= progress2; if (progress2) debug_print_ir ("After dead code local", ir, state, mem_ctx);
-		progress2 = propagate_precision (ir, state->metal_target); progress |= progress2; if (progress2) debug_print_ir ("After prec propagation", ir, state, mem_ctx);
-		progress2 = do_tree_grafting(ir); progress |= progress2; if (progress2) debug_print_ir ("After tree grafting", ir, state, mem_ctx);
-		progress2 = do_constant_propagation(ir); progress |= progress2; if (progress2) debug_print_ir ("After const propagation", ir, state, mem_ctx);
-		if (linked) {
-			progress2 = do_constant_variable(ir); progress |= progress2; if (progress2) debug_print_ir ("After const variable", ir, state, mem_ctx);
-		} else {
-			progress2 = do_constant_variable_unlinked(ir); progress |= progress2; if (progress2) debug_print_ir ("After const variable unlinked", ir, state, mem_ctx);
+			if (pm.begin (kPassVectorize)) pm.end (do_vectorize(ir));
 		}
-		progress2 = do_constant_folding(ir); progress |= progress2; if (progress2) debug_print_ir ("After const folding", ir, state, mem_ctx);
-		progress2 = do_minmax_prune(ir); progress |= progress2; if (progress2) debug_print_ir ("After minmax prune", ir, state, mem_ctx);
-		progress2 = do_cse(ir); progress |= progress2; if (progress2) debug_print_ir ("After CSE", ir, state, mem_ctx);
-		progress2 = do_rebalance_tree(ir); progress |= progress2; if (progress2) debug_print_ir ("After rebalance tree", ir, state, mem_ctx);
-		progress2 = do_algebraic(ir, state->ctx->Const.NativeIntegers, &state->ctx->Const.ShaderCompilerOptions[state->stage]); progress |= progress2; if (progress2) debug_print_ir ("After algebraic", ir, state, mem_ctx);
-		progress2 = do_lower_jumps(ir); progress |= progress2; if (progress2) debug_print_ir ("After lower jumps", ir, state, mem_ctx);
-		progress2 = do_vec_index_to_swizzle(ir); progress |= progress2; if (progress2) debug_print_ir ("After vec index to swizzle", ir, state, mem_ctx);
-		progress2 = lower_vector_insert(ir, false); progress |= progress2; if (progress2) debug_print_ir ("After lower vector insert", ir, state, mem_ctx);
-		progress2 = do_swizzle_swizzle(ir); progress |= progress2; if (progress2) debug_print_ir ("After swizzle swizzle", ir, state, mem_ctx);
-		progress2 = do_noop_swizzle(ir); progress |= progress2; if (progress2) debug_print_ir ("After noop swizzle", ir, state, mem_ctx);
-		progress2 = optimize_split_arrays(ir, linked, state->metal_target && state->stage == MESA_SHADER_FRAGMENT); progress |= progress2; if (progress2) debug_print_ir ("After split arrays", ir, state, mem_ctx);
-		progress2 = optimize_redundant_jumps(ir); progress |= progress2; if (progress2) debug_print_ir ("After redundant jumps", ir, state, mem_ctx);
+		if (pm.begin (kPassDeadCode)) pm.end (linked ? do_dead_code(ir,false,pm.get_refs()) : do_dead_code_unlinked(ir), linked);
+		if (pm.begin (kPassDeadCodeLocal)) pm.end (do_dead_code_local(ir));
+		if (pm.begin (kPassDeadStores)) pm.end (do_dead_stores(ir));
+		if (pm.begin (kPassPrecisionPropagation)) pm.end (propagate_precision (ir, state->metal_target), true);
+		if (pm.begin (kPassTreeGrafting)) pm.end (do_tree_grafting(ir, pm.get_refs(), limitPressure), true);
+		if (pm.begin (kPassConstantPropagation)) pm.end (do_constant_propagation(ir));
+		if (pm.begin (kPassConstantVariable)) pm.end (linked ? do_constant_variable(ir,pm.get_refs()) : do_constant_variable_unlinked(ir), true);
+		if (pm.begin (kPassConstantFolding)) pm.end (do_constant_folding(ir));
+		if (pm.begin (kPassMinMaxPrune)) pm.end (do_minmax_prune(ir));
+		if (pm.begin (kPassCSE)) pm.end (do_cse(ir));
+		if (pm.begin (kPassIfPRE)) pm.end (do_if_pre(ir));
+		if (pm.begin (kPassRebalanceTree)) pm.end (do_rebalance_tree(ir));
+		if (pm.begin (kPassAlgebraic)) pm.end (do_algebraic(ir, state->ctx->Const.NativeIntegers, &state->ctx->Const.ShaderCompilerOptions[state->stage]));
+		if (pm.begin (kPassLowerJumps)) pm.end (do_lower_jumps(ir));
+		if (pm.begin (kPassVecIndexToSwizzle)) pm.end (do_vec_index_to_swizzle(ir));
+		if (pm.begin (kPassLowerVectorInsert)) pm.end (lower_vector_insert(ir, false));
+		if (pm.begin (kPassSwizzleSwizzle)) pm.end (do_swizzle_swizzle(ir));
+		if (pm.begin (kPassNoopSwizzle)) pm.end (do_noop_swizzle(ir));
+		if (pm.begin (kPassSplitArrays)) pm.end (optimize_split_arrays(ir, linked, state->metal_target && state->stage == MESA_SHADER_FRAGMENT));
+		if (pm.begin (kPassRedundantJumps)) pm.end (optimize_redundant_jumps(ir));
 
 		// do loop stuff only when linked; otherwise causes duplicate loop induction variable
 		// problems (ast-in.txt test)
-		if (linked)
+		if (linked && pm.begin (kPassLoops))
 		{
+			bool progress2 = false;
 			loop_state *ls = analyze_loop_variables(ir);
 			if (ls->loop_found) {
-				progress2 = set_loop_controls(ir, ls); progress |= progress2; if (progress2) debug_print_ir ("After set loop", ir, state, mem_ctx);
-				progress2 = unroll_loops(ir, ls, &state->ctx->Const.ShaderCompilerOptions[state->stage]); progress |= progress2; if (progress2) debug_print_ir ("After unroll", ir, state, mem_ctx);
+				progress2 |= set_loop_controls(ir, ls);
+				progress2 |= unroll_loops(ir, ls, &state->ctx->Const.ShaderCompilerOptions[state->stage]);
+				// hoist out of the loops that stay loops; the analysis is stale once anything got unrolled
+				if (!progress2)
+					progress2 |= hoist_loop_invariants(ir, ls);
 			}
 			delete ls;
+			pm.end (progress2);
 		}
-	} while (progress && passes < kMaximumPasses);
+	} while (pm.progress && rounds < kMaximumRounds);
 
 	if (!state->metal_target)
 	{
@@ -559,53 +1492,76 @@ static void glsl_type_to_optimizer_desc(const glsl_type* type, glsl_precision pr
 	}
 }
 
+static void add_shader_variable(glslopt_shader* sh, glslopt_shader_var* vars, int* count, ir_variable* var)
+{
+	glslopt_shader_var& v = vars[*count];
+	v.name = ralloc_strdup(sh, var->name);
+	glsl_type_to_optimizer_desc(var->type, (glsl_precision)var->data.precision, &v);
+	v.location = var->data.explicit_location ? var->data.location : -1;
+	++*count;
+}
+
 static void find_shader_variables(glslopt_shader* sh, exec_list* ir)
 {
+	// Count first, so that reflection arrays can be allocated at their exact size
+	int inputCount = 0, uniformCount = 0, textureCount = 0;
 	foreach_in_list(ir_instruction, node, ir)
 	{
 		ir_variable* const var = node->as_variable();
 		if (var == NULL)
 			continue;
 		if (var->data.mode == ir_var_shader_in)
-		{
-			if (sh->inputCount >= glslopt_shader::kMaxShaderInputs)
-				continue;
-
-			glslopt_shader_var& v = sh->inputs[sh->inputCount];
-			v.name = ralloc_strdup(sh, var->name);
-			glsl_type_to_optimizer_desc(var->type, (glsl_precision)var->data.precision, &v);
-			v.location = var->data.explicit_location ? var->data.location : -1;
-			++sh->inputCount;
-		}
-		if (var->data.mode == ir_var_uniform && !var->type->is_sampler())
-		{
-			if (sh->uniformCount >= glslopt_shader::kMaxShaderUniforms)
-				continue;
-			
-			glslopt_shader_var& v = sh->uniforms[sh->uniformCount];
-			v.name = ralloc_strdup(sh, var->name);
-			glsl_type_to_optimizer_desc(var->type, (glsl_precision)var->data.precision, &v);
-			v.location = var->data.explicit_location ? var->data.location : -1;
-			++sh->uniformCount;
-		}
-		if (var->data.mode == ir_var_uniform && var->type->is_sampler())
-		{
-			if (sh->textureCount >= glslopt_shader::kMaxShaderTextures)
-				continue;
-			
-			glslopt_shader_var& v = sh->textures[sh->textureCount];
-			v.name = ralloc_strdup(sh, var->name);
-			glsl_type_to_optimizer_desc(var->type, (glsl_precision)var->data.precision, &v);
-			v.location = var->data.explicit_location ? var->data.location : -1;
-			++sh->textureCount;
-		}
+			++inputCount;
+		else if (var->data.mode == ir_var_uniform && !var->type->is_sampler())
+			++uniformCount;
+		else if (var->data.mode == ir_var_uniform)
+			++textureCount;
+	}
+	if (inputCount)
+		sh->inputs = ralloc_array(sh, glslopt_shader_var, inputCount);
+	if (uniformCount)
+		sh->uniforms = ralloc_array(sh, glslopt_shader_var, uniformCount);
+	if (textureCount)
+		sh->textures = ralloc_array(sh, glslopt_shader_var, textureCount);
+
+	foreach_in_list(ir_instruction, node, ir)
+	{
+		ir_variable* const var = node->as_variable();
+		if (var == NULL)
+			continue;
+		if (var->data.mode == ir_var_shader_in)
+			add_shader_variable(sh, sh->inputs, &sh->inputCount, var);
+		else if (var->data.mode == ir_var_uniform && !var->type->is_sampler())
+			add_shader_variable(sh, sh->uniforms, &sh->uniformCount, var);
+		else if (var->data.mode == ir_var_uniform)
+			add_shader_variable(sh, sh->textures, &sh->textureCount, var);
 	}
 }
 
 
 glslopt_shader* glslopt_optimize (glslopt_ctx* ctx, glslopt_shader_type type, const char* shaderSource, unsigned options)
 {
-	glslopt_shader* shader = new (ctx->mem_ctx) glslopt_shader ();
+	return glslopt_optimize_n (ctx, type, shaderSource, strlen (shaderSource), options);
+}
+
+// The IR and symbols of a compile live in its arena; the shader must not point
+// at them once it's gone.
+static void free_compile_arena (glslopt_shader* shader, void* mem_ctx)
+{
+	shader->shader->ir = NULL;
+	shader->shader->symbols = NULL;
+	ralloc_free (mem_ctx);
+}
+
+// defines: #define lines to preprocess the source with; tokens: the source as
+// glcpp_token_cache_create lexed it, or NULL to lex it here; prelude: what the
+// source follows, or NULL. Returns NULL if the source can't be compiled from
+// the prelude's snapshot, and has to be pasted after the prelude instead.
+static glslopt_shader* compile_shader (glslopt_ctx* ctx, glslopt_shader_type type, const char* shaderSource, size_t shaderLength, unsigned options, const char* defines, const glcpp_token_cache* tokens, const glslopt_prelude* prelude)
+{
+	mtx_lock (&ctx->mem_lock);
+	glslopt_shader* shader = new (ctx->mem_ctx) glslopt_shader (ctx);
+	mtx_unlock (&ctx->mem_lock);
 
 	PrintGlslMode printMode = kPrintGlslVertex;
 	switch (type) {
@@ -626,36 +1582,104 @@ glslopt_shader* glslopt_optimize (glslopt_ctx* ctx, glslopt_shader_type type, co
 		shader->status = false;
 		return shader;
 	}
+	const prelude_stage* ps = NULL;
+	if (prelude)
+	{
+		ps = prelude->stages[shader->shader->Stage];
+		if (!ps || (options & kGlslOptionSkipPreprocessor))
+		{
+			glslopt_shader_delete (shader);
+			return NULL;
+		}
+	}
+	glslopt_profile* profile = NULL;
+	if (ctx->profiling)
+		profile = shader->profile = rzalloc (shader, glslopt_profile);
 
-	_mesa_glsl_parse_state* state = new (shader) _mesa_glsl_parse_state (&ctx->mesa_ctx, shader->shader->Stage, shader);
-	if (ctx->target == kGlslTargetMetal)
-		state->metal_target = true;
+	// Everything that does not outlive the compile lives in an arena that is
+	// released in one go at the end; the results are copied into the shader.
+	void* mem_ctx = ralloc_arena_context (NULL);
+
+	_mesa_glsl_parse_state* state;
+	if (ps)
+	{
+		state = _mesa_glsl_parse_state_after_prelude (ps->state, mem_ctx);
+		state->symbols = ps->state->parse_symbols->clone (mem_ctx, NULL);
+	}
+	else
+	{
+		state = new (mem_ctx) _mesa_glsl_parse_state (&ctx->mesa_ctx, shader->shader->Stage, mem_ctx);
+		if (ctx->target == kGlslTargetMetal)
+			state->metal_target = true;
+	}
 	state->error = 0;
 
 	if (!(options & kGlslOptionSkipPreprocessor))
 	{
-		state->error = !!glcpp_preprocess (state, &shaderSource, &state->info_log, state->extensions, &ctx->mesa_ctx);
+		{
+			profile_phase_scope timer (profile, kPhasePreprocess);
+			state->error = !!glcpp_preprocess_variant (state, &shaderSource, shaderLength, ps ? ps->macros : NULL, defines, tokens, &state->info_log, state->extensions, &ctx->mesa_ctx);
+		}
 		if (state->error)
 		{
 			shader->status = !state->error;
-			shader->infoLog = state->info_log;
+			shader->infoLog = ralloc_strdup (shader, state->info_log);
+			free_compile_arena (shader, mem_ctx);
+			return shader;
+		}
+		shaderLength = strlen (shaderSource);
+	}
+
+	unsigned char cacheKey[kCacheKeySize];
+	if (ctx->cache)
+	{
+		cache_compute_key (ctx, shader->shader->Stage, shaderSource, shaderLength, options, ps ? prelude->hash : NULL, cacheKey);
+		if (cache_lookup (ctx->cache, cacheKey, shader))
+		{
+			free_compile_arena (shader, mem_ctx);
 			return shader;
 		}
 	}
 
-	_mesa_glsl_lexer_ctor (state, shaderSource);
-	_mesa_glsl_parse (state);
-	_mesa_glsl_lexer_dtor (state);
+	{
+		profile_phase_scope timer (profile, kPhaseParse);
+		// The preprocessor's output is ours, the lexer can scan it in place;
+		// the caller's source is read from where it is
+		if (options & kGlslOptionSkipPreprocessor)
+			_mesa_glsl_lexer_ctor_n (state, shaderSource, shaderLength);
+		else
+			_mesa_glsl_lexer_ctor_in_place (state, (char*)shaderSource);
+		_mesa_glsl_parse (state);
+		_mesa_glsl_lexer_dtor (state);
+	}
+
+	// The prelude was converted with the extensions and invariance it left
+	// enabled; a shader that changes those has to be converted along with it
+	if (ps && !state->error && (state->all_invariant != ps->state->all_invariant || !_mesa_glsl_same_extension_behavior (state, ps->state)))
+	{
+		glslopt_shader_delete (shader);
+		ralloc_free (mem_ctx);
+		return NULL;
+	}
 
-	exec_list* ir = new (shader) exec_list();
+	exec_list* ir = new (mem_ctx) exec_list();
 	shader->shader->ir = ir;
 
-	if (!state->error && !state->translation_unit.is_empty())
+	if (!state->error && ps)
+	{
+		profile_phase_scope timer (profile, kPhaseAstToHir);
+		_mesa_ast_to_hir_after_prelude (ir, state, ps->ir, ps->state->symbols);
+	}
+	else if (!state->error && !state->translation_unit.is_empty())
+	{
+		profile_phase_scope timer (profile, kPhaseAstToHir);
 		_mesa_ast_to_hir (ir, state);
+	}
 
 	// Un-optimized output
 	if (!state->error) {
 		validate_ir_tree(ir);
+		profile_phase_scope timer (profile, kPhasePrint);
 		if (ctx->target == kGlslTargetMetal)
 			shader->rawOutput = _mesa_print_ir_metal(ir, state, ralloc_strdup(shader, ""), printMode, &shader->uniformsSize);
 		else
@@ -670,15 +1694,19 @@ glslopt_shader* glslopt_optimize (glslopt_ctx* ctx, glslopt_shader_type type, co
 
 	if (!state->error && !ir->is_empty() && !(options & kGlslOptionNotFullShader))
 	{
-		linked_shader = link_intrastage_shaders(shader,
-												&ctx->mesa_ctx,
-												shader->whole_program,
-												shader->whole_program->Shaders,
-												shader->whole_program->NumShaders);
+		{
+			profile_phase_scope timer (profile, kPhaseLink);
+			linked_shader = link_intrastage_shaders(mem_ctx,
+													&ctx->mesa_ctx,
+													shader->whole_program,
+													shader->whole_program->Shaders,
+													shader->whole_program->NumShaders);
+		}
 		if (!linked_shader)
 		{
 			shader->status = false;
 			shader->infoLog = shader->whole_program->InfoLog;
+			free_compile_arena (shader, mem_ctx);
 			return shader;
 		}
 		ir = linked_shader->ir;
@@ -690,13 +1718,18 @@ glslopt_shader* glslopt_optimize (glslopt_ctx* ctx, glslopt_shader_type type, co
 	if (!state->error && !ir->is_empty())
 	{		
 		const bool linked = !(options & kGlslOptionNotFullShader);
-		do_optimization_passes(ir, linked, state, shader);
+		const bool limitPressure = (options & kGlslOptionLimitRegisterPressure) != 0;
+		{
+			profile_phase_scope timer (profile, kPhaseOptimize);
+			do_optimization_passes(ir, linked, limitPressure, state, mem_ctx, profile);
+		}
 		validate_ir_tree(ir);
 	}	
 	
 	// Final optimized output
 	if (!state->error)
 	{
+		profile_phase_scope timer (profile, kPhasePrint);
 		if (ctx->target == kGlslTargetMetal)
 			shader->optimizedOutput = _mesa_print_ir_metal(ir, state, ralloc_strdup(shader, ""), printMode, &shader->uniformsSize);
 		else
@@ -704,23 +1737,254 @@ glslopt_shader* glslopt_optimize (glslopt_ctx* ctx, glslopt_shader_type type, co
 	}
 
 	shader->status = !state->error;
-	shader->infoLog = state->info_log;
+	shader->infoLog = ralloc_strdup (shader, state->info_log);
 
 	find_shader_variables (shader, ir);
 	if (!state->error)
+	{
 		calculate_shader_stats (ir, &shader->statsMath, &shader->statsTex, &shader->statsFlow);
+		calculate_shader_cost (ir, ctx->target, &shader->cost);
+	}
 
-	ralloc_free (ir);
-	ralloc_free (state);
+	if (ctx->cache)
+		cache_store (ctx->cache, cacheKey, shader);
 
+	// The linked shader may own memory from the arena, so it has to go first.
 	if (linked_shader)
 		ralloc_free(linked_shader);
+	free_compile_arena (shader, mem_ctx);
+
+	return shader;
+}
+
+
+static glslopt_shader* optimize_shader (glslopt_ctx* ctx, glslopt_shader_type type, const char* shaderSource, size_t shaderLength, unsigned options, const char* defines, const glcpp_token_cache* tokens)
+{
+	glslopt_shader* shader = compile_shader (ctx, type, shaderSource, shaderLength, options, defines, tokens, ctx->prelude);
+	if (shader)
+		return shader;
 
+	char* pasted = prelude_paste (ctx->prelude, defines, shaderSource, shaderLength);
+	shader = compile_shader (ctx, type, pasted, strlen (pasted), options, NULL, NULL, NULL);
+	ralloc_free (pasted);
 	return shader;
 }
 
+
+glslopt_shader* glslopt_optimize_n (glslopt_ctx* ctx, glslopt_shader_type type, const char* shaderSource, size_t shaderLength, unsigned options)
+{
+	return optimize_shader (ctx, type, shaderSource, shaderLength, options, NULL, NULL);
+}
+
+
+// Batch optimization: jobs are spread over a pool of workers with
+// work stealing. Each worker starts out owning a contiguous range of jobs
+// and takes them from the front; a worker that runs out steals the back half
+// of another worker's remaining range. Shader sizes vary a lot, so this
+// keeps all cores busy without having to estimate job costs upfront.
+
+struct batch_queue
+{
+	mtx_t lock;
+	int begin, end; // jobs [begin,end) not started yet
+};
+
+// A variant sweep: job i is the shader with defineSets[i]
+struct variant_sweep
+{
+	glslopt_shader_type type;
+	const char* source;
+	size_t length;
+	const char* const* defineSets;
+	unsigned options;
+	const glcpp_token_cache* tokens; // NULL if the source has to be lexed for each variant
+};
+
+struct batch_state
+{
+	glslopt_ctx* ctx;
+	const glslopt_job* jobs; // or
+	const variant_sweep* sweep;
+	glslopt_shader** outShaders;
+	batch_queue* queues;
+	int queueCount;
+};
+
+struct batch_worker
+{
+	batch_state* batch;
+	int index;
+};
+
+static int batch_pop (batch_queue* q)
+{
+	int job = -1;
+	mtx_lock (&q->lock);
+	if (q->begin < q->end)
+		job = q->begin++;
+	mtx_unlock (&q->lock);
+	return job;
+}
+
+static bool batch_steal (batch_state* b, int thief)
+{
+	for (int i = 1; i < b->queueCount; ++i)
+	{
+		batch_queue* victim = &b->queues[(thief + i) % b->queueCount];
+		mtx_lock (&victim->lock);
+		const int left = victim->end - victim->begin;
+		if (left <= 0)
+		{
+			mtx_unlock (&victim->lock);
+			continue;
+		}
+		const int stolenEnd = victim->end;
+		victim->end -= (left + 1) / 2;
+		const int stolenBegin = victim->end;
+		mtx_unlock (&victim->lock);
+
+		batch_queue* own = &b->queues[thief];
+		mtx_lock (&own->lock);
+		own->begin = stolenBegin;
+		own->end = stolenEnd;
+		mtx_unlock (&own->lock);
+		return true;
+	}
+	return false;
+}
+
+static void batch_run_job (batch_state* b, int job)
+{
+	const variant_sweep* v = b->sweep;
+	if (v)
+		b->outShaders[job] = optimize_shader (b->ctx, v->type, v->source, v->length, v->options, v->defineSets[job], v->tokens);
+	else
+		b->outShaders[job] = glslopt_optimize (b->ctx, b->jobs[job].type, b->jobs[job].shaderSource, b->jobs[job].options);
+}
+
+static int batch_worker_main (void* data)
+{
+	batch_worker* w = (batch_worker*)data;
+	batch_state* b = w->batch;
+	for (;;)
+	{
+		const int job = batch_pop (&b->queues[w->index]);
+		if (job < 0)
+		{
+			// jobs never get added, so if there's nothing to steal we're done
+			if (!batch_steal (b, w->index))
+				break;
+			continue;
+		}
+		batch_run_job (b, job);
+	}
+	return 0;
+}
+
+static int get_cpu_count ()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo (&info);
+	return (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	return (int)sysconf (_SC_NPROCESSORS_ONLN);
+#else
+	return 1;
+#endif
+}
+
+static void batch_run (batch_state& b, int jobCount, int threadCount)
+{
+	if (threadCount <= 0)
+		threadCount = get_cpu_count ();
+	if (threadCount > jobCount)
+		threadCount = jobCount;
+	if (threadCount <= 1)
+	{
+		for (int i = 0; i < jobCount; ++i)
+			batch_run_job (&b, i);
+		return;
+	}
+
+	batch_queue* queues = new batch_queue[threadCount];
+	batch_worker* workers = new batch_worker[threadCount];
+	thrd_t* threads = new thrd_t[threadCount];
+	bool* started = new bool[threadCount];
+
+	b.queues = queues;
+	b.queueCount = threadCount;
+	for (int i = 0; i < threadCount; ++i)
+	{
+		mtx_init (&queues[i].lock, mtx_plain);
+		queues[i].begin = (int)((long long)jobCount * i / threadCount);
+		queues[i].end = (int)((long long)jobCount * (i + 1) / threadCount);
+		workers[i].batch = &b;
+		workers[i].index = i;
+	}
+
+	// calling thread works as worker #0; if some thread can't be created,
+	// the others will steal its jobs
+	for (int i = 1; i < threadCount; ++i)
+		started[i] = thrd_create (&threads[i], batch_worker_main, &workers[i]) == thrd_success;
+	batch_worker_main (&workers[0]);
+	for (int i = 1; i < threadCount; ++i)
+	{
+		if (started[i])
+			thrd_join (threads[i], NULL);
+	}
+
+	for (int i = 0; i < threadCount; ++i)
+		mtx_destroy (&queues[i].lock);
+	delete[] started;
+	delete[] threads;
+	delete[] workers;
+	delete[] queues;
+}
+
+void glslopt_optimize_batch (glslopt_ctx* ctx, const glslopt_job* jobs, int jobCount, glslopt_shader** outShaders, int threadCount)
+{
+	batch_state b;
+	b.ctx = ctx;
+	b.jobs = jobs;
+	b.sweep = NULL;
+	b.outShaders = outShaders;
+	batch_run (b, jobCount, threadCount);
+}
+
+void glslopt_optimize_variants (glslopt_ctx* ctx, glslopt_shader_type type, const char* shaderSource, size_t shaderLength, const char* const* defineSets, int variantCount, unsigned options, glslopt_shader** outShaders, int threadCount)
+{
+	// Lex the source once; each variant only parses the tokens, with its
+	// own macros deciding the #ifs and expansions. Sources the lexer
+	// can't record that way get lexed for every variant instead.
+	glcpp_token_cache* tokens = glcpp_token_cache_create (NULL, shaderSource, shaderLength, &ctx->mesa_ctx);
+
+	variant_sweep v;
+	v.type = type;
+	v.source = shaderSource;
+	v.length = shaderLength;
+	v.defineSets = defineSets;
+	v.options = options & ~kGlslOptionSkipPreprocessor;
+	v.tokens = tokens;
+
+	batch_state b;
+	b.ctx = ctx;
+	b.jobs = NULL;
+	b.sweep = &v;
+	b.outShaders = outShaders;
+	batch_run (b, variantCount, threadCount);
+
+	ralloc_free (tokens);
+}
+
 void glslopt_shader_delete (glslopt_shader* shader)
 {
+	// detach from the context under its lock; the rest of the teardown only
+	// touches memory owned by the shader itself
+	glslopt_ctx* ctx = shader->ctx;
+	mtx_lock (&ctx->mem_lock);
+	ralloc_steal (NULL, shader);
+	mtx_unlock (&ctx->mem_lock);
 	delete shader;
 }
 
@@ -800,9 +2064,41 @@ void glslopt_shader_get_texture_desc (glslopt_shader* shader, int index, const c
 	*outLocation = v.location;
 }
 
+int glslopt_shader_get_profile_count (glslopt_shader* shader)
+{
+	return shader->profile ? kPhaseCount + kPassCount : 0;
+}
+
+void glslopt_shader_get_profile (glslopt_shader* shader, int index, const char** outName, double* outMilliseconds, int* outInvocations, int* outProgress)
+{
+	static const glslopt_profile_entry kNoEntry = { 0.0, 0, 0 };
+	const bool valid = index >= 0 && index < glslopt_shader_get_profile_count (shader);
+	const glslopt_profile_entry& e = !valid ? kNoEntry : index < kPhaseCount ? shader->profile->phases[index] : shader->profile->passes[index - kPhaseCount];
+	if (outName)
+		*outName = !valid ? NULL : index < kPhaseCount ? kPhaseNames[index] : kPassNames[index - kPhaseCount];
+	if (outMilliseconds)
+		*outMilliseconds = e.ms;
+	if (outInvocations)
+		*outInvocations = e.invocations;
+	if (outProgress)
+		*outProgress = e.progress;
+}
+
+const char* glslopt_shader_get_profile_json (glslopt_shader* shader)
+{
+	if (!shader->profile)
+		return NULL;
+	return profile_to_json (shader->profile);
+}
+
 void glslopt_shader_get_stats (glslopt_shader* shader, int* approxMath, int* approxTex, int* approxFlow)
 {
 	*approxMath = shader->statsMath;
 	*approxTex = shader->statsTex;
 	*approxFlow = shader->statsFlow;
 }
+
+void glslopt_shader_get_cost (glslopt_shader* shader, glslopt_shader_cost* outCost)
+{
+	*outCost = shader->cost;
+}
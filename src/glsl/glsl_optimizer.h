@@ -19,8 +19,14 @@
    glslopt_shader_delete (shader);
  }
  glslopt_cleanup (ctx);
+
+ glslopt_optimize can be called from multiple threads at once, with either
+ one context per thread or a shared one. glslopt_optimize_batch does that
+ for you on an internal thread pool.
 */
 
+#include <stddef.h>
+
 struct glslopt_shader;
 struct glslopt_ctx;
 
@@ -33,6 +39,7 @@ enum glslopt_shader_type {
 enum glslopt_options {
 	kGlslOptionSkipPreprocessor = (1<<0), // Skip preprocessing shader source. Saves some time if you know you don't need it.
 	kGlslOptionNotFullShader = (1<<1), // Passed shader is not the full shader source. This makes some optimizations weaker.
+	kGlslOptionLimitRegisterPressure = (1<<2), // Don't fold temporaries into their use where that raises peak register pressure (see glslopt_shader_cost::liveComponents).
 };
 
 // Optimizer target language
@@ -68,7 +75,63 @@ void glslopt_cleanup (glslopt_ctx* ctx);
 
 void glslopt_set_max_unroll_iterations (glslopt_ctx* ctx, unsigned iterations);
 
+// Function inlining budget; by default every call gets inlined. With a maxGrowth, calls to a function are
+// only inlined if that adds at most maxGrowth instructions in total (the function body is gone afterwards),
+// or if the function has at most maxCalleeSize instructions; other functions stay functions. Each constant
+// argument of a call counts as making the callee constantArgBonus percent smaller. A maxGrowth of 0 is a
+// budget like any other (only calls that don't grow the shader); pass kGlslInlineAll to inline everything
+// again. Metal output always inlines everything.
+static const unsigned kGlslInlineAll = 0xFFFFFFFF;
+void glslopt_set_inline_budget (glslopt_ctx* ctx, unsigned maxGrowth, unsigned maxCalleeSize, unsigned constantArgBonus);
+
+// Optional profiling. When on, each optimized shader records wall time and invocation counts of the
+// compile phases (preprocess, parse, AST to HIR, link, optimize, print) and of every optimization pass;
+// see glslopt_shader_get_profile. Not to be called while other threads use the context.
+void glslopt_set_profiling (glslopt_ctx* ctx, bool enable);
+
+// Optional prelude: source, like a common header, that every shader optimized with the context follows,
+// as if it was pasted in front of each of them. It is preprocessed, parsed and converted only once, here;
+// each shader then continues from a copy of what that left. Results are those of the prelude, any defines
+// and the shader pasted together, except that line numbers in the log count from the shader's own first
+// line. Shaders that change the enabled extensions or #pragma invariant(all), and those compiled with
+// kGlslOptionSkipPreprocessor, get the prelude pasted in front of them for real. Pass NULL to remove the
+// prelude. Not to be called while other threads use the context.
+void glslopt_set_prelude (glslopt_ctx* ctx, const char* preludeSource);
+
+// Optional result cache. Optimizing the same (preprocessed) source again with the same shader type,
+// options, unroll limit and inline budget returns a copy of the earlier result, without parsing or optimizing anything.
+// memoryEntries: how many results to keep in memory; least recently used ones get evicted.
+// diskPath: directory (must exist) for an additional persistent cache tier; NULL for memory only.
+// Pass 0 and NULL to turn the cache off. Not to be called while other threads use the context.
+void glslopt_set_cache (glslopt_ctx* ctx, int memoryEntries, const char* diskPath);
+void glslopt_get_cache_stats (glslopt_ctx* ctx, int* outHits, int* outMisses);
+
 glslopt_shader* glslopt_optimize (glslopt_ctx* ctx, glslopt_shader_type type, const char* shaderSource, unsigned options);
+// The same for shaderLength characters at shaderSource, which need not be NUL-terminated (say, a slice of
+// a memory-mapped shader pack). They are read where they are, without copying the whole source first,
+// and only during the call; read-only memory is fine.
+glslopt_shader* glslopt_optimize_n (glslopt_ctx* ctx, glslopt_shader_type type, const char* shaderSource, size_t shaderLength, unsigned options);
+
+// One shader to optimize with glslopt_optimize_batch
+struct glslopt_job {
+	glslopt_shader_type type;
+	const char* shaderSource;
+	unsigned options;
+};
+
+// Optimizes jobCount shaders on a pool of threadCount worker threads (0: one per CPU core).
+// outShaders[i] receives the result of jobs[i], exactly as if glslopt_optimize was called on it;
+// delete each of them with glslopt_shader_delete.
+void glslopt_optimize_batch (glslopt_ctx* ctx, const glslopt_job* jobs, int jobCount, glslopt_shader** outShaders, int threadCount);
+
+// Optimizes variantCount variants of one shader, each with the macros of defineSets[i] (a bunch
+// of #define lines, like "#define FOG 1\n#define SHADOWS\n"; NULL or "" for none), on threadCount
+// worker threads as above. outShaders[i] receives what glslopt_optimize_n would give for the
+// source with defineSets[i] pasted in front, except that the defines neither move #version off
+// the first line nor shift line numbers in the log. The source is only tokenized once for all
+// variants; kGlslOptionSkipPreprocessor is ignored.
+void glslopt_optimize_variants (glslopt_ctx* ctx, glslopt_shader_type type, const char* shaderSource, size_t shaderLength, const char* const* defineSets, int variantCount, unsigned options, glslopt_shader** outShaders, int threadCount);
+
 bool glslopt_get_status (glslopt_shader* shader);
 const char* glslopt_get_output (glslopt_shader* shader);
 const char* glslopt_get_raw_output (glslopt_shader* shader);
@@ -87,5 +150,32 @@ void glslopt_shader_get_texture_desc (glslopt_shader* shader, int index, const c
 // Number of math, texture and flow control instructions.
 void glslopt_shader_get_stats (glslopt_shader* shader, int* approxMath, int* approxTex, int* approxFlow);
 
+// Static cost estimate of one invocation of the optimized shader, from per-target tables of
+// ALU (by operation, vector width and precision), texture and branch costs. Loops count
+// as many iterations as can be proven (8 when unknown); an if counts its more expensive branch.
+// Meant for ranking variants of a shader against each other, not as absolute timings.
+struct glslopt_shader_cost {
+	float cycles; // aluCycles + textureCycles + flowCycles
+	float aluCycles;
+	float textureCycles;
+	float flowCycles;
+	int textureFetches;
+	int dependentFetches; // fetches with coordinates computed in the shader, not taken straight from an input
+	int textureDepth; // longest chain of fetches whose coordinates depend on an earlier fetch; 1 if none do
+	int liveComponents; // peak number of simultaneously live scalar components, over all functions
+	int liveVec4s; // the same as vec4 registers: each live vector takes a whole one, each matrix column one
+};
+void glslopt_shader_get_cost (glslopt_shader* shader, glslopt_shader_cost* outCost);
+
+// Profile of the compile, when the context had profiling on (otherwise count is 0).
+// Compile phases come first, then optimization passes in the order they run. Progress is
+// how many of the invocations changed the shader (always 0 for phases).
+// Results returned from the result cache only have the preprocess phase filled in. Any out pointer
+// may be NULL; an index out of range gives a NULL name and zeros.
+int glslopt_shader_get_profile_count (glslopt_shader* shader);
+void glslopt_shader_get_profile (glslopt_shader* shader, int index, const char** outName, double* outMilliseconds, int* outInvocations, int* outProgress);
+// The same profile as a JSON object, or NULL when profiling was off.
+const char* glslopt_shader_get_profile_json (glslopt_shader* shader);
+
 
 #endif /* GLSL_OPTIMIZER_H */
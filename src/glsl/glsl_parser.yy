@@ -305,7 +305,10 @@ translation_unit:
    }
    external_declaration_list
    {
-      delete state->symbols;
+      if (state->keep_parse_symbols)
+         state->parse_symbols = state->symbols;
+      else
+         delete state->symbols;
       state->symbols = new(ralloc_parent(state)) glsl_symbol_table;
       _mesa_glsl_initialize_types(state);
    }
@@ -63,8 +63,12 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    this->stage = stage;
 
    this->scanner = NULL;
+   this->lexer_input = NULL;
+   this->lexer_input_length = 0;
    this->translation_unit.make_empty();
    this->symbols = new(mem_ctx) glsl_symbol_table;
+   this->keep_parse_symbols = false;
+   this->parse_symbols = NULL;
 
    this->info_log = ralloc_strdup(mem_ctx, "");
    this->error = false;
@@ -217,6 +221,41 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
       ctx->Const.AllowGLSLExtensionDirectiveMidShader;
 }
 
+_mesa_glsl_parse_state *
+_mesa_glsl_parse_state_after_prelude(const _mesa_glsl_parse_state *prelude,
+                                     void *mem_ctx)
+{
+   _mesa_glsl_parse_state *state =
+      new(mem_ctx) _mesa_glsl_parse_state(*prelude);
+
+   state->scanner = NULL;
+   state->lexer_input = NULL;
+   state->lexer_input_length = 0;
+   state->translation_unit.make_empty();
+   state->symbols = NULL;
+   state->keep_parse_symbols = false;
+   state->parse_symbols = NULL;
+
+   /* Whatever the shader may change in place has to be its own. */
+   state->default_uniform_qualifier =
+      new(state) ast_type_qualifier(*prelude->default_uniform_qualifier);
+   state->in_qualifier = new(state) ast_type_qualifier(*prelude->in_qualifier);
+   state->out_qualifier =
+      new(state) ast_type_qualifier(*prelude->out_qualifier);
+   if (prelude->num_user_structures != 0) {
+      state->user_structures = ralloc_array(state, const glsl_type *,
+                                            prelude->num_user_structures);
+      memcpy(state->user_structures, prelude->user_structures,
+             prelude->num_user_structures * sizeof(const glsl_type *));
+   }
+
+   /* The prelude compiled, so this only has its warnings. */
+   state->info_log = ralloc_strdup(mem_ctx, prelude->info_log);
+   state->error = false;
+
+   return state;
+}
+
 /**
  * Determine whether the current GLSL version is sufficiently high to support
  * a certain feature, and generate an error message if it isn't.
@@ -617,6 +656,20 @@ void _mesa_glsl_extension::set_flags(_mesa_glsl_parse_state *state,
    state->*(this->warn_flag)   = (behavior == extension_warn);
 }
 
+bool
+_mesa_glsl_same_extension_behavior(const _mesa_glsl_parse_state *a,
+                                   const _mesa_glsl_parse_state *b)
+{
+   for (unsigned i = 0; i < Elements(_mesa_glsl_supported_extensions); ++i) {
+      const _mesa_glsl_extension *extension
+         = &_mesa_glsl_supported_extensions[i];
+      if (a->*(extension->enable_flag) != b->*(extension->enable_flag) ||
+          a->*(extension->warn_flag) != b->*(extension->warn_flag))
+         return false;
+   }
+   return true;
+}
+
 /**
  * Find an extension by name in _mesa_glsl_supported_extensions.  If
  * the name is not found, return NULL.
@@ -1459,7 +1512,7 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
                              &ctx->Extensions, ctx);
 
    if (!state->error) {
-     _mesa_glsl_lexer_ctor(state, source);
+     _mesa_glsl_lexer_ctor_in_place(state, (char *) source);
      _mesa_glsl_parse(state);
      _mesa_glsl_lexer_dtor(state);
    }
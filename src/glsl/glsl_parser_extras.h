@@ -208,9 +208,19 @@ struct _mesa_glsl_parse_state {
 
    struct gl_context *const ctx;
    void *scanner;
+   /** What the lexer has yet to read, see _mesa_glsl_lexer_ctor_n */
+   const char *lexer_input;
+   size_t lexer_input_length;
    exec_list translation_unit;
    glsl_symbol_table *symbols;
 
+   /**
+    * The parser throws away the symbols it found once done with the
+    * translation unit, unless this is set; then they are kept here.
+    */
+   bool keep_parse_symbols;
+   glsl_symbol_table *parse_symbols;
+
    unsigned num_supported_versions;
    struct {
       unsigned ver;
@@ -548,6 +558,22 @@ extern void _mesa_glsl_warning(const YYLTYPE *locp,
 extern void _mesa_glsl_lexer_ctor(struct _mesa_glsl_parse_state *state,
 				  const char *string);
 
+/**
+ * Like \c _mesa_glsl_lexer_ctor, for \c length characters of \c string,
+ * which need not be NUL-terminated.  They are read while parsing, without
+ * being copied first.
+ */
+extern void _mesa_glsl_lexer_ctor_n(struct _mesa_glsl_parse_state *state,
+				    const char *string, size_t length);
+
+/**
+ * Like \c _mesa_glsl_lexer_ctor, but scans \c string where it is rather
+ * than copying it.  It has to end in two NULs, as the output of
+ * glcpp_preprocess does.
+ */
+extern void _mesa_glsl_lexer_ctor_in_place(struct _mesa_glsl_parse_state *state,
+					   char *string);
+
 extern void _mesa_glsl_lexer_dtor(struct _mesa_glsl_parse_state *state);
 
 union YYSTYPE;
@@ -568,6 +594,23 @@ extern bool _mesa_glsl_process_extension(const char *name, YYLTYPE *name_locp,
 					 YYLTYPE *behavior_locp,
 					 _mesa_glsl_parse_state *state);
 
+/**
+ * Whether two parser states enable and warn about the same extensions.
+ */
+extern bool
+_mesa_glsl_same_extension_behavior(const _mesa_glsl_parse_state *a,
+                                   const _mesa_glsl_parse_state *b);
+
+/**
+ * Make the parser state for compiling a shader that follows a prelude: all
+ * that parsing the prelude and \c _mesa_ast_to_hir_prelude left in its
+ * state, except for its AST and symbols.  The prelude's state is only read,
+ * and must outlive the new one.
+ */
+extern _mesa_glsl_parse_state *
+_mesa_glsl_parse_state_after_prelude(const _mesa_glsl_parse_state *prelude,
+                                     void *mem_ctx);
+
 #endif /* __cplusplus */
 
 
@@ -588,6 +631,28 @@ _mesa_shader_stage_to_string(unsigned stage);
 extern int glcpp_preprocess(void *ctx, const char **shader, char **info_log,
                       const struct gl_extensions *extensions, struct gl_context *gl_ctx);
 
+extern int glcpp_preprocess_n(void *ctx, const char **shader, size_t length,
+                      char **info_log, const struct gl_extensions *extensions,
+                      struct gl_context *gl_ctx);
+
+struct glcpp_token_cache;
+
+extern struct glcpp_token_cache *
+glcpp_token_cache_create(void *ctx, const char *shader, size_t length,
+                         struct gl_context *gl_ctx);
+
+struct glcpp_prelude;
+
+extern int glcpp_preprocess_prelude(void *ctx, const char **shader, size_t length,
+                      char **info_log, const struct gl_extensions *extensions,
+                      struct gl_context *gl_ctx, struct glcpp_prelude **prelude);
+
+extern int glcpp_preprocess_variant(void *ctx, const char **shader, size_t length,
+                      const struct glcpp_prelude *prelude,
+                      const char *defines, const struct glcpp_token_cache *tokens,
+                      char **info_log, const struct gl_extensions *extensions,
+                      struct gl_context *gl_ctx);
+
 extern void _mesa_destroy_shader_compiler(void);
 extern void _mesa_destroy_shader_compiler_caches(void);
 
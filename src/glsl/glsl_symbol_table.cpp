@@ -23,6 +23,7 @@
  */
 
 #include "glsl_symbol_table.h"
+#include "program/hash_table.h"
 
 class symbol_table_entry {
 public:
@@ -98,7 +99,7 @@ glsl_symbol_table::glsl_symbol_table()
 {
    this->separate_function_namespace = false;
    this->table = _mesa_symbol_table_ctor();
-   this->mem_ctx = ralloc_context(NULL);
+   this->mem_ctx = ralloc_arena_context(NULL);
 }
 
 glsl_symbol_table::~glsl_symbol_table()
@@ -234,6 +235,47 @@ symbol_table_entry *glsl_symbol_table::get_entry(const char *name)
       _mesa_symbol_table_find_symbol(table, -1, name);
 }
 
+struct symbol_table_clone_state {
+   void *mem_ctx;
+   struct hash_table *remap;
+};
+
+static void *
+clone_symbol_table_entry(void *data, void *closure)
+{
+   const symbol_table_clone_state *state =
+      (const symbol_table_clone_state *) closure;
+   symbol_table_entry *entry =
+      new(state->mem_ctx) symbol_table_entry(*(symbol_table_entry *) data);
+
+   if (state->remap != NULL) {
+      if (entry->v != NULL) {
+         ir_variable *v = (ir_variable *) hash_table_find(state->remap, entry->v);
+         if (v != NULL)
+            entry->v = v;
+      }
+      if (entry->f != NULL) {
+         ir_function *f = (ir_function *) hash_table_find(state->remap, entry->f);
+         if (f != NULL)
+            entry->f = f;
+      }
+   }
+   return entry;
+}
+
+glsl_symbol_table *
+glsl_symbol_table::clone(void *mem_ctx, struct hash_table *remap)
+{
+   glsl_symbol_table *copy = new(mem_ctx) glsl_symbol_table;
+   symbol_table_clone_state state = { copy->mem_ctx, remap };
+
+   copy->separate_function_namespace = this->separate_function_namespace;
+   _mesa_symbol_table_dtor(copy->table);
+   copy->table = _mesa_symbol_table_clone(this->table,
+                                          clone_symbol_table_entry, &state);
+   return copy;
+}
+
 void
 glsl_symbol_table::disable_variable(const char *name)
 {
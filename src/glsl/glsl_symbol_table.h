@@ -98,6 +98,13 @@ struct glsl_symbol_table {
     */
    void disable_variable(const char *name);
 
+   /**
+    * Make a copy of the table, with the same symbols in the same scopes.
+    * Variables and functions that are keys in \c remap (as filled in by
+    * \c clone_ir_list) are replaced by what they map to.
+    */
+   glsl_symbol_table *clone(void *mem_ctx, struct hash_table *remap);
+
 private:
    symbol_table_entry *get_entry(const char *name);
 
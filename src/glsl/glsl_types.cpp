@@ -34,6 +34,7 @@ hash_table *glsl_type::array_types = NULL;
 hash_table *glsl_type::record_types = NULL;
 hash_table *glsl_type::interface_types = NULL;
 void *glsl_type::mem_ctx = NULL;
+mtx_t glsl_type::mutex = _MTX_INITIALIZER_NP;
 
 void
 glsl_type::init_ralloc_type_ctx(void)
@@ -54,9 +55,14 @@ glsl_type::glsl_type(GLenum gl_type,
    vector_elements(vector_elements), matrix_columns(matrix_columns),
    length(0)
 {
+   mtx_lock(&glsl_type::mutex);
+
    init_ralloc_type_ctx();
    assert(name != NULL);
    this->name = ralloc_strdup(this->mem_ctx, name);
+
+   mtx_unlock(&glsl_type::mutex);
+
    /* Neither dimension is zero or both dimensions are zero.
     */
    assert((vector_elements == 0) == (matrix_columns == 0));
@@ -72,9 +78,14 @@ glsl_type::glsl_type(GLenum gl_type, glsl_base_type base_type,
    sampler_array(array), sampler_type(type), interface_packing(0),
    length(0)
 {
+   mtx_lock(&glsl_type::mutex);
+
    init_ralloc_type_ctx();
    assert(name != NULL);
    this->name = ralloc_strdup(this->mem_ctx, name);
+
+   mtx_unlock(&glsl_type::mutex);
+
    memset(& fields, 0, sizeof(fields));
 
    if (base_type == GLSL_TYPE_SAMPLER) {
@@ -96,6 +107,8 @@ glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
 {
    unsigned int i;
 
+   mtx_lock(&glsl_type::mutex);
+
    init_ralloc_type_ctx();
    assert(name != NULL);
    this->name = ralloc_strdup(this->mem_ctx, name);
@@ -112,6 +125,8 @@ glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
       this->fields.structure[i].sample = fields[i].sample;
       this->fields.structure[i].matrix_layout = fields[i].matrix_layout;
    }
+
+   mtx_unlock(&glsl_type::mutex);
 }
 
 glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
@@ -125,6 +140,8 @@ glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
 {
    unsigned int i;
 
+   mtx_lock(&glsl_type::mutex);
+
    init_ralloc_type_ctx();
    assert(name != NULL);
    this->name = ralloc_strdup(this->mem_ctx, name);
@@ -141,6 +158,8 @@ glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
       this->fields.structure[i].sample = fields[i].sample;
       this->fields.structure[i].matrix_layout = fields[i].matrix_layout;
    }
+
+   mtx_unlock(&glsl_type::mutex);
 }
 
 
@@ -288,6 +307,8 @@ const glsl_type *glsl_type::get_scalar_type() const
 void
 _mesa_glsl_release_types(void)
 {
+   mtx_lock(&glsl_type::mutex);
+
    if (glsl_type::array_types != NULL) {
       hash_table_dtor(glsl_type::array_types);
       glsl_type::array_types = NULL;
@@ -297,6 +318,13 @@ _mesa_glsl_release_types(void)
       hash_table_dtor(glsl_type::record_types);
       glsl_type::record_types = NULL;
    }
+
+   if (glsl_type::interface_types != NULL) {
+      hash_table_dtor(glsl_type::interface_types);
+      glsl_type::interface_types = NULL;
+   }
+
+   mtx_unlock(&glsl_type::mutex);
 }
 
 
@@ -319,7 +347,10 @@ glsl_type::glsl_type(const glsl_type *array, unsigned length) :
     * NUL.
     */
    const unsigned name_length = (unsigned)strlen(array->name) + 10 + 3;
+
+   mtx_lock(&glsl_type::mutex);
    char *const n = (char *) ralloc_size(this->mem_ctx, name_length);
+   mtx_unlock(&glsl_type::mutex);
 
    if (length == 0)
       snprintf(n, name_length, "%s[]", array->name);
@@ -452,15 +483,27 @@ glsl_type::get_instance(unsigned base_type, unsigned rows, unsigned columns)
 }
 
 
-const glsl_type *
-glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
+/**
+ * Frees a type that lost the race to get into one of the type tables.
+ *
+ * The constructors put the name and the record fields on the shared
+ * glsl_type::mem_ctx rather than on the type, so freeing the type alone
+ * would leak them.  Called with glsl_type::mutex held.
+ */
+static void
+discard_created_type(glsl_type *created)
 {
+   if (created->base_type == GLSL_TYPE_STRUCT ||
+       created->base_type == GLSL_TYPE_INTERFACE)
+      ralloc_free(created->fields.structure);
+   ralloc_free((void *) created->name);
+   ralloc_free(created);
+}
 
-   if (array_types == NULL) {
-      array_types = hash_table_ctor(64, hash_table_string_hash,
-				    hash_table_string_compare);
-   }
 
+const glsl_type *
+glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
+{
    /* Generate a name using the base type pointer in the key.  This is
     * done because the name of the base type may not be unique across
     * shaders.  For example, two shaders may have different record types
@@ -469,13 +512,34 @@ glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
    char key[128];
    snprintf(key, sizeof(key), "%p[%u]", (void *) base, array_size);
 
+   mtx_lock(&glsl_type::mutex);
+
+   if (array_types == NULL) {
+      array_types = hash_table_ctor(64, hash_table_string_hash,
+				    hash_table_string_compare);
+   }
+
    const glsl_type *t = (glsl_type *) hash_table_find(array_types, key);
    if (t == NULL) {
-      t = new glsl_type(base, array_size);
-
-      hash_table_insert(array_types, (void *) t, ralloc_strdup(mem_ctx, key));
+      /* The constructor takes the lock itself.  Another thread may have
+       * created the same type meanwhile; types are compared by pointer, so
+       * keep whichever got into the table first.
+       */
+      mtx_unlock(&glsl_type::mutex);
+      glsl_type *created = new glsl_type(base, array_size);
+      mtx_lock(&glsl_type::mutex);
+
+      t = (glsl_type *) hash_table_find(array_types, key);
+      if (t == NULL) {
+	 t = created;
+	 hash_table_insert(array_types, (void *) t, ralloc_strdup(mem_ctx, key));
+      } else {
+	 discard_created_type(created);
+      }
    }
 
+   mtx_unlock(&glsl_type::mutex);
+
    assert(t->base_type == GLSL_TYPE_ARRAY);
    assert(t->length == array_size);
    assert(t->fields.array == base);
@@ -581,17 +645,29 @@ glsl_type::get_record_instance(const glsl_struct_field *fields,
 {
    const glsl_type key(fields, num_fields, name);
 
+   mtx_lock(&glsl_type::mutex);
+
    if (record_types == NULL) {
       record_types = hash_table_ctor(64, record_key_hash, record_key_compare);
    }
 
    const glsl_type *t = (glsl_type *) hash_table_find(record_types, & key);
    if (t == NULL) {
-      t = new glsl_type(fields, num_fields, name);
-
-      hash_table_insert(record_types, (void *) t, t);
+      mtx_unlock(&glsl_type::mutex);
+      glsl_type *created = new glsl_type(fields, num_fields, name);
+      mtx_lock(&glsl_type::mutex);
+
+      t = (glsl_type *) hash_table_find(record_types, & key);
+      if (t == NULL) {
+	 t = created;
+	 hash_table_insert(record_types, (void *) t, t);
+      } else {
+	 discard_created_type(created);
+      }
    }
 
+   mtx_unlock(&glsl_type::mutex);
+
    assert(t->base_type == GLSL_TYPE_STRUCT);
    assert(t->length == num_fields);
    assert(strcmp(t->name, name) == 0);
@@ -608,17 +684,29 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
 {
    const glsl_type key(fields, num_fields, packing, block_name);
 
+   mtx_lock(&glsl_type::mutex);
+
    if (interface_types == NULL) {
       interface_types = hash_table_ctor(64, record_key_hash, record_key_compare);
    }
 
    const glsl_type *t = (glsl_type *) hash_table_find(interface_types, & key);
    if (t == NULL) {
-      t = new glsl_type(fields, num_fields, packing, block_name);
-
-      hash_table_insert(interface_types, (void *) t, t);
+      mtx_unlock(&glsl_type::mutex);
+      glsl_type *created = new glsl_type(fields, num_fields, packing, block_name);
+      mtx_lock(&glsl_type::mutex);
+
+      t = (glsl_type *) hash_table_find(interface_types, & key);
+      if (t == NULL) {
+	 t = created;
+	 hash_table_insert(interface_types, (void *) t, t);
+      } else {
+	 discard_created_type(created);
+      }
    }
 
+   mtx_unlock(&glsl_type::mutex);
+
    assert(t->base_type == GLSL_TYPE_INTERFACE);
    assert(t->length == num_fields);
    assert(strcmp(t->name, block_name) == 0);
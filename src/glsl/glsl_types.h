@@ -110,6 +110,7 @@ enum glsl_matrix_layout {
 #ifdef __cplusplus
 #include "../mesa/main/glminimal.h"
 #include "util/ralloc.h"
+#include "c11/threads.h"
 
 struct glsl_type {
    GLenum gl_type;
@@ -129,6 +130,8 @@ struct glsl_type {
     * easier to just ralloc_free 'mem_ctx' (or any of its ancestors). */
    static void* operator new(size_t size)
    {
+      mtx_lock(&glsl_type::mutex);
+
       if (glsl_type::mem_ctx == NULL) {
 	 glsl_type::mem_ctx = ralloc_context(NULL);
 	 assert(glsl_type::mem_ctx != NULL);
@@ -139,6 +142,8 @@ struct glsl_type {
       type = ralloc_size(glsl_type::mem_ctx, size);
       assert(type != NULL);
 
+      mtx_unlock(&glsl_type::mutex);
+
       return type;
    }
 
@@ -146,7 +151,9 @@ struct glsl_type {
     * ralloc_free in that case. */
    static void operator delete(void *type)
    {
+      mtx_lock(&glsl_type::mutex);
       ralloc_free(type);
+      mtx_unlock(&glsl_type::mutex);
    }
 
    /**
@@ -628,6 +635,12 @@ struct glsl_type {
    bool record_compare(const glsl_type *b) const;
 
 private:
+   /**
+    * Guards \c mem_ctx and the array, record and interface type caches, so
+    * that several threads may compile shaders at the same time.
+    */
+   static mtx_t mutex;
+
    /**
     * ralloc context for all glsl_type allocations
     *
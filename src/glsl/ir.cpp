@@ -1262,7 +1262,7 @@ ir_constant::is_uint16_constant() const
 }
 
 ir_loop::ir_loop()
-   : ir_instruction(ir_type_loop)
+   : ir_instruction(ir_type_loop), unroll_factor(1), source_iterations(0)
 {
 }
 
@@ -962,9 +962,10 @@ public:
    /**
     * Attempt to evaluate this function as a constant expression,
     * given a list of the actual parameters and the variable context.
+    * The result is allocated out of \c mem_ctx.
     * Returns NULL for non-built-ins.
     */
-   ir_constant *constant_expression_value(exec_list *actual_parameters, struct hash_table *variable_context);
+   ir_constant *constant_expression_value(void *mem_ctx, exec_list *actual_parameters, struct hash_table *variable_context);
 
    /**
     * Get the name of the function for which this is a signature
@@ -1061,7 +1062,8 @@ private:
     * Returns false if the expression is not constant, true otherwise,
     * and the value in *result if result is non-NULL.
     */
-   bool constant_expression_evaluate_expression_list(const struct exec_list &body,
+   bool constant_expression_evaluate_expression_list(void *mem_ctx,
+						     const struct exec_list &body,
 						     struct hash_table *variable_context,
 						     ir_constant **result);
 };
@@ -1181,6 +1183,18 @@ public:
 
    /** List of ir_instruction that make up the body of the loop. */
    exec_list body_instructions;
+
+   /**
+    * How many iterations of the source loop one iteration of this loop
+    * runs, after partial unrolling.
+    */
+   unsigned unroll_factor;
+
+   /**
+    * Iterations of the source loop, peeled ones included, once it has been
+    * partially unrolled.
+    */
+   unsigned source_iterations;
 };
 
 
@@ -2457,6 +2471,14 @@ detect_recursion_linked(struct gl_shader_program *prog,
 void
 clone_ir_list(void *mem_ctx, exec_list *out, const exec_list *in);
 
+/**
+ * Like \c clone_ir_list, also mapping each variable, function and function
+ * signature in \c in to its clone in \c ht.
+ */
+void
+clone_ir_list(void *mem_ctx, exec_list *out, const exec_list *in,
+              struct hash_table *ht);
+
 extern void
 _mesa_glsl_initialize_variables(exec_list *instructions,
 				struct _mesa_glsl_parse_state *state);
@@ -2468,6 +2490,9 @@ extern ir_function_signature *
 _mesa_glsl_find_builtin_function(_mesa_glsl_parse_state *state,
                                  const char *name, exec_list *actual_parameters);
 
+extern ir_function *
+_mesa_glsl_get_builtin_function(const char *name);
+
 extern gl_shader *
 _mesa_glsl_get_builtin_function_shader(void);
 
@@ -133,6 +133,8 @@ ir_loop *
 ir_loop::clone(void *mem_ctx, struct hash_table *ht) const
 {
    ir_loop *new_loop = new(mem_ctx) ir_loop();
+   new_loop->unroll_factor = this->unroll_factor;
+   new_loop->source_iterations = this->source_iterations;
 
    foreach_in_list(ir_instruction, ir, &this->body_instructions) {
       new_loop->body_instructions.push_tail(ir->clone(mem_ctx, ht));
@@ -429,9 +431,23 @@ clone_ir_list(void *mem_ctx, exec_list *out, const exec_list *in)
    struct hash_table *ht =
       hash_table_ctor(0, hash_table_pointer_hash, hash_table_pointer_compare);
 
+   clone_ir_list(mem_ctx, out, in, ht);
+
+   hash_table_dtor(ht);
+}
+
+
+void
+clone_ir_list(void *mem_ctx, exec_list *out, const exec_list *in,
+              struct hash_table *ht)
+{
    foreach_in_list(const ir_instruction, original, in) {
       ir_instruction *copy = original->clone(mem_ctx, ht);
 
+      /* Variables and signatures note their clones themselves. */
+      if (original->ir_type == ir_type_function)
+         hash_table_insert(ht, copy, (void *) original);
+
       out->push_tail(copy);
    }
 
@@ -441,6 +457,4 @@ clone_ir_list(void *mem_ctx, exec_list *out, const exec_list *in)
     * the function signature that it references may not have been cloned yet).
     */
    fixup_function_calls(ht, out);
-
-   hash_table_dtor(ht);
 }
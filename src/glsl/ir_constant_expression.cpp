@@ -1803,11 +1803,14 @@ ir_constant::constant_expression_value(struct hash_table *)
 ir_constant *
 ir_call::constant_expression_value(struct hash_table *variable_context)
 {
-   return this->callee->constant_expression_value(&this->actual_parameters, variable_context);
+   return this->callee->constant_expression_value(ralloc_parent(this),
+                                                  &this->actual_parameters,
+                                                  variable_context);
 }
 
 
-bool ir_function_signature::constant_expression_evaluate_expression_list(const struct exec_list &body,
+bool ir_function_signature::constant_expression_evaluate_expression_list(void *mem_ctx,
+									 const struct exec_list &body,
 									 struct hash_table *variable_context,
 									 ir_constant **result)
 {
@@ -1817,7 +1820,7 @@ bool ir_function_signature::constant_expression_evaluate_expression_list(const s
 	 /* (declare () type symbol) */
       case ir_type_variable: {
 	 ir_variable *var = inst->as_variable();
-	 hash_table_insert(variable_context, ir_constant::zero(this, var->type), var);
+	 hash_table_insert(variable_context, ir_constant::zero(mem_ctx, var->type), var);
 	 break;
       }
 
@@ -1891,7 +1894,7 @@ bool ir_function_signature::constant_expression_evaluate_expression_list(const s
 	 exec_list &branch = cond->get_bool_component(0) ? iif->then_instructions : iif->else_instructions;
 
 	 *result = NULL;
-	 if (!constant_expression_evaluate_expression_list(branch, variable_context, result))
+	 if (!constant_expression_evaluate_expression_list(mem_ctx, branch, variable_context, result))
 	    return false;
 
 	 /* If there was a return in the branch chosen, drop out now. */
@@ -1915,7 +1918,7 @@ bool ir_function_signature::constant_expression_evaluate_expression_list(const s
 }
 
 ir_constant *
-ir_function_signature::constant_expression_value(exec_list *actual_parameters, struct hash_table *variable_context)
+ir_function_signature::constant_expression_value(void *mem_ctx, exec_list *actual_parameters, struct hash_table *variable_context)
 {
    const glsl_type *type = this->return_type;
    if (type == glsl_type::void_type)
@@ -1966,13 +1969,23 @@ ir_function_signature::constant_expression_value(exec_list *actual_parameters, s
 
    ir_constant *result = NULL;
 
+   /* Built-in signatures are shared by every compile, possibly on other
+    * threads, so nothing may be allocated out of their memory context.
+    * Run a private copy of the body instead; the parameter variables are
+    * not cloned, so the deref_hash entries above still apply to it.
+    */
+   void *local_ctx = ralloc_arena_context(NULL);
+   exec_list local_body;
+   clone_ir_list(local_ctx, &local_body, origin ? &origin->body : &body);
+
    /* Now run the builtin function until something non-constant
     * happens or we get the result.
     */
-   if (constant_expression_evaluate_expression_list(origin ? origin->body : body, deref_hash, &result) && result)
-      result = result->clone(ralloc_parent(this), NULL);
+   if (constant_expression_evaluate_expression_list(local_ctx, local_body, deref_hash, &result) && result)
+      result = result->clone(mem_ctx, NULL);
 
    hash_table_dtor(deref_hash);
+   ralloc_free(local_ctx);
 
    return result;
 }
@@ -158,7 +158,7 @@ public:
       : current(NULL)
    {
       progress = false;
-      this->mem_ctx = ralloc_context(NULL);
+      this->mem_ctx = ralloc_arena_context(NULL);
       this->function_hash = hash_table_ctor(0, hash_table_pointer_hash,
 					    hash_table_pointer_compare);
    }
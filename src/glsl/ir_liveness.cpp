@@ -0,0 +1,452 @@
+/**
+ * \file ir_liveness.cpp
+ *
+ * Per-component liveness of variables, and the register pressure it implies.
+ *
+ * Basic blocks of our IR are separated by ifs, loops and jumps only (see
+ * ir_basic_block.cpp), so the analysis follows that structure directly
+ * instead of building a control flow graph: statement lists are walked
+ * backwards, ifs join the liveness of both branches, and loops are
+ * iterated until the liveness at their head stops growing.
+ */
+
+#include <string.h>
+#include "ir.h"
+#include "ir_liveness.h"
+#include "ir_hierarchical_visitor.h"
+#include "glsl_types.h"
+#include "util/hash_table.h"
+
+
+/** Liveness that jumps out of a loop body continue with. */
+struct ir_liveness::loop_targets {
+   const unsigned char *at_break;
+   const unsigned char *at_continue;
+};
+
+
+namespace {
+
+/** Gives tracked variables their index in the live masks. */
+class liveness_index_visitor : public ir_hierarchical_visitor {
+public:
+   liveness_index_visitor(struct hash_table *indices,
+                          struct hash_table *globals)
+      : indices(indices), globals(globals), count(0)
+   {
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      ir_variable *var = ir->var;
+      if (_mesa_hash_table_search(globals, _mesa_hash_pointer(var), var))
+         return visit_continue;
+      switch (var->data.mode) {
+      case ir_var_auto:
+      case ir_var_temporary:
+      case ir_var_function_in:
+      case ir_var_function_out:
+      case ir_var_function_inout:
+      case ir_var_const_in:
+         break;
+      default:
+         return visit_continue;
+      }
+      if (!_mesa_hash_table_search(indices, _mesa_hash_pointer(var), var)) {
+         _mesa_hash_table_insert(indices, _mesa_hash_pointer(var), var,
+                                 (void *) (uintptr_t) (count + 1));
+         count++;
+      }
+      return visit_continue;
+   }
+
+   struct hash_table *indices;
+   struct hash_table *globals;
+   unsigned count;
+};
+
+
+/** Adds the components an rvalue reads to a live set. */
+class liveness_use_visitor : public ir_hierarchical_visitor {
+public:
+   liveness_use_visitor(ir_liveness *l, unsigned char *live)
+      : l(l), live(live)
+   {
+   }
+
+   virtual ir_visitor_status visit_enter(ir_swizzle *ir)
+   {
+      ir_dereference_variable *deref = ir->val->as_dereference_variable();
+      if (deref == NULL)
+         return visit_continue;
+
+      int index = l->get_index(deref->var);
+      if (index >= 0) {
+         const unsigned comps[4] = { ir->mask.x, ir->mask.y, ir->mask.z,
+                                     ir->mask.w };
+         unsigned mask = 0;
+         for (unsigned i = 0; i < ir->mask.num_components; i++)
+            mask |= 1u << comps[i];
+         live[index] |= mask & l->full_mask(index);
+      }
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      int index = l->get_index(ir->var);
+      if (index >= 0)
+         live[index] = l->full_mask(index);
+      return visit_continue;
+   }
+
+   ir_liveness *l;
+   unsigned char *live;
+};
+
+} /* anonymous namespace */
+
+
+ir_liveness::ir_liveness(bool record_points)
+{
+   this->record_points = record_points;
+   this->mem_ctx = ralloc_context(NULL);
+   this->indices = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+   this->points = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+   this->vars = NULL;
+   this->num_vars = 0;
+   this->peak_components = 0;
+   this->peak_vec4s = 0;
+   this->function_peak = NULL;
+   this->function_peak_vec4s = 0;
+   this->function_exit = NULL;
+}
+
+
+ir_liveness::~ir_liveness()
+{
+   ralloc_free(this->mem_ctx);
+}
+
+
+int
+ir_liveness::get_index(ir_variable *var)
+{
+   hash_entry *entry =
+      _mesa_hash_table_search(indices, _mesa_hash_pointer(var), var);
+   return entry ? (int) ((uintptr_t) entry->data - 1) : -1;
+}
+
+
+ir_liveness_point *
+ir_liveness::get_point(ir_instruction *ir)
+{
+   hash_entry *entry =
+      _mesa_hash_table_search(points, _mesa_hash_pointer(ir), ir);
+   return entry ? (ir_liveness_point *) entry->data : NULL;
+}
+
+
+unsigned
+ir_liveness::full_mask(int index) const
+{
+   return vars[index].per_component ? (1u << vars[index].components) - 1 : 1;
+}
+
+
+unsigned
+ir_liveness::mask_components(int index, unsigned mask) const
+{
+   if (!vars[index].per_component)
+      return mask ? vars[index].components : 0;
+
+   unsigned count = 0;
+   for (; mask; mask &= mask - 1)
+      count++;
+   return count;
+}
+
+
+unsigned
+ir_liveness::count_components(const unsigned char *live) const
+{
+   unsigned components = 0;
+   for (unsigned i = 0; i < num_vars; i++)
+      components += mask_components(i, live[i]);
+   return components;
+}
+
+
+unsigned char *
+ir_liveness::new_set()
+{
+   return rzalloc_array(mem_ctx, unsigned char, num_vars + 1);
+}
+
+
+static unsigned
+vec4_slots(const glsl_type *type)
+{
+   if (type->is_array())
+      return type->length * vec4_slots(type->fields.array);
+   if (type->is_record()) {
+      unsigned slots = 0;
+      for (unsigned i = 0; i < type->length; i++)
+         slots += vec4_slots(type->fields.structure[i].type);
+      return slots;
+   }
+   if (type->is_matrix())
+      return type->matrix_columns;
+   return 1;
+}
+
+
+void
+ir_liveness::index_variables(exec_list *instructions)
+{
+   /* Globals can be read by any function; they're left out. */
+   struct hash_table *globals =
+      _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+   foreach_in_list(ir_instruction, node, instructions) {
+      ir_variable *var = node->as_variable();
+      if (var != NULL)
+         _mesa_hash_table_insert(globals, _mesa_hash_pointer(var), var, var);
+   }
+
+   liveness_index_visitor v(indices, globals);
+   v.run(instructions);
+
+   num_vars = v.count;
+   vars = ralloc_array(mem_ctx, var_info, num_vars + 1);
+   struct hash_entry *entry;
+   hash_table_foreach(indices, entry) {
+      const ir_variable *var = (const ir_variable *) entry->key;
+      var_info &info = vars[(uintptr_t) entry->data - 1];
+      const glsl_type *type = var->type;
+      info.per_component = type->is_scalar() || type->is_vector();
+      info.components = type->component_slots();
+      info.vec4s = vec4_slots(type);
+   }
+}
+
+
+void
+ir_liveness::note_pressure(const unsigned char *live)
+{
+   unsigned components = count_components(live), vec4s = 0;
+   for (unsigned i = 0; i < num_vars; i++) {
+      if (live[i])
+         vec4s += vars[i].vec4s;
+   }
+   if (components > *function_peak)
+      *function_peak = components;
+   if (vec4s > function_peak_vec4s)
+      function_peak_vec4s = vec4s;
+}
+
+
+void
+ir_liveness::add_uses(ir_rvalue *ir, unsigned char *live)
+{
+   if (ir == NULL)
+      return;
+   liveness_use_visitor v(this, live);
+   ir->accept(&v);
+}
+
+
+void
+ir_liveness::add_index_uses(ir_rvalue *lhs, unsigned char *live)
+{
+   while (lhs != NULL) {
+      if (ir_dereference_array *array = lhs->as_dereference_array()) {
+         add_uses(array->array_index, live);
+         lhs = array->array;
+      } else if (ir_dereference_record *record =
+                    lhs->as_dereference_record()) {
+         lhs = record->record;
+      } else {
+         break;
+      }
+   }
+}
+
+
+void
+ir_liveness::analyze_list(exec_list *list, unsigned char *live,
+                          loop_targets *loop)
+{
+   foreach_in_list_reverse(ir_instruction, ir, list) {
+      if (record_points) {
+         ir_liveness_point *point = get_point(ir);
+         if (point == NULL) {
+            point = ralloc(mem_ctx, ir_liveness_point);
+            point->live = new_set();
+            point->function_peak = function_peak;
+            _mesa_hash_table_insert(points, _mesa_hash_pointer(ir), ir, point);
+         }
+         /* Loop bodies get analyzed more than once; the last time is right. */
+         memcpy(point->live, live, num_vars);
+         point->components = count_components(live);
+      }
+      analyze_instruction(ir, live, loop);
+      note_pressure(live);
+   }
+}
+
+
+void
+ir_liveness::analyze_instruction(ir_instruction *ir, unsigned char *live,
+                                 loop_targets *loop)
+{
+   switch (ir->ir_type) {
+   case ir_type_assignment: {
+      ir_assignment *assign = (ir_assignment *) ir;
+      ir_dereference_variable *lhs = assign->lhs->as_dereference_variable();
+      int index = lhs ? get_index(lhs->var) : -1;
+
+      if (index >= 0 && assign->condition == NULL) {
+         if (vars[index].per_component)
+            live[index] &= ~assign->write_mask;
+         else
+            live[index] = 0;
+      } else if (lhs == NULL) {
+         /* Array elements and structure fields: the indices are read, the
+          * rest of the variable stays as live as it was.
+          */
+         add_index_uses(assign->lhs, live);
+      }
+
+      add_uses(assign->rhs, live);
+      add_uses(assign->condition, live);
+      break;
+   }
+
+   case ir_type_if: {
+      ir_if *iif = (ir_if *) ir;
+      unsigned char *else_live = new_set();
+      memcpy(else_live, live, num_vars);
+
+      analyze_list(&iif->then_instructions, live, loop);
+      analyze_list(&iif->else_instructions, else_live, loop);
+      for (unsigned i = 0; i < num_vars; i++)
+         live[i] |= else_live[i];
+      add_uses(iif->condition, live);
+      break;
+   }
+
+   case ir_type_loop: {
+      ir_loop *l = (ir_loop *) ir;
+      unsigned char *after = new_set();
+      unsigned char *head = new_set();
+      unsigned char *body = new_set();
+      memcpy(after, live, num_vars);
+
+      loop_targets targets;
+      targets.at_break = after;
+      targets.at_continue = head;
+
+      /* Falling off the end of the body goes back to the head. */
+      bool changed;
+      do {
+         memcpy(body, head, num_vars);
+         analyze_list(&l->body_instructions, body, &targets);
+         changed = memcmp(body, head, num_vars) != 0;
+         for (unsigned i = 0; i < num_vars; i++)
+            head[i] |= body[i];
+      } while (changed);
+
+      memcpy(live, head, num_vars);
+      break;
+   }
+
+   case ir_type_loop_jump: {
+      ir_loop_jump *jump = (ir_loop_jump *) ir;
+      if (loop != NULL)
+         memcpy(live, jump->is_break() ? loop->at_break : loop->at_continue,
+                num_vars);
+      break;
+   }
+
+   case ir_type_return:
+      memcpy(live, function_exit, num_vars);
+      add_uses(((ir_return *) ir)->value, live);
+      break;
+
+   case ir_type_discard: {
+      ir_discard *discard = (ir_discard *) ir;
+      if (discard->condition == NULL)
+         memset(live, 0, num_vars);
+      else
+         add_uses(discard->condition, live);
+      break;
+   }
+
+   case ir_type_call: {
+      ir_call *call = (ir_call *) ir;
+      if (call->return_deref != NULL) {
+         int index = get_index(call->return_deref->var);
+         if (index >= 0)
+            live[index] = 0;
+      }
+      foreach_two_lists(formal_node, &call->callee->parameters,
+                        actual_node, &call->actual_parameters) {
+         ir_variable *sig_param = (ir_variable *) formal_node;
+         ir_rvalue *param = (ir_rvalue *) actual_node;
+         if (sig_param->data.mode == ir_var_function_out) {
+            ir_dereference_variable *deref = param->as_dereference_variable();
+            int index = deref ? get_index(deref->var) : -1;
+            if (index >= 0)
+               live[index] = 0;
+            else
+               add_index_uses(param, live);
+         } else {
+            add_uses(param, live);
+         }
+      }
+      break;
+   }
+
+   default:
+      break;
+   }
+}
+
+
+void
+ir_liveness::run(exec_list *instructions)
+{
+   index_variables(instructions);
+
+   foreach_in_list(ir_instruction, node, instructions) {
+      ir_function *func = node->as_function();
+      if (func == NULL)
+         continue;
+
+      foreach_in_list(ir_function_signature, sig, &func->signatures) {
+         if (!sig->is_defined || sig->is_builtin())
+            continue;
+
+         function_peak = rzalloc(mem_ctx, unsigned);
+         function_peak_vec4s = 0;
+
+         /* The caller reads out parameters after the function returns. */
+         function_exit = new_set();
+         foreach_in_list(ir_variable, param, &sig->parameters) {
+            int index = get_index(param);
+            if (index >= 0 && (param->data.mode == ir_var_function_out ||
+                               param->data.mode == ir_var_function_inout))
+               function_exit[index] = full_mask(index);
+         }
+
+         unsigned char *live = new_set();
+         memcpy(live, function_exit, num_vars);
+         analyze_list(&sig->body, live, NULL);
+
+         if (*function_peak > peak_components)
+            peak_components = *function_peak;
+         if (function_peak_vec4s > peak_vec4s)
+            peak_vec4s = function_peak_vec4s;
+      }
+   }
+}
@@ -0,0 +1,104 @@
+/* -*- c++ -*- */
+
+#pragma once
+
+#include "ir.h"
+
+struct hash_table;
+
+/**
+ * Live components right after one statement, recorded by \c ir_liveness
+ */
+struct ir_liveness_point {
+   /** Scalar components live right after the statement */
+   unsigned components;
+
+   /** Peak live components of the function the statement is in */
+   const unsigned *function_peak;
+
+   /** Live component mask of each variable, indexed like \c ir_liveness */
+   unsigned char *live;
+};
+
+/**
+ * Per-component liveness of variables, for estimating register pressure.
+ *
+ * Locals, temporaries and function parameters are tracked; scalars and
+ * vectors per component, other types as a whole.  Shader inputs are not,
+ * they can be read from their own registers for as long as needed, and
+ * neither are globals.  Out parameters are live where the function returns.  The analysis
+ * is backwards over the structured IR: an if joins the liveness of its
+ * branches, a loop iterates to a fixed point, jumps take the liveness of
+ * their target.  Values inside expression trees are not counted.
+ */
+class ir_liveness {
+public:
+   /**
+    * \param record_points  keep an \c ir_liveness_point for each statement,
+    *                       see \c get_point
+    */
+   ir_liveness(bool record_points = false);
+   ~ir_liveness();
+
+   /** Analyze the bodies of all functions in \c instructions. */
+   void run(exec_list *instructions);
+
+   /** Point recorded for \c ir, or \c NULL. */
+   ir_liveness_point *get_point(ir_instruction *ir);
+
+   /** Number of tracked variables; live sets have one mask for each. */
+   unsigned num_variables() const { return num_vars; }
+
+   /** Index of \c var in the live masks, or -1 if it's not tracked. */
+   int get_index(ir_variable *var);
+
+   /** Live component mask of all components of \c var. */
+   unsigned full_mask(int index) const;
+
+   /** Scalar components in the live part \c mask of \c var. */
+   unsigned mask_components(int index, unsigned mask) const;
+
+   /** Scalar components live in \c live. */
+   unsigned count_components(const unsigned char *live) const;
+
+   /** New empty live set, freed with the analysis. */
+   unsigned char *new_set();
+
+   /** Adds the variable components \c ir reads to \c live. */
+   void add_uses(ir_rvalue *ir, unsigned char *live);
+
+   /** Highest peak over all functions: scalar components, and vec4 registers
+    * they'd take on vector hardware.
+    */
+   unsigned peak_components;
+   unsigned peak_vec4s;
+
+private:
+   struct var_info {
+      unsigned components;
+      unsigned vec4s;
+      bool per_component;
+   };
+
+   struct loop_targets;
+
+   void index_variables(exec_list *instructions);
+   void analyze_list(exec_list *list, unsigned char *live,
+                     loop_targets *loop);
+   void analyze_instruction(ir_instruction *ir, unsigned char *live,
+                            loop_targets *loop);
+   void add_index_uses(ir_rvalue *lhs, unsigned char *live);
+   void note_pressure(const unsigned char *live);
+
+   void *mem_ctx;
+   struct hash_table *indices;
+   struct hash_table *points;
+   var_info *vars;
+   unsigned num_vars;
+   bool record_points;
+
+   /* Current function */
+   unsigned *function_peak;
+   unsigned function_peak_vec4s;
+   unsigned char *function_exit;
+};
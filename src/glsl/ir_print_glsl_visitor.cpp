@@ -69,7 +69,7 @@ struct ga_entry : public exec_node
 
 struct global_print_tracker {
 	global_print_tracker () {
-		mem_ctx = ralloc_context(0);
+		mem_ctx = ralloc_arena_context(0);
 		var_counter = 0;
 		var_hash = hash_table_ctor(0, hash_table_pointer_hash, hash_table_pointer_compare);
 		main_function_done = false;
@@ -377,10 +377,11 @@ void ir_print_glsl_visitor::print_precision (ir_instruction* ir, const glsl_type
 	// In fragment shader, default float precision is undefined.
 	// We must thus always print it, when there was no default precision
 	// and for whatever reason our type ended up having undefined precision.
-	if (prec == glsl_precision_undefined &&
+	const bool needs_float_precision =
 		type && type->is_float() &&
 		this->state->stage == MESA_SHADER_FRAGMENT &&
-		!this->state->had_float_precision)
+		!this->state->had_float_precision;
+	if (prec == glsl_precision_undefined && needs_float_precision)
 	{
 		prec = glsl_precision_high;
 	}
@@ -404,7 +405,7 @@ void ir_print_glsl_visitor::print_precision (ir_instruction* ir, const glsl_type
 	
 	if (prec == glsl_precision_high || prec == glsl_precision_undefined)
 	{
-		if (ir->ir_type == ir_type_function_signature)
+		if (ir->ir_type == ir_type_function_signature && !needs_float_precision)
 			return;
 	}
 	buffer.asprintf_append ("%s", get_precision_string(prec));
@@ -61,7 +61,7 @@ struct global_print_tracker_metal
 {
 	global_print_tracker_metal ()
 	{
-		mem_ctx = ralloc_context(0);
+		mem_ctx = ralloc_arena_context(0);
 		var_counter = 0;
 		var_hash = hash_table_ctor(0, hash_table_pointer_hash, hash_table_pointer_compare);
 		const_counter = 0;
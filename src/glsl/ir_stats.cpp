@@ -1,64 +1,433 @@
-#include "ir.h"
-#include "ir_visitor.h"
+#include "ir_stats.h"
 #include "ir_unused_structs.h"
 #include "glsl_types.h"
+#include "loop_analysis.h"
+#include "ir_liveness.h"
+#include "util/hash_table.h"
+#include "util/ralloc.h"
+#include <string.h>
 
-struct ir_stats_counter_visitor : public ir_hierarchical_visitor {
-	ir_stats_counter_visitor()
-		: math(0), tex(0), flow(0)
+void calculate_shader_stats(exec_list* instructions, int* outMath, int* outTex, int* outFlow)
+{
+	ir_stats_counter_visitor v;
+	v.run (instructions);
+	*outMath = v.math;
+	*outTex = v.tex;
+	*outFlow = v.flow;
+}
+
+
+// ---- Cost estimate
+//
+// Each ALU operation falls in one class below; its cost is the cycles of its
+// class in the table of the target, at the precision of the operation. Simple
+// operations process vectorWidth components per cycle, others go one component
+// at a time. Texture fetches cost the same at any precision; fetches with
+// computed coordinates cost extra (no prefetch on older mobile GPUs).
+
+enum cost_op_class {
+	kCostFree, // neg/abs/saturate modifiers, constructors
+	kCostSimple,
+	kCostTranscendental,
+	kCostIntDivide,
+	kCostDerivative,
+	kCostClassCount
+};
+
+struct cost_table {
+	int vectorWidth;
+	float alu[3][kCostClassCount]; // high, medium, low precision
+	float texture;
+	float dependentTexture;
+	float branch;
+};
+
+// Indexed by glslopt_target.
+static const cost_table kCostTables[] = {
+	// OpenGL: scalar desktop GPUs, precision has no effect
+	{ 1, { { 0, 1, 4, 16, 1 }, { 0, 1, 4, 16, 1 }, { 0, 1, 4, 16, 1 } }, 4, 0, 2 },
+	// OpenGL ES 2.0: vec4 ALUs, half rate mediump/lowp, no integer hardware, costly dependent reads
+	{ 4, { { 0, 1, 4, 32, 2 }, { 0, 0.5f, 2, 32, 1 }, { 0, 0.5f, 2, 32, 1 } }, 8, 8, 4 },
+	// OpenGL ES 3.0: scalar ALUs with double rate fp16
+	{ 1, { { 0, 1, 4, 16, 1 }, { 0, 0.5f, 2, 16, 1 }, { 0, 0.5f, 2, 16, 1 } }, 4, 2, 2 },
+	// Metal
+	{ 1, { { 0, 1, 4, 16, 1 }, { 0, 0.5f, 2, 16, 1 }, { 0, 0.5f, 2, 16, 1 } }, 4, 1, 1 },
+};
+
+// Iterations assumed for loops with no provable count.
+static const int kCostUnknownLoopIterations = 8;
+
+
+namespace {
+
+// What is known about the values a variable gets
+struct cost_var_info {
+	int depth; // texture fetches chained into the value
+	bool computed; // not just a copy of a shader input
+};
+
+struct cost_totals {
+	float alu, tex, flow;
+	float fetches, dependent;
+
+	float cycles() const { return alu + tex + flow; }
+};
+
+class ir_cost_visitor : public ir_hierarchical_visitor {
+public:
+	ir_cost_visitor (const cost_table& table, loop_state* loops)
+		: table(table), loops(loops), scale(1.0f), maxDepth(0)
 	{
+		memset (&totals, 0, sizeof(totals));
+		mem_ctx = ralloc_context (NULL);
+		vars = _mesa_hash_table_create (mem_ctx, _mesa_key_pointer_equal);
 	}
-
-	virtual ir_visitor_status visit_leave(class ir_loop *)
+	~ir_cost_visitor ()
 	{
-		++flow;
-		return visit_continue;
+		ralloc_free (mem_ctx);
 	}
-	virtual ir_visitor_status visit_leave(class ir_expression *)
+
+	virtual ir_visitor_status visit_leave (ir_expression* ir);
+	virtual ir_visitor_status visit_leave (ir_texture* ir);
+	virtual ir_visitor_status visit_leave (ir_assignment* ir);
+	virtual ir_visitor_status visit_enter (ir_if* ir);
+	virtual ir_visitor_status visit_enter (ir_loop* ir);
+	virtual ir_visitor_status visit (ir_loop_jump* ir);
+	virtual ir_visitor_status visit_leave (ir_discard* ir);
+	virtual ir_visitor_status visit_leave (ir_return* ir);
+	virtual ir_visitor_status visit_leave (ir_call* ir);
+
+	cost_var_info* get_info (ir_variable* var, bool create);
+	int value_depth (ir_rvalue* ir);
+	bool is_plain_input (ir_rvalue* ir);
+
+	const cost_table& table;
+	loop_state* loops;
+	void* mem_ctx;
+	hash_table* vars;
+	cost_totals totals;
+	float scale; // how many times the current code runs
+	int maxDepth;
+};
+
+
+// Texture fetches chained into the value of an rvalue
+class cost_depth_visitor : public ir_hierarchical_visitor {
+public:
+	cost_depth_visitor (ir_cost_visitor* v) : v(v), depth(0) { }
+
+	virtual ir_visitor_status visit (ir_dereference_variable* ir)
 	{
-		++math;
+		cost_var_info* info = v->get_info (ir->var, false);
+		if (info && info->depth > depth)
+			depth = info->depth;
 		return visit_continue;
 	}
-	virtual ir_visitor_status visit_leave(class ir_texture *)
+	virtual ir_visitor_status visit_enter (ir_texture* ir)
 	{
-		++tex;
-		return visit_continue;
+		// this fetch comes on top of whatever its coordinates depend on
+		cost_depth_visitor coord (v);
+		if (ir->coordinate)
+			ir->coordinate->accept (&coord);
+		if ((ir->op == ir_txb || ir->op == ir_txl) && ir->lod_info.lod)
+			ir->lod_info.lod->accept (&coord);
+		if (coord.depth + 1 > depth)
+			depth = coord.depth + 1;
+		return visit_continue_with_parent;
 	}
-	virtual ir_visitor_status visit_leave(ir_assignment *ir)
+
+	ir_cost_visitor* v;
+	int depth;
+};
+
+} // anonymous namespace
+
+
+static cost_op_class classify_expression (ir_expression* ir, int* outComponents)
+{
+	const glsl_type* type = ir->type;
+	*outComponents = type->components();
+	bool isFloat = type->base_type == GLSL_TYPE_FLOAT;
+
+	switch (ir->operation)
 	{
-		if (ir && ir->rhs)
+	case ir_unop_neg:
+	case ir_unop_abs:
+	case ir_unop_saturate:
+	case ir_quadop_vector:
+	case ir_unop_bitcast_i2f:
+	case ir_unop_bitcast_f2i:
+	case ir_unop_bitcast_u2f:
+	case ir_unop_bitcast_f2u:
+		return kCostFree;
+
+	case ir_unop_rcp:
+	case ir_unop_rsq:
+	case ir_unop_sqrt:
+	case ir_unop_exp2:
+	case ir_unop_log2:
+	case ir_unop_sin:
+	case ir_unop_cos:
+	case ir_unop_sin_reduced:
+	case ir_unop_cos_reduced:
+		return kCostTranscendental;
+	case ir_unop_exp:
+	case ir_unop_log:
+	case ir_binop_pow:
+		// pow: log2, mul, exp2
+		*outComponents *= ir->operation == ir_binop_pow ? 2 : 1;
+		return kCostTranscendental;
+	case ir_unop_noise:
+		*outComponents *= 4;
+		return kCostTranscendental;
+
+	case ir_binop_div:
+	case ir_binop_mod:
+		// float: multiply by reciprocal
+		return isFloat ? kCostTranscendental : kCostIntDivide;
+
+	case ir_unop_dFdx:
+	case ir_unop_dFdx_coarse:
+	case ir_unop_dFdx_fine:
+	case ir_unop_dFdy:
+	case ir_unop_dFdy_coarse:
+	case ir_unop_dFdy_fine:
+		return kCostDerivative;
+
+	case ir_binop_dot:
+	case ir_binop_all_equal:
+	case ir_binop_any_nequal:
+	case ir_unop_any:
+		*outComponents = ir->operands[0]->type->components();
+		return kCostSimple;
+	case ir_unop_normalize:
+		// dot and mul; the rsq is added by the caller
+		*outComponents = 2 * type->components();
+		return kCostSimple;
+
+	case ir_binop_mul:
+		if (ir->operands[0]->type->is_matrix() || ir->operands[1]->type->is_matrix())
 		{
-			if (ir->rhs->as_constant())
-				++math;
+			// one multiply-add per element of the result and inner dimension
+			const glsl_type* a = ir->operands[0]->type;
+			const int inner = a->is_matrix() ? a->matrix_columns : a->vector_elements;
+			if (ir->operands[0]->type->is_scalar() || ir->operands[1]->type->is_scalar())
+				return kCostSimple;
+			*outComponents = type->components() * inner;
 		}
-		return visit_continue;
+		return kCostSimple;
+
+	case ir_unop_sign:
+	case ir_triop_clamp:
+	case ir_triop_lrp:
+		// two operations per component
+		*outComponents *= 2;
+		return kCostSimple;
+
+	default:
+		return kCostSimple;
 	}
-	virtual ir_visitor_status visit_leave(class ir_return *)
+}
+
+static int precision_index (glsl_precision prec)
+{
+	return prec == glsl_precision_undefined ? glsl_precision_high : (int)prec;
+}
+
+
+cost_var_info* ir_cost_visitor::get_info (ir_variable* var, bool create)
+{
+	hash_entry* entry = _mesa_hash_table_search (vars, _mesa_hash_pointer(var), var);
+	if (entry)
+		return (cost_var_info*)entry->data;
+	if (!create)
+		return NULL;
+	cost_var_info* info = rzalloc (mem_ctx, cost_var_info);
+	info->computed = var->data.mode != ir_var_shader_in;
+	_mesa_hash_table_insert (vars, _mesa_hash_pointer(var), var, info);
+	return info;
+}
+
+
+int ir_cost_visitor::value_depth (ir_rvalue* ir)
+{
+	if (!ir)
+		return 0;
+	cost_depth_visitor v (this);
+	ir->accept (&v);
+	return v.depth;
+}
+
+
+bool ir_cost_visitor::is_plain_input (ir_rvalue* ir)
+{
+	while (ir && ir->as_swizzle())
+		ir = ir->as_swizzle()->val;
+	ir_dereference_variable* deref = ir ? ir->as_dereference_variable() : NULL;
+	if (!deref)
+		return false;
+	cost_var_info* info = get_info (deref->var, false);
+	if (info)
+		return !info->computed;
+	return deref->var->data.mode == ir_var_shader_in;
+}
+
+
+ir_visitor_status ir_cost_visitor::visit_leave (ir_expression* ir)
+{
+	int components;
+	cost_op_class cls = classify_expression (ir, &components);
+	const float cycles = table.alu[precision_index(ir->get_precision())][cls];
+	if (cls == kCostSimple)
+		totals.alu += scale * cycles * ((components + table.vectorWidth - 1) / table.vectorWidth);
+	else
+		totals.alu += scale * cycles * components;
+	if (ir->operation == ir_unop_normalize)
+		totals.alu += scale * table.alu[precision_index(ir->get_precision())][kCostTranscendental];
+	return visit_continue;
+}
+
+
+ir_visitor_status ir_cost_visitor::visit_leave (ir_texture* ir)
+{
+	if (ir->op == ir_txs || ir->op == ir_query_levels || ir->op == ir_lod)
 	{
-		++flow;
+		totals.alu += scale * table.alu[0][kCostSimple];
 		return visit_continue;
 	}
-	virtual ir_visitor_status visit_leave(class ir_discard *)
+
+	totals.fetches += scale;
+	totals.tex += scale * table.texture;
+	if (ir->op == ir_txd)
+		totals.tex += scale * table.texture;
+	if (!is_plain_input (ir->coordinate))
 	{
-		++tex;
+		totals.dependent += scale;
+		totals.tex += scale * table.dependentTexture;
+	}
+
+	const int depth = value_depth (ir);
+	if (depth > maxDepth)
+		maxDepth = depth;
+	return visit_continue;
+}
+
+
+ir_visitor_status ir_cost_visitor::visit_leave (ir_assignment* ir)
+{
+	ir_variable* var = ir->lhs->variable_referenced();
+	if (!var)
 		return visit_continue;
+	cost_var_info* info = get_info (var, true);
+	const int depth = value_depth (ir->rhs);
+	if (depth > info->depth)
+		info->depth = depth;
+	if (!is_plain_input (ir->rhs) || ir->condition)
+		info->computed = true;
+	return visit_continue;
+}
+
+
+ir_visitor_status ir_cost_visitor::visit_enter (ir_if* ir)
+{
+	ir->condition->accept (this);
+	totals.flow += scale * table.branch;
+
+	// Only the more expensive branch counts
+	const cost_totals before = totals;
+	visit_list_elements (this, &ir->then_instructions);
+	const cost_totals thenTotals = totals;
+	totals = before;
+	visit_list_elements (this, &ir->else_instructions);
+	if (thenTotals.cycles() > totals.cycles())
+		totals = thenTotals;
+	return visit_continue_with_parent;
+}
+
+
+ir_visitor_status ir_cost_visitor::visit_enter (ir_loop* ir)
+{
+	int iterations = kCostUnknownLoopIterations;
+	loop_variable_state* ls = loops ? loops->get (ir) : NULL;
+	if (ls && ls->limiting_terminator && ls->limiting_terminator->iterations >= 0)
+		iterations = ls->limiting_terminator->iterations;
+
+	const float outerScale = scale;
+	scale *= iterations;
+	totals.flow += scale * table.branch;
+	visit_list_elements (this, &ir->body_instructions);
+	scale = outerScale;
+	return visit_continue_with_parent;
+}
+
+
+ir_visitor_status ir_cost_visitor::visit (ir_loop_jump*)
+{
+	totals.flow += scale * table.branch;
+	return visit_continue;
+}
+
+
+ir_visitor_status ir_cost_visitor::visit_leave (ir_discard*)
+{
+	totals.flow += scale * table.branch;
+	return visit_continue;
+}
+
+
+ir_visitor_status ir_cost_visitor::visit_leave (ir_return*)
+{
+	totals.flow += scale * table.branch;
+	return visit_continue;
+}
+
+
+ir_visitor_status ir_cost_visitor::visit_leave (ir_call* ir)
+{
+	// Calls that survived inlining: count the callee's body at the call
+	if (ir->callee->is_defined)
+		visit_list_elements (this, &ir->callee->body);
+	return visit_continue;
+}
+
+
+void calculate_shader_cost(exec_list* instructions, glslopt_target target, glslopt_shader_cost* outCost)
+{
+	loop_state* loops = analyze_loop_variables (instructions);
+	ir_cost_visitor v (kCostTables[target], loops->loop_found ? loops : NULL);
+
+	// Cost of main; if there's none (not a full shader), of all the functions
+	ir_function* mainFunc = NULL;
+	foreach_in_list(ir_instruction, node, instructions)
+	{
+		ir_function* func = node->as_function();
+		if (func && !strcmp (func->name, "main"))
+			mainFunc = func;
 	}
-	virtual ir_visitor_status visit_leave(class ir_if *)
+	foreach_in_list(ir_instruction, node, instructions)
 	{
-		++flow;
-		return visit_continue;
+		ir_function* func = node->as_function();
+		if (!func || (mainFunc && func != mainFunc))
+			continue;
+		foreach_in_list(ir_function_signature, sig, &func->signatures)
+		{
+			if (sig->is_defined && !sig->is_builtin())
+				visit_list_elements (&v, &sig->body);
+		}
 	}
 
-	int math;
-	int tex;
-	int flow;
-};
+	outCost->aluCycles = v.totals.alu;
+	outCost->textureCycles = v.totals.tex;
+	outCost->flowCycles = v.totals.flow;
+	outCost->cycles = v.totals.cycles();
+	outCost->textureFetches = (int)(v.totals.fetches + 0.5f);
+	outCost->dependentFetches = (int)(v.totals.dependent + 0.5f);
+	outCost->textureDepth = v.maxDepth;
 
-void calculate_shader_stats(exec_list* instructions, int* outMath, int* outTex, int* outFlow)
-{
-	ir_stats_counter_visitor v;
-	v.run (instructions);
-	*outMath = v.math;
-	*outTex = v.tex;
-	*outFlow = v.flow;
+	ir_liveness liveness;
+	liveness.run (instructions);
+	outCost->liveComponents = liveness.peak_components;
+	outCost->liveVec4s = liveness.peak_vec4s;
+
+	delete loops;
 }
@@ -116,7 +116,7 @@ static void visit_variable (ir_instruction* ir, void* data)
 
 ir_struct_usage_visitor::ir_struct_usage_visitor()
 {
-	this->mem_ctx = ralloc_context(NULL);
+	this->mem_ctx = ralloc_arena_context(NULL);
 	this->struct_list.make_empty();
 	this->callback_enter = visit_variable;
 	this->data_enter = this;
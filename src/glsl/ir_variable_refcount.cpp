@@ -40,6 +40,7 @@ ir_variable_refcount_visitor::ir_variable_refcount_visitor()
    this->mem_ctx = ralloc_context(NULL);
    this->ht = _mesa_hash_table_create(NULL, _mesa_key_pointer_equal);
    this->current_lhs = NULL;
+   this->delta = 1;
 }
 
 static void
@@ -61,6 +62,7 @@ ir_variable_refcount_entry::ir_variable_refcount_entry(ir_variable *var)
    this->var = var;
    assign = NULL;
    assigned_count = 0;
+   call_assigned_count = 0;
    declaration = false;
    referenced_count = 0;
    referenced_count_noself = 0;
@@ -103,6 +105,18 @@ ir_variable_refcount_visitor::find_variable_entry(ir_variable *var)
 ir_visitor_status
 ir_variable_refcount_visitor::visit(ir_variable *ir)
 {
+   if (this->delta < 0) {
+      /* The declaration is gone, and with it any use of the variable. */
+      struct hash_entry *e = _mesa_hash_table_search(this->ht,
+						       _mesa_hash_pointer(ir),
+						       ir);
+      if (e) {
+	 free_entry(e);
+	 _mesa_hash_table_remove(this->ht, e);
+      }
+      return visit_continue;
+   }
+
    ir_variable_refcount_entry *entry = this->get_variable_entry(ir);
    if (entry)
       entry->declaration = true;
@@ -117,9 +131,9 @@ ir_variable_refcount_visitor::visit(ir_dereference_variable *ir)
    ir_variable *const var = ir->variable_referenced();
    ir_variable_refcount_entry *entry = this->get_variable_entry(var);
    if (entry) {
-      entry->referenced_count++;
+      entry->referenced_count += this->delta;
       if (this->in_assignee || var != this->current_lhs)
-         entry->referenced_count_noself++;
+         entry->referenced_count_noself += this->delta;
    }
    return visit_continue;
 }
@@ -151,10 +165,80 @@ ir_variable_refcount_visitor::visit_leave(ir_assignment *ir)
    ir_variable_refcount_entry *entry;
    entry = this->get_variable_entry(ir->lhs->variable_referenced());
    if (entry) {
-      entry->assigned_count++;
-      if (entry->assign == NULL)
-	 entry->assign = ir;
+      entry->assigned_count += this->delta;
+
+      if (this->delta > 0) {
+	 if (entry->assign == NULL)
+	    entry->assign = ir;
+	 else
+	    entry->other_assigns.push_tail(new(this->mem_ctx)
+					   ir_variable_refcount_assign(ir));
+      } else if (entry->assign == ir) {
+	 ir_variable_refcount_assign *next =
+	    (ir_variable_refcount_assign *) entry->other_assigns.pop_head();
+	 entry->assign = next ? next->assign : NULL;
+      } else {
+	 foreach_in_list(ir_variable_refcount_assign, a,
+			 &entry->other_assigns) {
+	    if (a->assign == ir) {
+	       a->remove();
+	       break;
+	    }
+	 }
+      }
    }
 
    return visit_continue;
 }
+
+
+ir_visitor_status
+ir_variable_refcount_visitor::visit_leave(ir_call *ir)
+{
+   foreach_two_lists(formal_node, &ir->callee->parameters,
+                     actual_node, &ir->actual_parameters) {
+      ir_variable *sig_param = (ir_variable *) formal_node;
+      ir_rvalue *param_rval = (ir_rvalue *) actual_node;
+
+      if (sig_param->data.mode == ir_var_function_out ||
+	  sig_param->data.mode == ir_var_function_inout) {
+	 ir_variable *var = param_rval->variable_referenced();
+	 if (var)
+	    this->get_variable_entry(var)->call_assigned_count += this->delta;
+      }
+   }
+
+   if (ir->return_deref != NULL) {
+      ir_variable *var = ir->return_deref->variable_referenced();
+      this->get_variable_entry(var)->call_assigned_count += this->delta;
+   }
+
+   return visit_continue;
+}
+
+
+void
+ir_variable_refcount_visitor::update(ir_instruction *ir, int delta)
+{
+   assert(this->current_lhs == NULL);
+
+   this->delta = delta;
+   ir->accept(this);
+   this->delta = 1;
+}
+
+
+void
+ir_variable_refcount_visitor::update(ir_rvalue *ir, int delta,
+				     ir_variable *lhs, bool in_assignee)
+{
+   assert(this->current_lhs == NULL);
+
+   this->delta = delta;
+   this->current_lhs = lhs;
+   this->in_assignee = in_assignee;
+   ir->accept(this);
+   this->in_assignee = false;
+   this->current_lhs = NULL;
+   this->delta = 1;
+}
@@ -51,7 +51,30 @@ public:
    /** Number of times the variable is assigned. */
    unsigned assigned_count;
 
+   /**
+    * Number of times the variable is written as an out or inout parameter,
+    * or as the return value, of a function call.
+    */
+   unsigned call_assigned_count;
+
    bool declaration; /* If the variable had a decl in the instruction stream */
+
+   /**
+    * Assignments to the variable other than \c assign, in instruction
+    * order, as a list of ir_variable_refcount_assign.
+    */
+   exec_list other_assigns;
+};
+
+class ir_variable_refcount_assign : public exec_node
+{
+public:
+   ir_variable_refcount_assign(ir_assignment *assign)
+   {
+      this->assign = assign;
+   }
+
+   ir_assignment *assign;
 };
 
 class ir_variable_refcount_visitor : public ir_hierarchical_visitor {
@@ -65,12 +88,34 @@ public:
    virtual ir_visitor_status visit_enter(ir_function_signature *);
    virtual ir_visitor_status visit_enter(ir_assignment *);
    virtual ir_visitor_status visit_leave(ir_assignment *);
+   virtual ir_visitor_status visit_leave(ir_call *);
 
    ir_variable_refcount_entry *get_variable_entry(ir_variable *var);
    ir_variable_refcount_entry *find_variable_entry(ir_variable *var);
 
+   /**
+    * \name Incremental updates
+    *
+    * The counts can be kept valid while the IR is rewritten, so that a
+    * later pass can use them without walking the whole program again.
+    * \c delta is 1 for IR that was added and -1 for IR that was removed.
+    */
+   /*@{*/
+   /** Counts a whole top-level instruction, or a variable declaration. */
+   void update(ir_instruction *ir, int delta);
+
+   /**
+    * Counts an rvalue in the RHS of an assignment to \c lhs (NULL if it is
+    * not in an assignment), or in its LHS if \c in_assignee is set.
+    */
+   void update(ir_rvalue *ir, int delta, ir_variable *lhs, bool in_assignee);
+   /*@}*/
+
    struct hash_table *ht;
    ir_variable* current_lhs;
 
+   /** 1 while counting, -1 while uncounting removed IR. */
+   int delta;
+
    void *mem_ctx;
 };
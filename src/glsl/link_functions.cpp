@@ -310,8 +310,15 @@ find_matching_signature(const char *name, const exec_list *actual_parameters,
 			gl_shader **shader_list, unsigned num_shaders,
 			bool use_builtin)
 {
+   gl_shader *const builtin_shader = _mesa_glsl_get_builtin_function_shader();
+
    for (unsigned i = 0; i < num_shaders; i++) {
-      ir_function *const f = shader_list[i]->symbols->get_function(name);
+      /* The built-in shader grows while other threads compile, so its
+       * symbol table may only be read under the built-in lock.
+       */
+      ir_function *const f = shader_list[i] == builtin_shader
+         ? _mesa_glsl_get_builtin_function(name)
+         : shader_list[i]->symbols->get_function(name);
 
       if (f == NULL)
 	 continue;
@@ -196,7 +196,7 @@ class interface_block_definitions
 {
 public:
    interface_block_definitions()
-      : mem_ctx(ralloc_context(NULL)),
+      : mem_ctx(ralloc_arena_context(NULL)),
         ht(hash_table_ctor(0, hash_table_string_hash,
                            hash_table_string_compare))
    {
@@ -254,7 +254,7 @@ link_set_uniform_initializers(struct gl_shader_program *prog,
 	    continue;
 
 	 if (!mem_ctx)
-	    mem_ctx = ralloc_context(NULL);
+	    mem_ctx = ralloc_arena_context(NULL);
 
          if (var->data.explicit_binding) {
             const glsl_type *const type = var->type;
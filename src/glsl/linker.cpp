@@ -1161,7 +1161,7 @@ link_get_main_function_signature(gl_shader *sh)
 class array_sizing_visitor : public ir_hierarchical_visitor {
 public:
    array_sizing_visitor()
-      : mem_ctx(ralloc_context(NULL)),
+      : mem_ctx(ralloc_arena_context(NULL)),
         unnamed_interfaces(hash_table_ctor(0, hash_table_pointer_hash,
                                            hash_table_pointer_compare))
    {
@@ -690,7 +690,7 @@ inline void exec_node::insert_before(exec_list *before)
 #define foreach_list_typed_safe(__type, __node, __field, __list)	\
    for (__type * __node = exec_node_data( __type,			\
 			(__list)->head_sentinel.node.next, __field ),	\
-	       * __next = exec_node_data( __type			\
+	       * __next = exec_node_data( __type,			\
 			(__node)->__field.next, __field );		\
 	(__node)->__field.next != NULL;					\
 	__node = __next, __next =					\
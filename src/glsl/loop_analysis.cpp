@@ -85,7 +85,7 @@ loop_state::loop_state()
 										 hash_table_pointer_compare);
    this->ht_variables = hash_table_ctor(0, hash_table_pointer_hash,
 										 hash_table_pointer_compare);
-   this->mem_ctx = ralloc_context(NULL);
+   this->mem_ctx = ralloc_arena_context(NULL);
    this->loop_found = false;
 }
 
@@ -0,0 +1,254 @@
+/**
+ * \file loop_invariant.cpp
+ *
+ * Loop-invariant code motion.
+ *
+ * Moves expressions and texture fetches whose value cannot change between
+ * iterations of a loop out of the loop body, into a temporary assigned right
+ * before the loop.  An rvalue is invariant in a loop when every variable it
+ * reads is declared outside the loop and is never assigned inside it (per
+ * \c loop_variable_state from loop analysis).  Loops containing calls are
+ * left alone, since the analysis does not see writes to \c out parameters.
+ *
+ * Only the largest invariant subtrees are hoisted, and each one goes in
+ * front of the outermost loop it is invariant in.  Evaluating the hoisted
+ * code when the loop runs zero times is harmless: expressions and texture
+ * fetches have no side effects.
+ */
+
+#include "glsl_types.h"
+#include "loop_analysis.h"
+#include "ir_hierarchical_visitor.h"
+#include "ir_rvalue_visitor.h"
+#include "ir_builder.h"
+#include "util/hash_table.h"
+
+using namespace ir_builder;
+
+namespace {
+
+/* An rvalue already moved in front of a loop, and where it went. */
+class hoisted_rvalue : public exec_node {
+public:
+   ir_rvalue *ir;
+   ir_variable *var;
+};
+
+/* One enclosing loop of the rvalue being looked at. */
+struct loop_level {
+   ir_loop *ir;
+   loop_variable_state *ls;
+   loop_level *outer;
+   unsigned depth;
+   exec_list hoisted;
+};
+
+class loop_invariant_visitor : public ir_rvalue_enter_visitor {
+public:
+   loop_invariant_visitor(loop_state *state)
+   {
+      this->state = state;
+      this->progress = false;
+      this->inner = NULL;
+      this->mem_ctx = ralloc_context(NULL);
+      this->decl_depth = _mesa_hash_table_create(mem_ctx,
+                                                 _mesa_key_pointer_equal);
+   }
+
+   ~loop_invariant_visitor()
+   {
+      ralloc_free(mem_ctx);
+   }
+
+   virtual ir_visitor_status visit(ir_variable *);
+   virtual ir_visitor_status visit_enter(ir_loop *);
+   virtual ir_visitor_status visit_leave(ir_loop *);
+
+   virtual void handle_rvalue(ir_rvalue **rvalue);
+
+   bool invariant_in(const loop_level *level, ir_variable *var);
+   loop_level *hoist_level(ir_rvalue *ir);
+
+   loop_state *state;
+   loop_level *inner;
+   void *mem_ctx;
+   /* Loop nesting depth of variables declared inside loops. */
+   struct hash_table *decl_depth;
+   bool progress;
+};
+
+
+/**
+ * Finds the variables read by an rvalue, and the innermost loop level any
+ * of them forces it to stay in.
+ */
+class invariance_visitor : public ir_hierarchical_visitor {
+public:
+   invariance_visitor(loop_invariant_visitor *v)
+   {
+      this->v = v;
+      this->level = NULL;
+      this->reads_variables = false;
+      this->variant = false;
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      loop_level *var_level = NULL;
+      for (loop_level *l = v->inner; l != NULL; l = l->outer) {
+         if (!v->invariant_in(l, ir->var))
+            break;
+         var_level = l;
+      }
+
+      reads_variables = true;
+      if (var_level == NULL) {
+         /* visit_stop does not make it out of every ir_expression::accept,
+          * so remember it here.
+          */
+         variant = true;
+         return visit_stop;
+      }
+      if (level == NULL || var_level->depth > level->depth)
+         level = var_level;
+      return visit_continue;
+   }
+
+   loop_invariant_visitor *v;
+   loop_level *level;
+   bool reads_variables;
+   bool variant;
+};
+
+} /* anonymous namespace */
+
+
+bool
+loop_invariant_visitor::invariant_in(const loop_level *level,
+                                     ir_variable *var)
+{
+   if (level->ls == NULL || level->ls->contains_calls)
+      return false;
+
+   hash_entry *entry =
+      _mesa_hash_table_search(decl_depth, _mesa_hash_pointer(var), var);
+   if (entry != NULL && (uintptr_t) entry->data >= level->depth)
+      return false;
+
+   loop_variable *lv = level->ls->get(var);
+   return lv != NULL && lv->num_assignments == 0;
+}
+
+
+/**
+ * Returns the outermost loop \c ir is invariant in, or \c NULL if it has
+ * to stay where it is.
+ */
+loop_level *
+loop_invariant_visitor::hoist_level(ir_rvalue *ir)
+{
+   invariance_visitor v(this);
+   ir->accept(&v);
+
+   /* Constant expressions are left to constant folding. */
+   if (!v.reads_variables || v.variant)
+      return NULL;
+   return v.level;
+}
+
+
+ir_visitor_status
+loop_invariant_visitor::visit(ir_variable *ir)
+{
+   if (this->inner != NULL)
+      _mesa_hash_table_insert(decl_depth, _mesa_hash_pointer(ir), ir,
+                              (void *) (uintptr_t) this->inner->depth);
+   return visit_continue;
+}
+
+
+ir_visitor_status
+loop_invariant_visitor::visit_enter(ir_loop *ir)
+{
+   loop_level *level = ralloc(mem_ctx, loop_level);
+   level->hoisted.make_empty();
+   level->ir = ir;
+   level->ls = this->state->get(ir);
+   level->outer = this->inner;
+   level->depth = this->inner ? this->inner->depth + 1 : 1;
+   this->inner = level;
+   return visit_continue;
+}
+
+
+ir_visitor_status
+loop_invariant_visitor::visit_leave(ir_loop *ir)
+{
+   assert(this->inner != NULL && this->inner->ir == ir);
+   this->inner = this->inner->outer;
+   return visit_continue;
+}
+
+
+void
+loop_invariant_visitor::handle_rvalue(ir_rvalue **rvalue)
+{
+   if (*rvalue == NULL || this->inner == NULL)
+      return;
+
+   /* Variable reads, swizzles, constants and negation (a source modifier
+    * on most GPUs) are as cheap to redo every iteration as to read from a
+    * temporary.
+    */
+   ir_rvalue *ir = *rvalue;
+   if (ir->ir_type != ir_type_expression && ir->ir_type != ir_type_texture)
+      return;
+   ir_expression *expr = ir->as_expression();
+   if (expr != NULL && expr->operation == ir_unop_neg)
+      return;
+
+   loop_level *level = hoist_level(ir);
+   if (level == NULL)
+      return;
+
+   /* The same expression already hoisted from elsewhere in the loop. */
+   foreach_in_list(hoisted_rvalue, h, &level->hoisted) {
+      if (h->var->type == ir->type &&
+          h->var->data.precision == ir->get_precision() &&
+          h->ir->equals(ir)) {
+         *rvalue = new(ir) ir_dereference_variable(h->var);
+         this->progress = true;
+         return;
+      }
+   }
+
+   ir_variable *var = new(ir) ir_variable(ir->type, "licm",
+                                          ir_var_temporary,
+                                          ir->get_precision());
+   level->ir->insert_before(var);
+   level->ir->insert_before(assign(var, ir));
+   if (level->outer != NULL)
+      _mesa_hash_table_insert(decl_depth, _mesa_hash_pointer(var), var,
+                              (void *) (uintptr_t) level->outer->depth);
+
+   hoisted_rvalue *h = new(mem_ctx) hoisted_rvalue;
+   h->ir = ir;
+   h->var = var;
+   level->hoisted.push_tail(h);
+
+   *rvalue = new(ir) ir_dereference_variable(var);
+   this->progress = true;
+}
+
+
+/**
+ * Hoists loop-invariant expressions out of the loops described by \c ls.
+ */
+bool
+hoist_loop_invariants(exec_list *instructions, loop_state *ls)
+{
+   loop_invariant_visitor v(ls);
+
+   v.run(instructions);
+   return v.progress;
+}
@@ -24,9 +24,13 @@
 #include "glsl_types.h"
 #include "loop_analysis.h"
 #include "ir_hierarchical_visitor.h"
+#include "ir_rvalue_visitor.h"
+#include "ir_stats.h"
 
 #include "main/mtypes.h"
 
+class loop_unroll_count;
+
 namespace {
 
 class loop_unroll_visitor : public ir_hierarchical_visitor {
@@ -40,9 +44,14 @@ public:
    }
 
    virtual ir_visitor_status visit_leave(ir_loop *ir);
+   bool unroll_fits(const loop_unroll_count &count, int copies);
+   int partial_unroll_factor(ir_loop *ir, loop_variable_state *ls,
+                             const loop_unroll_count &count, int iterations);
    void simple_unroll(ir_loop *ir, int iterations);
    void complex_unroll(ir_loop *ir, int iterations,
                        bool continue_from_then_branch);
+   void partial_unroll(ir_loop *ir, loop_variable_state *ls,
+                       const loop_unroll_count &count, int iterations);
    void splice_post_if_instructions(ir_if *ir_if, exec_list *splice_dest);
 
    loop_state *state;
@@ -63,6 +72,8 @@ is_break(ir_instruction *ir)
 class loop_unroll_count : public ir_hierarchical_visitor {
 public:
    int nodes;
+   /* Components of the temporaries declared in the body. */
+   int temps;
    bool unsupported_variable_indexing;
    /* If there are nested loops, the node count will be inaccurate. */
    bool nested_loop;
@@ -72,6 +83,7 @@ public:
       : ls(ls), options(options)
    {
       nodes = 0;
+      temps = 0;
       nested_loop = false;
       unsupported_variable_indexing = false;
 
@@ -96,6 +108,12 @@ public:
       return visit_continue;
    }
 
+   virtual ir_visitor_status visit(ir_variable *ir)
+   {
+      temps += ir->type->component_slots();
+      return visit_continue;
+   }
+
    virtual ir_visitor_status visit_enter(ir_dereference_array *ir)
    {
       /* Check for arrays variably-indexed by a loop induction variable.
@@ -244,6 +262,185 @@ loop_unroll_visitor::complex_unroll(ir_loop *ir, int iterations,
 }
 
 
+/**
+ * Replaces reads of the counter of a loop with (counter + offset).
+ */
+class loop_unroll_offset : public ir_rvalue_visitor {
+public:
+   loop_unroll_offset(ir_variable *counter, ir_constant *offset)
+      : counter(counter), offset(offset)
+   {
+   }
+
+   virtual void handle_rvalue(ir_rvalue **rvalue)
+   {
+      if (*rvalue == NULL)
+         return;
+
+      ir_dereference_variable *deref = (*rvalue)->as_dereference_variable();
+      if (deref == NULL || deref->var != counter)
+         return;
+
+      void *mem_ctx = ralloc_parent(deref);
+      *rvalue = new(mem_ctx) ir_expression(ir_binop_add, deref,
+                                           offset->clone(mem_ctx, NULL));
+   }
+
+private:
+   ir_variable *counter;
+   ir_constant *offset;
+};
+
+
+/**
+ * The scalar int or uint constant \c inc times \c factor.
+ */
+static ir_constant *
+scaled_increment(void *mem_ctx, ir_constant *inc, int factor)
+{
+   ir_constant_data data;
+   memset(&data, 0, sizeof(data));
+   switch (inc->type->base_type) {
+   case GLSL_TYPE_UINT:
+      data.u[0] = inc->value.u[0] * factor;
+      break;
+   case GLSL_TYPE_INT:
+      data.i[0] = inc->value.i[0] * factor;
+      break;
+   default:
+      unreachable("unsupported increment type");
+   }
+   return new(mem_ctx) ir_constant(inc->type, &data, inc->get_precision());
+}
+
+
+/**
+ * The induction variable tested by the limiting terminator of a loop, if the
+ * loop has the shape partial unrolling handles:
+ *
+ *     (loop (
+ *        (if (counter-test) (break))
+ *        ...body...
+ *        (assign (counter) (counter + inc))))
+ *
+ * with no other loop jumps or calls, a constant int or uint increment and no
+ * other assignments to the counter.  The copies compute the counter as
+ * i + k * inc, which only equals k additions of inc for integers.
+ */
+static loop_variable *
+partial_unroll_counter(ir_loop *ir, loop_variable_state *ls)
+{
+   if (ls->num_loop_jumps != 1 || ls->contains_calls)
+      return NULL;
+
+   ir_instruction *first = (ir_instruction *) ir->body_instructions.get_head();
+   ir_instruction *last = (ir_instruction *) ir->body_instructions.get_tail();
+   if (first != ls->limiting_terminator->ir || last == first)
+      return NULL;
+
+   ir_expression *cond = ls->limiting_terminator->ir->condition->as_expression();
+   if (cond == NULL || cond->get_num_operands() != 2)
+      return NULL;
+
+   for (unsigned i = 0; i < 2; i++) {
+      ir_dereference_variable *deref = cond->operands[i]->as_dereference_variable();
+      if (deref == NULL)
+         continue;
+
+      loop_variable *lv = ls->get(deref->var);
+      if (lv == NULL || !lv->is_induction_var() || lv->num_assignments != 1 ||
+          lv->conditional_or_nested_assignment || lv->first_assignment != last)
+         continue;
+
+      ir_constant *inc = lv->increment->constant_expression_value();
+      if (inc == NULL || !inc->type->is_scalar() ||
+          (inc->type->base_type != GLSL_TYPE_INT &&
+           inc->type->base_type != GLSL_TYPE_UINT))
+         continue;
+
+      return lv;
+   }
+   return NULL;
+}
+
+
+/**
+ * Unroll a loop of the shape described at partial_unroll_counter by the
+ * factor partial_unroll_factor picks, if any: the body gets \c factor copies that each see the counter value
+ * of their iteration, and the counter steps by \c factor increments.
+ * Iterations that don't fill a whole unrolled iteration are peeled off in
+ * front of the loop.  For example, if the input is:
+ *
+ *     (loop ((if (i >= 10) (break)) ...instrs(i)... (assign (i) (i + 1))))
+ *
+ * And the factor is 4, the output will be:
+ *
+ *     ...instrs(i)... (assign (i) (i + 1))
+ *     ...instrs(i)... (assign (i) (i + 1))
+ *     (loop ((if (i >= 10) (break))
+ *            ...instrs(i)... ...instrs(i + 1)...
+ *            ...instrs(i + 2)... ...instrs(i + 3)...
+ *            (assign (i) (i + 4))))
+ */
+void
+loop_unroll_visitor::partial_unroll(ir_loop *ir, loop_variable_state *ls,
+                                    const loop_unroll_count &count,
+                                    int iterations)
+{
+   const int factor = partial_unroll_factor(ir, ls, count, iterations);
+   if (factor < 2)
+      return;
+
+   void *const mem_ctx = ralloc_parent(ir);
+   loop_variable *lv = partial_unroll_counter(ir, ls);
+   ir_constant *inc = lv->increment->constant_expression_value();
+
+   /* Peeled iterations run the whole body; the test can't fail in them. */
+   for (int i = 0; i < iterations % factor; i++) {
+      exec_list copy_list;
+
+      copy_list.make_empty();
+      clone_ir_list(mem_ctx, &copy_list, &ir->body_instructions);
+      ((ir_instruction *) copy_list.get_head())->remove();
+
+      ir->insert_before(&copy_list);
+   }
+
+   ir_instruction *terminator = ls->limiting_terminator->ir;
+   ir_assignment *increment = lv->first_assignment;
+   terminator->remove();
+   increment->remove();
+
+   exec_list body;
+   ir->body_instructions.move_nodes_to(&body);
+   ir->body_instructions.push_tail(terminator);
+
+   for (int i = 0; i < factor; i++) {
+      exec_list copy_list;
+
+      copy_list.make_empty();
+      clone_ir_list(mem_ctx, &copy_list, &body);
+
+      if (i > 0) {
+         loop_unroll_offset v(lv->var, scaled_increment(mem_ctx, inc, i));
+         v.run(&copy_list);
+      }
+
+      ir->body_instructions.append_list(&copy_list);
+   }
+
+   increment->rhs =
+      new(mem_ctx) ir_expression(ir_binop_add,
+                                 new(mem_ctx) ir_dereference_variable(lv->var),
+                                 scaled_increment(mem_ctx, inc, factor));
+   ir->body_instructions.push_tail(increment);
+   ir->unroll_factor = factor;
+   ir->source_iterations = iterations;
+
+   this->progress = true;
+}
+
+
 /**
  * Move all of the instructions which follow \c ir_if to the end of
  * \c splice_dest.
@@ -278,6 +475,77 @@ loop_unroll_visitor::splice_post_if_instructions(ir_if *ir_if,
 }
 
 
+/**
+ * Whether \c copies copies of a loop body stay within the unrolling budget:
+ * MaxUnrollSizePerIteration * MaxUnrollIterations instructions, and
+ * MaxUnrollTemps components of temporaries.
+ */
+bool
+loop_unroll_visitor::unroll_fits(const loop_unroll_count &count, int copies)
+{
+   const int max_size =
+      options->MaxUnrollIterations * options->MaxUnrollSizePerIteration;
+
+   if (count.nodes * copies > max_size)
+      return false;
+
+   if (options->MaxUnrollTemps != 0 &&
+       count.temps * copies > (int) options->MaxUnrollTemps)
+      return false;
+
+   return true;
+}
+
+
+/**
+ * Cost model for partially unrolling a loop that can't be unrolled fully.
+ *
+ * An iteration runs the body -- ALU instructions, texture fetches at
+ * UnrollTextureCost and branches at UnrollBranchCost, as counted by
+ * ir_stats_counter_visitor -- and branches back to the top.  The exit test
+ * (a compare and a branch) and the branch back are loop overhead, which a
+ * loop unrolled by k only pays every k iterations.
+ *
+ * Returns the largest factor up to MaxUnrollFactor whose copies (plus the
+ * iterations peeled off to make the trip count a multiple of it) fit the
+ * budget, if it saves at least MinUnrollGain percent of the run time;
+ * otherwise 0.
+ */
+int
+loop_unroll_visitor::partial_unroll_factor(ir_loop *ir,
+                                           loop_variable_state *ls,
+                                           const loop_unroll_count &count,
+                                           int iterations)
+{
+   /* Unrolling again would multiply the factors. */
+   if (ir->unroll_factor > 1 || count.nested_loop ||
+       partial_unroll_counter(ir, ls) == NULL)
+      return 0;
+
+   ir_stats_counter_visitor stats;
+   stats.run(&ir->body_instructions);
+
+   const int branch = options->UnrollBranchCost;
+   const int time = stats.math + stats.tex * options->UnrollTextureCost +
+                    (stats.flow + 1) * branch;
+   const int overhead = 1 + 2 * branch;
+
+   for (int factor = MIN2((int) options->MaxUnrollFactor, iterations / 2);
+        factor >= 2; factor--) {
+      if (!unroll_fits(count, factor + iterations % factor))
+         continue;
+
+      /* The gain only gets smaller with smaller factors. */
+      if (100 * overhead * (factor - 1) <
+          (int) options->MinUnrollGain * time * factor)
+         return 0;
+
+      return factor;
+   }
+   return 0;
+}
+
+
 ir_visitor_status
 loop_unroll_visitor::visit_leave(ir_loop *ir)
 {
@@ -302,20 +570,28 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
 
    const int max_iterations = options->MaxUnrollIterations;
 
-   /* Don't try to unroll loops that have zillions of iterations either.
+   loop_unroll_count count(&ir->body_instructions, ls, options);
+
+   /* Don't try to fully unroll loops that have zillions of iterations either.
+    * A partially unrolled loop counts all iterations of the source loop,
+    * including those peeled off in front of it.
     */
-   if (iterations > max_iterations)
+   const int source_iterations =
+      ir->unroll_factor > 1 ? (int) ir->source_iterations : iterations;
+   if (source_iterations > max_iterations) {
+      partial_unroll(ir, ls, count, iterations);
       return visit_continue;
+   }
 
-   /* Don't try to unroll nested loops and loops with a huge body.
+   /* Don't try to fully unroll nested loops and loops with a huge body.
     */
-   loop_unroll_count count(&ir->body_instructions, ls, options);
-
    bool loop_too_large =
-      count.nested_loop || count.nodes * iterations > (int)max_iterations * 25;
+      count.nested_loop || !unroll_fits(count, iterations);
 
-   if (loop_too_large && !count.unsupported_variable_indexing)
+   if (loop_too_large && !count.unsupported_variable_indexing) {
+      partial_unroll(ir, ls, count, iterations);
       return visit_continue;
+   }
 
    /* Note: the limiting terminator contributes 1 to ls->num_loop_jumps.
     * We'll be removing the limiting terminator before we unroll.
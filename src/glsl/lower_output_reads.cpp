@@ -77,7 +77,7 @@ hash_table_var_hash(const void *key)
 
 output_read_remover::output_read_remover()
 {
-   mem_ctx = ralloc_context(NULL);
+   mem_ctx = ralloc_arena_context(NULL);
    replacements =
       hash_table_ctor(0, hash_table_var_hash, hash_table_pointer_compare);
 }
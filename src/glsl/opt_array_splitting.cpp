@@ -92,7 +92,7 @@ public:
    ir_array_reference_visitor(bool split_shader_outputs)
    {
       this->split_shader_outputs = split_shader_outputs;
-      this->mem_ctx = ralloc_context(NULL);
+      this->mem_ctx = ralloc_arena_context(NULL);
       this->variable_list.make_empty();
    }
 
@@ -363,7 +363,7 @@ optimize_split_arrays(exec_list *instructions, bool linked, bool split_shader_ou
    if (!refs.get_split_list(instructions, linked))
       return false;
 
-   void *mem_ctx = ralloc_context(NULL);
+   void *mem_ctx = ralloc_arena_context(NULL);
 
    /* Replace the decls of the arrays to be split with their split
     * components.
@@ -35,7 +35,9 @@
 #include "ir.h"
 #include "ir_visitor.h"
 #include "ir_optimization.h"
+#include "ir_variable_refcount.h"
 #include "glsl_types.h"
+#include "util/hash_table.h"
 
 namespace {
 
@@ -178,12 +180,50 @@ ir_constant_variable_visitor::visit_enter(ir_function_signature *ir)
 }
 
 
+/**
+ * Marks variables with a single constant assignment, using the counts in
+ * \c refs instead of walking the instructions.  Doesn't change the counts.
+ */
+static bool
+do_constant_variable(ir_variable_refcount_visitor *refs)
+{
+   bool progress = false;
+
+   struct hash_entry *e;
+   hash_table_foreach(refs->ht, e) {
+      ir_variable_refcount_entry *entry = (ir_variable_refcount_entry *)e->data;
+
+      if (!entry->declaration ||
+	  entry->assigned_count + entry->call_assigned_count != 1 ||
+	  entry->var->constant_value)
+	 continue;
+
+      ir_assignment *assign = entry->assign;
+      if (!assign || assign->condition || !assign->whole_variable_written())
+	 continue;
+
+      ir_constant *constval = assign->rhs->constant_expression_value();
+      if (constval) {
+	 entry->var->constant_value = constval;
+	 progress = true;
+      }
+   }
+
+   return progress;
+}
+
 /**
  * Does a copy propagation pass on the code present in the instruction stream.
+ *
+ * If \c refs is given, it must hold the current counts of \c instructions.
  */
 bool
-do_constant_variable(exec_list *instructions)
+do_constant_variable(exec_list *instructions,
+		     ir_variable_refcount_visitor *refs)
 {
+   if (refs)
+      return do_constant_variable(refs);
+
    bool progress = false;
    ir_constant_variable_visitor v;
 
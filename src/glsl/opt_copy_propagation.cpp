@@ -30,6 +30,13 @@
  * This should reduce the number of MOV instructions in the generated
  * programs unless copy propagation is also done on the LIR, and may
  * help anyway by triggering other optimizations that live in the HIR.
+ *
+ * The ACP and kill sets are hash tables keyed by ir_variable, so looking
+ * up a dereference or killing a variable doesn't walk every copy that is
+ * currently available.  Nested blocks don't clone their parent's ACP:
+ * each block only records its own copies and kills, and lookups walk
+ * outwards through the enclosing blocks, skipping any copy whose source
+ * or destination was killed on the way.
  */
 
 #include "ir.h"
@@ -37,6 +44,7 @@
 #include "ir_basic_block.h"
 #include "ir_optimization.h"
 #include "glsl_types.h"
+#include "util/hash_table.h"
 
 namespace {
 
@@ -56,16 +64,54 @@ public:
 };
 
 
-class kill_entry : public exec_node
+/**
+ * Copy propagation state of a single block.
+ *
+ * The tables are only created once something is added to them, since most
+ * blocks never see a copy.
+ */
+class acp_block
 {
 public:
-   kill_entry(ir_variable *var)
+   DECLARE_RALLOC_CXX_OPERATORS(acp_block)
+
+   acp_block(acp_block *parent)
    {
-      assert(var);
-      this->var = var;
+      this->parent = parent;
+      this->acp = NULL;
+      this->rhs_uses = NULL;
+      this->kills = NULL;
+      this->killed_all = false;
    }
 
-   ir_variable *var;
+   /**
+    * Enclosing block whose copies are still available in this one, or
+    * NULL if this block starts out with an empty ACP.
+    */
+   acp_block *parent;
+
+   /** Available copies made in this block: lhs variable -> acp_entry */
+   struct hash_table *acp;
+
+   /**
+    * Reverse map of \c acp: rhs variable -> exec_list of the acp_entry
+    * copying from it.
+    */
+   struct hash_table *rhs_uses;
+
+   /** Set of variables whose values were killed in this block. */
+   struct hash_table *kills;
+
+   /**
+    * Whether a call killed every copy available on entry to this block.
+    */
+   bool killed_all;
+
+   bool is_killed(ir_variable *var)
+   {
+      return kills &&
+	 _mesa_hash_table_search(kills, _mesa_hash_pointer(var), var);
+   }
 };
 
 class ir_copy_propagation_visitor : public ir_hierarchical_visitor {
@@ -73,9 +119,8 @@ public:
    ir_copy_propagation_visitor()
    {
       progress = false;
-      mem_ctx = ralloc_context(0);
-      this->acp = new(mem_ctx) exec_list;
-      this->kills = new(mem_ctx) exec_list;
+      mem_ctx = ralloc_arena_context(0);
+      this->block = new(mem_ctx) acp_block(NULL);
    }
    ~ir_copy_propagation_visitor()
    {
@@ -91,21 +136,16 @@ public:
    virtual ir_visitor_status visit_enter(class ir_if *);
 
    void add_copy(ir_assignment *ir);
+   ir_variable *find_copy(ir_variable *var);
    void kill(ir_variable *ir);
-   void handle_if_block(exec_list *instructions);
+   void kill_all();
+   void handle_block(exec_list *instructions, bool inherit_acp);
 
-   /** List of acp_entry: The available copies to propagate */
-   exec_list *acp;
-   /**
-    * List of kill_entry: The variables whose values were killed in this
-    * block.
-    */
-   exec_list *kills;
+   /** ACP and kills of the block currently being visited. */
+   acp_block *block;
 
    bool progress;
 
-   bool killed_all;
-
    void *mem_ctx;
 };
 
@@ -118,19 +158,13 @@ ir_copy_propagation_visitor::visit_enter(ir_function_signature *ir)
     * block.  Any instructions at global scope will be shuffled into
     * main() at link time, so they're irrelevant to us.
     */
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
+   acp_block *orig_block = this->block;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
+   this->block = new(mem_ctx) acp_block(NULL);
 
    visit_list_elements(this, &ir->body);
 
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = orig_killed_all;
+   this->block = orig_block;
 
    return visit_continue_with_parent;
 }
@@ -152,6 +186,38 @@ ir_copy_propagation_visitor::visit_enter(ir_function *ir)
    return visit_continue;
 }
 
+/**
+ * Returns the variable \c var is currently a copy of, or NULL.
+ *
+ * Copies recorded in an enclosing block are only usable if neither of
+ * their variables has been killed by any of the blocks in between.
+ */
+ir_variable *
+ir_copy_propagation_visitor::find_copy(ir_variable *var)
+{
+   const uint32_t hash = _mesa_hash_pointer(var);
+
+   for (acp_block *b = this->block; b != NULL; b = b->parent) {
+      struct hash_entry *e =
+	 b->acp ? _mesa_hash_table_search(b->acp, hash, var) : NULL;
+
+      if (e) {
+	 acp_entry *entry = (acp_entry *) e->data;
+
+	 for (acp_block *k = this->block; k != b; k = k->parent) {
+	    if (k->is_killed(entry->rhs))
+	       return NULL;
+	 }
+	 return entry->rhs;
+      }
+
+      if (b->killed_all || b->is_killed(var))
+	 return NULL;
+   }
+
+   return NULL;
+}
+
 /**
  * Replaces dereferences of ACP RHS variables with ACP LHS variables.
  *
@@ -165,14 +231,10 @@ ir_copy_propagation_visitor::visit(ir_dereference_variable *ir)
    if (this->in_assignee)
       return visit_continue;
 
-   ir_variable *var = ir->var;
-
-   foreach_in_list(acp_entry, entry, this->acp) {
-      if (var == entry->lhs) {
-	 ir->var = entry->rhs;
-	 this->progress = true;
-	 break;
-      }
+   ir_variable *rhs = find_copy(ir->var);
+   if (rhs) {
+      ir->var = rhs;
+      this->progress = true;
    }
 
    return visit_continue;
@@ -198,42 +260,39 @@ ir_copy_propagation_visitor::visit_enter(ir_call *ir)
 	* For any built-in functions, do not do this; they are side effect-free.
     */
    if (!ir->callee->is_builtin()) {
-      acp->make_empty();
-      this->killed_all = true;
+      kill_all();
    }
 
    return visit_continue_with_parent;
 }
 
+/**
+ * Visits a nested block, then applies its kills to the enclosing block.
+ *
+ * If \p inherit_acp is set, the copies available in the enclosing block
+ * are visible inside the nested one; otherwise it starts out empty.
+ */
 void
-ir_copy_propagation_visitor::handle_if_block(exec_list *instructions)
+ir_copy_propagation_visitor::handle_block(exec_list *instructions,
+					  bool inherit_acp)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
+   acp_block *orig_block = this->block;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
-
-   /* Populate the initial acp with a copy of the original */
-   foreach_in_list(acp_entry, a, orig_acp) {
-      this->acp->push_tail(new(this->mem_ctx) acp_entry(a->lhs, a->rhs));
-   }
+   this->block = new(mem_ctx) acp_block(inherit_acp ? orig_block : NULL);
 
    visit_list_elements(this, instructions);
 
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
+   acp_block *new_block = this->block;
+   this->block = orig_block;
 
-   exec_list *new_kills = this->kills;
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = this->killed_all || orig_killed_all;
+   if (new_block->killed_all)
+      kill_all();
 
-   foreach_in_list(kill_entry, k, new_kills) {
-      kill(k->var);
+   if (new_block->kills) {
+      struct hash_entry *e;
+      hash_table_foreach(new_block->kills, e) {
+	 kill((ir_variable *) e->data);
+      }
    }
 }
 
@@ -242,42 +301,21 @@ ir_copy_propagation_visitor::visit_enter(ir_if *ir)
 {
    ir->condition->accept(this);
 
-   handle_if_block(&ir->then_instructions);
-   handle_if_block(&ir->else_instructions);
+   handle_block(&ir->then_instructions, true);
+   handle_block(&ir->else_instructions, true);
 
-   /* handle_if_block() already descended into the children. */
+   /* handle_block() already descended into the children. */
    return visit_continue_with_parent;
 }
 
 ir_visitor_status
 ir_copy_propagation_visitor::visit_enter(ir_loop *ir)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
-
    /* FINISHME: For now, the initial acp for loops is totally empty.
     * We could go through once, then go through again with the acp
     * cloned minus the killed entries after the first run through.
     */
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
-
-   visit_list_elements(this, &ir->body_instructions);
-
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
-
-   exec_list *new_kills = this->kills;
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = this->killed_all || orig_killed_all;
-
-   foreach_in_list(kill_entry, k, new_kills) {
-      kill(k->var);
-   }
+   handle_block(&ir->body_instructions, false);
 
    /* already descended into the children. */
    return visit_continue_with_parent;
@@ -288,16 +326,51 @@ ir_copy_propagation_visitor::kill(ir_variable *var)
 {
    assert(var != NULL);
 
-   /* Remove any entries currently in the ACP for this kill. */
-   foreach_in_list_safe(acp_entry, entry, acp) {
-      if (entry->lhs == var || entry->rhs == var) {
-	 entry->remove();
+   acp_block *b = this->block;
+   const uint32_t hash = _mesa_hash_pointer(var);
+
+   /* Remove any entries currently in the ACP for this kill: first the copy
+    * into var, then every copy out of it.
+    */
+   if (b->acp) {
+      struct hash_entry *e = _mesa_hash_table_search(b->acp, hash, var);
+      if (e) {
+	 ((acp_entry *) e->data)->remove();
+	 _mesa_hash_table_remove(b->acp, e);
+      }
+
+      e = _mesa_hash_table_search(b->rhs_uses, hash, var);
+      if (e) {
+	 exec_list *uses = (exec_list *) e->data;
+	 foreach_in_list(acp_entry, entry, uses) {
+	    _mesa_hash_table_remove(b->acp,
+				    _mesa_hash_table_search(b->acp,
+							    _mesa_hash_pointer(entry->lhs),
+							    entry->lhs));
+	 }
+	 _mesa_hash_table_remove(b->rhs_uses, e);
       }
    }
 
-   /* Add the LHS variable to the list of killed variables in this block.
+   /* Add the LHS variable to the set of killed variables in this block.
+    * Copies inherited from enclosing blocks are filtered against it.
     */
-   this->kills->push_tail(new(this->mem_ctx) kill_entry(var));
+   if (!b->kills)
+      b->kills = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+   if (!_mesa_hash_table_search(b->kills, hash, var))
+      _mesa_hash_table_insert(b->kills, hash, var, var);
+}
+
+/**
+ * Drops every copy available in the current block, including the ones
+ * inherited from enclosing blocks.
+ */
+void
+ir_copy_propagation_visitor::kill_all()
+{
+   this->block->acp = NULL;
+   this->block->rhs_uses = NULL;
+   this->block->killed_all = true;
 }
 
 /**
@@ -329,8 +402,25 @@ ir_copy_propagation_visitor::add_copy(ir_assignment *ir)
 		  // it might eventually leave our rvalue node with a different precision
 		  // than rhs. Which would trip up platforms that need strict casts (like Metal).
 		  if (lhs_var->data.precision == rhs_var->data.precision || lhs_var->data.precision==glsl_precision_undefined) {
+			acp_block *b = this->block;
+			if (!b->acp) {
+			   b->acp = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+			   b->rhs_uses = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+			}
+
+			const uint32_t rhs_hash = _mesa_hash_pointer(rhs_var);
+			struct hash_entry *e = _mesa_hash_table_search(b->rhs_uses, rhs_hash, rhs_var);
+			exec_list *uses;
+			if (e) {
+			   uses = (exec_list *) e->data;
+			} else {
+			   uses = new(mem_ctx) exec_list;
+			   _mesa_hash_table_insert(b->rhs_uses, rhs_hash, rhs_var, uses);
+			}
+
 			entry = new(this->mem_ctx) acp_entry(lhs_var, rhs_var);
-			this->acp->push_tail(entry);
+			uses->push_tail(entry);
+			_mesa_hash_table_insert(b->acp, _mesa_hash_pointer(lhs_var), lhs_var, entry);
 		  }
       }
    }
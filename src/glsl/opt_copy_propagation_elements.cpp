@@ -39,6 +39,10 @@
  * This should reduce the number of MOV instructions in the generated
  * programs unless copy propagation is also done on the LIR, and may
  * help anyway by triggering other optimizations that live in the HIR.
+ *
+ * As in opt_copy_propagation, the ACP and kill sets are hash tables keyed
+ * by ir_variable, and nested blocks look copies up through their enclosing
+ * blocks instead of cloning the parent's ACP on entry.
  */
 
 #include "ir.h"
@@ -46,6 +50,7 @@
 #include "ir_basic_block.h"
 #include "ir_optimization.h"
 #include "glsl_types.h"
+#include "util/hash_table.h"
 
 static bool debug = false;
 
@@ -62,13 +67,8 @@ public:
       memcpy(this->swizzle, swizzle, sizeof(this->swizzle));
    }
 
-   acp_entry(acp_entry *a)
-   {
-      this->lhs = a->lhs;
-      this->rhs = a->rhs;
-      this->write_mask = a->write_mask;
-      memcpy(this->swizzle, a->swizzle, sizeof(this->swizzle));
-   }
+   /** Link in the list of copies out of \c rhs. */
+   exec_node rhs_link;
 
    ir_variable *lhs;
    ir_variable *rhs;
@@ -77,9 +77,11 @@ public:
 };
 
 
-class kill_entry : public exec_node
+class kill_entry
 {
 public:
+   DECLARE_RALLOC_CXX_OPERATORS(kill_entry)
+
    kill_entry(ir_variable *var, int write_mask)
    {
       this->var = var;
@@ -90,16 +92,71 @@ public:
    unsigned int write_mask;
 };
 
+/**
+ * Copy propagation state of a single block.
+ *
+ * The tables are only created once something is added to them, since most
+ * blocks never see a copy.
+ */
+class acp_block
+{
+public:
+   DECLARE_RALLOC_CXX_OPERATORS(acp_block)
+
+   acp_block(acp_block *parent)
+   {
+      this->parent = parent;
+      this->acp = NULL;
+      this->rhs_uses = NULL;
+      this->kills = NULL;
+      this->killed_all = false;
+   }
+
+   /**
+    * Enclosing block whose copies are still available in this one, or
+    * NULL if this block starts out with an empty ACP.
+    */
+   acp_block *parent;
+
+   /**
+    * Available copies made in this block: lhs variable -> exec_list of
+    * acp_entry, oldest first.
+    */
+   struct hash_table *acp;
+
+   /**
+    * Reverse map of \c acp: rhs variable -> exec_list of the acp_entry
+    * copying from it, linked through acp_entry::rhs_link.
+    */
+   struct hash_table *rhs_uses;
+
+   /** Variables whose values were killed in this block -> kill_entry. */
+   struct hash_table *kills;
+
+   /**
+    * Whether a call killed every copy available on entry to this block.
+    */
+   bool killed_all;
+
+   kill_entry *find_kill(ir_variable *var)
+   {
+      if (!kills)
+	 return NULL;
+
+      struct hash_entry *e =
+	 _mesa_hash_table_search(kills, _mesa_hash_pointer(var), var);
+      return e ? (kill_entry *) e->data : NULL;
+   }
+};
+
 class ir_copy_propagation_elements_visitor : public ir_rvalue_visitor {
 public:
    ir_copy_propagation_elements_visitor()
    {
       this->progress = false;
-      this->killed_all = false;
-      this->mem_ctx = ralloc_context(NULL);
+      this->mem_ctx = ralloc_arena_context(NULL);
       this->shader_mem_ctx = NULL;
-      this->acp = new(mem_ctx) exec_list;
-      this->kills = new(mem_ctx) exec_list;
+      this->block = new(mem_ctx) acp_block(NULL);
    }
    ~ir_copy_propagation_elements_visitor()
    {
@@ -116,21 +173,16 @@ public:
    void handle_rvalue(ir_rvalue **rvalue);
 
    void add_copy(ir_assignment *ir);
-   void kill(kill_entry *k);
-   void handle_if_block(exec_list *instructions);
+   void kill(ir_variable *var, unsigned write_mask);
+   void kill_all();
+   bool killed_since(acp_block *b, ir_variable *var);
+   void handle_block(exec_list *instructions, bool inherit_acp);
 
-   /** List of acp_entry: The available copies to propagate */
-   exec_list *acp;
-   /**
-    * List of kill_entry: The variables whose values were killed in this
-    * block.
-    */
-   exec_list *kills;
+   /** ACP and kills of the block currently being visited. */
+   acp_block *block;
 
    bool progress;
 
-   bool killed_all;
-
    /* Context for our local data structures. */
    void *mem_ctx;
    /* Context for allocating new shader nodes. */
@@ -146,19 +198,13 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_function_signature *ir)
     * block.  Any instructions at global scope will be shuffled into
     * main() at link time, so they're irrelevant to us.
     */
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
+   acp_block *orig_block = this->block;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
+   this->block = new(mem_ctx) acp_block(NULL);
 
    visit_list_elements(this, &ir->body);
 
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = orig_killed_all;
+   this->block = orig_block;
 
    return visit_continue_with_parent;
 }
@@ -170,14 +216,10 @@ ir_copy_propagation_elements_visitor::visit_leave(ir_assignment *ir)
    ir_variable *var = ir->lhs->variable_referenced();
 
    if (var->type->is_scalar() || var->type->is_vector()) {
-      kill_entry *k;
-
       if (lhs)
-	 k = new(mem_ctx) kill_entry(var, ir->write_mask);
+	 kill(var, ir->write_mask);
       else
-	 k = new(mem_ctx) kill_entry(var, ~0);
-
-      kill(k);
+	 kill(var, ~0);
    }
 
    add_copy(ir);
@@ -194,6 +236,21 @@ ir_copy_propagation_elements_visitor::visit_leave(ir_swizzle *)
    return visit_continue;
 }
 
+/**
+ * Returns whether \p var was killed by any block between the current one
+ * and \p b, which would make the copies \p b made out of it unusable.
+ */
+bool
+ir_copy_propagation_elements_visitor::killed_since(acp_block *b,
+						   ir_variable *var)
+{
+   for (acp_block *k = this->block; k != b; k = k->parent) {
+      if (k->find_kill(var))
+	 return true;
+   }
+   return false;
+}
+
 /**
  * Replaces dereferences of ACP RHS variables with ACP LHS variables.
  *
@@ -241,22 +298,45 @@ ir_copy_propagation_elements_visitor::handle_rvalue(ir_rvalue **ir)
       return;
 
    ir_variable *var = deref_var->var;
+   const uint32_t hash = _mesa_hash_pointer(var);
 
    /* Try to find ACP entries covering swizzle_chan[], hoping they're
-    * the same source variable.
+    * the same source variable.  The newest copy of a channel wins, so walk
+    * from the current block outwards and each block's copies newest first,
+    * masking out the channels killed in the blocks walked through.
     */
-   foreach_in_list(acp_entry, entry, this->acp) {
-      if (var == entry->lhs) {
-	 for (int c = 0; c < chans; c++) {
-	    if (entry->write_mask & (1 << swizzle_chan[c])) {
-	       source[c] = entry->rhs;
-	       source_chan[c] = entry->swizzle[swizzle_chan[c]];
-
-               if (source_chan[c] != swizzle_chan[c])
-                  noop_swizzle = false;
+   unsigned found = 0;
+   unsigned killed_mask = 0;
+   for (acp_block *b = this->block; b != NULL; b = b->parent) {
+      struct hash_entry *e =
+	 b->acp ? _mesa_hash_table_search(b->acp, hash, var) : NULL;
+
+      if (e) {
+	 foreach_in_list_reverse(acp_entry, entry, (exec_list *) e->data) {
+	    const unsigned write_mask = entry->write_mask & ~killed_mask;
+	    if (!write_mask || killed_since(b, entry->rhs))
+	       continue;
+
+	    for (int c = 0; c < chans; c++) {
+	       if (!(found & (1 << c)) &&
+		   (write_mask & (1 << swizzle_chan[c]))) {
+		  source[c] = entry->rhs;
+		  source_chan[c] = entry->swizzle[swizzle_chan[c]];
+		  found |= 1 << c;
+
+		  if (source_chan[c] != swizzle_chan[c])
+		     noop_swizzle = false;
+	       }
 	    }
 	 }
       }
+
+      if (b->killed_all)
+	 break;
+
+      kill_entry *k = b->find_kill(var);
+      if (k)
+	 killed_mask |= k->write_mask;
    }
 
    /* Make sure all channels are copying from the same source variable. */
@@ -317,45 +397,43 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_call *ir)
 	* they are side effect free.
     */
    if (!ir->callee->is_builtin()) {
-      acp->make_empty();
-      this->killed_all = true;
+      kill_all();
    }
 
    return visit_continue_with_parent;
 }
 
+/**
+ * Visits a nested block, then applies its kills to the enclosing block.
+ *
+ * If \p inherit_acp is set, the copies available in the enclosing block
+ * are visible inside the nested one; otherwise it starts out empty.
+ */
 void
-ir_copy_propagation_elements_visitor::handle_if_block(exec_list *instructions)
+ir_copy_propagation_elements_visitor::handle_block(exec_list *instructions,
+						   bool inherit_acp)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
+   acp_block *orig_block = this->block;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
-
-   /* Populate the initial acp with a copy of the original */
-   foreach_in_list(acp_entry, a, orig_acp) {
-      this->acp->push_tail(new(this->mem_ctx) acp_entry(a));
-   }
+   this->block = new(mem_ctx) acp_block(inherit_acp ? orig_block : NULL);
 
    visit_list_elements(this, instructions);
 
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
+   acp_block *new_block = this->block;
+   this->block = orig_block;
 
-   exec_list *new_kills = this->kills;
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = this->killed_all || orig_killed_all;
+   if (new_block->killed_all)
+      kill_all();
 
-   /* Move the new kills into the parent block's list, removing them
-    * from the parent's ACP list in the process.
+   /* Move the new kills into the parent block's set, removing them
+    * from the parent's ACP in the process.
     */
-   foreach_in_list_safe(kill_entry, k, new_kills) {
-      kill(k);
+   if (new_block->kills) {
+      struct hash_entry *e;
+      hash_table_foreach(new_block->kills, e) {
+	 kill_entry *k = (kill_entry *) e->data;
+	 kill(k->var, k->write_mask);
+      }
    }
 }
 
@@ -364,42 +442,21 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_if *ir)
 {
    ir->condition->accept(this);
 
-   handle_if_block(&ir->then_instructions);
-   handle_if_block(&ir->else_instructions);
+   handle_block(&ir->then_instructions, true);
+   handle_block(&ir->else_instructions, true);
 
-   /* handle_if_block() already descended into the children. */
+   /* handle_block() already descended into the children. */
    return visit_continue_with_parent;
 }
 
 ir_visitor_status
 ir_copy_propagation_elements_visitor::visit_enter(ir_loop *ir)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
-
    /* FINISHME: For now, the initial acp for loops is totally empty.
     * We could go through once, then go through again with the acp
     * cloned minus the killed entries after the first run through.
     */
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
-
-   visit_list_elements(this, &ir->body_instructions);
-
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
-
-   exec_list *new_kills = this->kills;
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = this->killed_all || orig_killed_all;
-
-   foreach_in_list_safe(kill_entry, k, new_kills) {
-      kill(k);
-   }
+   handle_block(&ir->body_instructions, false);
 
    /* already descended into the children. */
    return visit_continue_with_parent;
@@ -407,26 +464,72 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_loop *ir)
 
 /* Remove any entries currently in the ACP for this kill. */
 void
-ir_copy_propagation_elements_visitor::kill(kill_entry *k)
+ir_copy_propagation_elements_visitor::kill(ir_variable *var,
+					   unsigned write_mask)
 {
-   foreach_in_list_safe(acp_entry, entry, acp) {
-      if (entry->lhs == k->var) {
-	 entry->write_mask = entry->write_mask & ~k->write_mask;
-	 if (entry->write_mask == 0) {
-	    entry->remove();
-	    continue;
+   acp_block *b = this->block;
+   const uint32_t hash = _mesa_hash_pointer(var);
+
+   if (b->acp) {
+      struct hash_entry *e = _mesa_hash_table_search(b->acp, hash, var);
+      if (e) {
+	 foreach_in_list_safe(acp_entry, entry, (exec_list *) e->data) {
+	    entry->write_mask = entry->write_mask & ~write_mask;
+	    if (entry->write_mask == 0) {
+	       entry->remove();
+	       entry->rhs_link.remove();
+	    }
 	 }
       }
-      if (entry->rhs == k->var) {
-	 entry->remove();
+
+      e = _mesa_hash_table_search(b->rhs_uses, hash, var);
+      if (e) {
+	 foreach_list_typed_safe(acp_entry, entry, rhs_link,
+				 (exec_list *) e->data) {
+	    entry->remove();
+	    entry->rhs_link.remove();
+	 }
       }
    }
 
-   /* If we were on a list, remove ourselves before inserting */
-   if (k->next)
-      k->remove();
+   kill_entry *k = b->find_kill(var);
+   if (k) {
+      k->write_mask |= write_mask;
+   } else {
+      if (!b->kills)
+	 b->kills = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+      k = new(mem_ctx) kill_entry(var, write_mask);
+      _mesa_hash_table_insert(b->kills, hash, var, k);
+   }
+}
+
+/**
+ * Drops every copy available in the current block, including the ones
+ * inherited from enclosing blocks.
+ */
+void
+ir_copy_propagation_elements_visitor::kill_all()
+{
+   this->block->acp = NULL;
+   this->block->rhs_uses = NULL;
+   this->block->killed_all = true;
+}
 
-   this->kills->push_tail(k);
+/**
+ * Returns the exec_list stored for \p var in \p ht, adding an empty one
+ * if there is none yet.
+ */
+static exec_list *
+find_or_add_list(void *mem_ctx, struct hash_table *ht, ir_variable *var)
+{
+   const uint32_t hash = _mesa_hash_pointer(var);
+   struct hash_entry *e = _mesa_hash_table_search(ht, hash, var);
+   if (e)
+      return (exec_list *) e->data;
+
+   exec_list *list = new(mem_ctx) exec_list;
+   _mesa_hash_table_insert(ht, hash, var, list);
+   return list;
 }
 
 /**
@@ -489,9 +592,16 @@ ir_copy_propagation_elements_visitor::add_copy(ir_assignment *ir)
       }
    }
 
+   acp_block *b = this->block;
+   if (!b->acp) {
+      b->acp = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+      b->rhs_uses = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+   }
+
    entry = new(this->mem_ctx) acp_entry(lhs->var, rhs->var, write_mask,
 					swizzle);
-   this->acp->push_tail(entry);
+   find_or_add_list(mem_ctx, b->acp, lhs->var)->push_tail(entry);
+   find_or_add_list(mem_ctx, b->rhs_uses, rhs->var)->push_tail(&entry->rhs_link);
 }
 
 bool
@@ -30,6 +30,10 @@
  * is generic and handles texture operations, but it's rather simple currently
  * and doesn't support modification of variables in the available expressions
  * list, so it can't do variables other than uniforms or shader inputs.
+ *
+ * Available expressions are found through a structural hash, and are scoped
+ * by dominance within a function: what is computed before an if or loop can
+ * be reused inside it.
  */
 
 #include "ir.h"
@@ -39,6 +43,7 @@
 #include "ir_optimization.h"
 #include "ir_builder.h"
 #include "glsl_types.h"
+#include "util/hash_table.h"
 
 using namespace ir_builder;
 
@@ -53,14 +58,15 @@ namespace {
 class ae_entry : public exec_node
 {
 public:
-   ae_entry(ir_instruction *base_ir, ir_rvalue **val)
-      : val(val), base_ir(base_ir)
+   ae_entry(ir_instruction *base_ir, ir_rvalue **val, uint32_t hash)
+      : val(val), base_ir(base_ir), hash(hash)
    {
       assert(val);
       assert(*val);
       assert(base_ir);
 
       var = NULL;
+      next_same_hash = NULL;
    }
 
    /**
@@ -86,6 +92,12 @@ public:
     * once already.
     */
    ir_variable *var;
+
+   /** Structural hash of *val at the time it was added */
+   uint32_t hash;
+
+   /** Older entry with the same hash, see cse_visitor::ae_by_hash */
+   ae_entry *next_same_hash;
 };
 
 class cse_visitor : public ir_rvalue_visitor {
@@ -94,8 +106,11 @@ public:
       : validate_instructions(validate_instructions)
    {
       progress = false;
-      mem_ctx = ralloc_context(NULL);
+      mem_ctx = ralloc_arena_context(NULL);
       this->ae = new(mem_ctx) exec_list;
+      /* Created along with the first entry; most runs find nothing. */
+      this->ae_by_hash = NULL;
+      this->ae_by_rvalue = NULL;
    }
    ~cse_visitor()
    {
@@ -113,12 +128,33 @@ public:
 private:
    void *mem_ctx;
 
-   ir_rvalue *try_cse(ir_rvalue *rvalue);
-   void add_to_ae(ir_rvalue **rvalue);
+   ir_rvalue *try_cse(ir_rvalue *rvalue, uint32_t hash);
+   void add_to_ae(ir_rvalue **rvalue, uint32_t hash);
+   void pop_ae(ae_entry *mark);
+
+   ae_entry *newest_ae()
+   {
+      return ae->is_empty() ? NULL : (ae_entry *) ae->get_tail();
+   }
+
+   static bool ae_hash_equal(const void *, const void *)
+   {
+      /* Buckets are found by hash value alone. */
+      return true;
+   }
 
    /** List of ae_entry: The available expressions to reuse */
    exec_list *ae;
 
+   /**
+    * The same entries, bucketed by structural hash.  The data of each bucket
+    * is the newest entry with that hash; older ones follow next_same_hash.
+    */
+   struct hash_table *ae_by_hash;
+
+   /** Entries keyed by the expression node they track */
+   struct hash_table *ae_by_rvalue;
+
    /**
     * The whole shader, so that we can validate_ir_tree in debug mode.
     *
@@ -147,22 +183,24 @@ public:
 };
 
 
-class contains_rvalue_visitor : public ir_rvalue_visitor
+/**
+ * Visitor that points the available expressions found inside a tree that was
+ * just moved into a new assignment at that assignment.
+ */
+class ae_fixup_visitor : public ir_rvalue_visitor
 {
 public:
 
-   contains_rvalue_visitor(ir_rvalue *val)
-      : val(val)
+   ae_fixup_visitor(struct hash_table *ae_by_rvalue, ir_assignment *assignment)
+      : ae_by_rvalue(ae_by_rvalue), assignment(assignment)
    {
-      found = false;
    }
 
    virtual void handle_rvalue(ir_rvalue **rvalue);
 
-   bool found;
-
 private:
-   ir_rvalue *val;
+   struct hash_table *ae_by_rvalue;
+   ir_assignment *assignment;
 };
 
 } /* unnamed namespace */
@@ -200,18 +238,82 @@ is_cse_candidate_visitor::visit(ir_dereference_variable *ir)
 }
 
 void
-contains_rvalue_visitor::handle_rvalue(ir_rvalue **rvalue)
+ae_fixup_visitor::handle_rvalue(ir_rvalue **rvalue)
 {
-   if (*rvalue == val)
-      found = true;
+   if (!*rvalue)
+      return;
+
+   struct hash_entry *e = _mesa_hash_table_search(ae_by_rvalue,
+                                                  _mesa_hash_pointer(*rvalue),
+                                                  *rvalue);
+   if (e)
+      ((ae_entry *) e->data)->base_ir = assignment;
 }
 
-static bool
-contains_rvalue(ir_rvalue *haystack, ir_rvalue *needle)
+static inline uint32_t
+hash_combine(uint32_t hash, uint32_t value)
+{
+   return hash ^ (value + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+/**
+ * Structural hash of an rvalue tree, consistent with ir_instruction::equals:
+ * rvalues that compare equal hash the same.  Node types that equals() never
+ * considers equal just hash their address.
+ *
+ * Only the top few levels of the tree are hashed.  Every subtree gets hashed
+ * again as part of each enclosing candidate, so hashing whole trees would be
+ * quadratic in their depth; the rare collisions are sorted out by equals().
+ */
+static uint32_t
+hash_rvalue(ir_rvalue *ir, unsigned depth = 3)
 {
-   contains_rvalue_visitor v(needle);
-   haystack->accept(&v);
-   return v.found;
+   if (!ir)
+      return 0;
+   if (depth == 0)
+      return ir->ir_type;
+   depth--;
+
+   uint32_t hash = hash_combine(ir->ir_type, _mesa_hash_pointer(ir->type));
+
+   switch (ir->ir_type) {
+   case ir_type_expression: {
+      ir_expression *expr = (ir_expression *) ir;
+      hash = hash_combine(hash, expr->operation);
+      for (unsigned i = 0; i < expr->get_num_operands(); i++)
+         hash = hash_combine(hash, hash_rvalue(expr->operands[i], depth));
+      return hash;
+   }
+   case ir_type_texture: {
+      ir_texture *tex = (ir_texture *) ir;
+      hash = hash_combine(hash, tex->op);
+      hash = hash_combine(hash, hash_rvalue(tex->coordinate, depth));
+      /* Offsets and LOD parameters are left to equals(). */
+      return hash_combine(hash, hash_rvalue(tex->sampler, depth));
+   }
+   case ir_type_swizzle: {
+      ir_swizzle *swiz = (ir_swizzle *) ir;
+      hash = hash_combine(hash, swiz->mask.x | (swiz->mask.y << 2) |
+                                (swiz->mask.z << 4) | (swiz->mask.w << 6));
+      return hash_combine(hash, hash_rvalue(swiz->val, depth));
+   }
+   case ir_type_constant: {
+      ir_constant *c = (ir_constant *) ir;
+      return hash_combine(hash, _mesa_hash_data(c->value.u,
+                                                c->type->components() *
+                                                sizeof(c->value.u[0])));
+   }
+   case ir_type_dereference_variable:
+      return hash_combine(hash, _mesa_hash_pointer(
+                             ((ir_dereference_variable *) ir)->var));
+   case ir_type_dereference_array: {
+      ir_dereference_array *deref = (ir_dereference_array *) ir;
+      hash = hash_combine(hash, hash_rvalue(deref->array, depth));
+      return hash_combine(hash, hash_rvalue(deref->array_index, depth));
+   }
+   default:
+      return hash_combine(hash, _mesa_hash_pointer(ir));
+   }
 }
 
 static bool
@@ -246,22 +348,39 @@ is_cse_candidate(ir_rvalue *ir)
  * Tries to find and return a reference to a previous computation of a given
  * expression.
  *
- * Walk the list of available expressions checking if any of them match the
- * rvalue, and if so, move the previous copy of the expression to a temporary
- * and return a reference of the temporary.
+ * Look through the available expressions with the same hash for one that
+ * matches the rvalue, and if found, move the previous copy of the expression
+ * to a temporary and return a reference of the temporary.
+ *
+ * Trees of available expressions get rewritten when their subexpressions are
+ * CSEd, so their stored hash can go stale.  That does not matter: after such
+ * a rewrite they reference a temporary, and trees referencing temporaries
+ * are never CSE candidates, so they could not match anything anyway.
  */
 ir_rvalue *
-cse_visitor::try_cse(ir_rvalue *rvalue)
+cse_visitor::try_cse(ir_rvalue *rvalue, uint32_t hash)
 {
-   foreach_in_list(ae_entry, entry, ae) {
+   if (ae->is_empty())
+      return NULL;
+
+   struct hash_entry *bucket = _mesa_hash_table_search(ae_by_hash, hash, ae);
+   if (!bucket)
+      return NULL;
+
+   /* Use the oldest match, the chain is newest first. */
+   ae_entry *entry = NULL;
+   for (ae_entry *e = (ae_entry *) bucket->data; e; e = e->next_same_hash) {
       if (debug) {
-         printf("Comparing to AE %p: ", entry);
-         (*entry->val)->print();
+         printf("Comparing to AE %p: ", e);
+         (*e->val)->print();
          printf("\n");
       }
 
-      if (!rvalue->equals(*entry->val))
-         continue;
+      if (rvalue->equals(*e->val))
+         entry = e;
+   }
+
+   if (entry) {
 
       if (debug) {
          printf("CSE: Replacing: ");
@@ -300,10 +419,8 @@ cse_visitor::try_cse(ir_rvalue *rvalue)
           * updated so that any further elimination from inside gets its new
           * assignments put before our new assignment.
           */
-         foreach_in_list(ae_entry, fixup_entry, ae) {
-            if (contains_rvalue(assignment->rhs, *fixup_entry->val))
-               fixup_entry->base_ir = assignment;
-         }
+         ae_fixup_visitor fixup(ae_by_rvalue, assignment);
+         assignment->rhs->accept(&fixup);
 
          if (debug)
             dump_ae(ae);
@@ -318,7 +435,7 @@ cse_visitor::try_cse(ir_rvalue *rvalue)
 
 /** Add the rvalue to the list of available expressions for CSE. */
 void
-cse_visitor::add_to_ae(ir_rvalue **rvalue)
+cse_visitor::add_to_ae(ir_rvalue **rvalue, uint32_t hash)
 {
    if (debug) {
       printf("CSE: Add to AE: ");
@@ -326,7 +443,23 @@ cse_visitor::add_to_ae(ir_rvalue **rvalue)
       printf("\n");
    }
 
-   ae->push_tail(new(mem_ctx) ae_entry(base_ir, rvalue));
+   if (!ae_by_hash) {
+      ae_by_hash = _mesa_hash_table_create(mem_ctx, ae_hash_equal);
+      ae_by_rvalue = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+   }
+
+   ae_entry *entry = new(mem_ctx) ae_entry(base_ir, rvalue, hash);
+   ae->push_tail(entry);
+
+   struct hash_entry *bucket = _mesa_hash_table_search(ae_by_hash, hash, ae);
+   if (bucket) {
+      entry->next_same_hash = (ae_entry *) bucket->data;
+      bucket->data = entry;
+   } else {
+      _mesa_hash_table_insert(ae_by_hash, hash, entry, entry);
+   }
+   _mesa_hash_table_insert(ae_by_rvalue, _mesa_hash_pointer(*rvalue),
+                           *rvalue, entry);
 
    if (debug)
       dump_ae(ae);
@@ -347,7 +480,8 @@ cse_visitor::handle_rvalue(ir_rvalue **rvalue)
    if (!is_cse_candidate(*rvalue))
       return;
 
-   ir_rvalue *new_rvalue = try_cse(*rvalue);
+   const uint32_t hash = hash_rvalue(*rvalue);
+   ir_rvalue *new_rvalue = try_cse(*rvalue, hash);
    if (new_rvalue) {
       *rvalue = new_rvalue;
       progress = true;
@@ -355,7 +489,36 @@ cse_visitor::handle_rvalue(ir_rvalue **rvalue)
       if (debug)
          validate_ir_tree(validate_instructions);
    } else {
-      add_to_ae(rvalue);
+      add_to_ae(rvalue, hash);
+   }
+}
+
+/**
+ * Drops the available expressions that were added after \p mark (the newest
+ * entry at the time, or NULL to drop everything).
+ */
+void
+cse_visitor::pop_ae(ae_entry *mark)
+{
+   while (!ae->is_empty()) {
+      ae_entry *entry = (ae_entry *) ae->get_tail();
+      if (entry == mark)
+         break;
+      entry->remove();
+
+      struct hash_entry *bucket =
+         _mesa_hash_table_search(ae_by_hash, entry->hash, ae);
+      assert(bucket && bucket->data == entry);
+      if (entry->next_same_hash)
+         bucket->data = entry->next_same_hash;
+      else
+         _mesa_hash_table_remove(ae_by_hash, bucket);
+
+      struct hash_entry *e =
+         _mesa_hash_table_search(ae_by_rvalue, _mesa_hash_pointer(*entry->val),
+                                 *entry->val);
+      if (e)
+         _mesa_hash_table_remove(ae_by_rvalue, e);
    }
 }
 
@@ -364,33 +527,37 @@ cse_visitor::visit_enter(ir_if *ir)
 {
    handle_rvalue(&ir->condition);
 
-   ae->make_empty();
+   /* Expressions available before the if stay available in both branches
+    * and after it, since nothing a CSE candidate reads can be assigned.
+    * What gets added inside a branch is only available there.
+    */
+   ae_entry *mark = newest_ae();
    visit_list_elements(this, &ir->then_instructions);
 
-   ae->make_empty();
+   pop_ae(mark);
    visit_list_elements(this, &ir->else_instructions);
 
-   ae->make_empty();
+   pop_ae(mark);
    return visit_continue_with_parent;
 }
 
 ir_visitor_status
 cse_visitor::visit_enter(ir_function_signature *ir)
 {
-   ae->make_empty();
+   pop_ae(NULL);
    visit_list_elements(this, &ir->body);
 
-   ae->make_empty();
+   pop_ae(NULL);
    return visit_continue_with_parent;
 }
 
 ir_visitor_status
 cse_visitor::visit_enter(ir_loop *ir)
 {
-   ae->make_empty();
+   ae_entry *mark = newest_ae();
    visit_list_elements(this, &ir->body_instructions);
 
-   ae->make_empty();
+   pop_ae(mark);
    return visit_continue_with_parent;
 }
 
@@ -35,23 +35,52 @@
 
 static bool debug = false;
 
+namespace {
+
+class removed_instruction : public exec_node
+{
+public:
+   removed_instruction(ir_instruction *ir)
+   {
+      this->ir = ir;
+   }
+
+   ir_instruction *ir;
+};
+
+} /* unnamed namespace */
+
 /**
  * Do a dead code pass over instructions and everything that instructions
  * references.
  *
  * Note that this will remove assignments to globals, so it is not suitable
  * for usage on an unlinked instruction stream.
+ *
+ * If \c refs is given, it must hold the current counts of \c instructions;
+ * it is used instead of counting them again, and is updated for whatever
+ * this removes.
  */
 bool
-do_dead_code(exec_list *instructions, bool uniform_locations_assigned)
+do_dead_code(exec_list *instructions, bool uniform_locations_assigned,
+	     ir_variable_refcount_visitor *refs)
 {
-   ir_variable_refcount_visitor v;
+   ir_variable_refcount_visitor *local_refs = NULL;
    bool progress = false;
 
-   v.run(instructions);
+   if (!refs) {
+      refs = local_refs = new ir_variable_refcount_visitor;
+      refs->run(instructions);
+   }
+
+   /* Removals are only applied to the counts once every variable has been
+    * looked at, so that all decisions are made on the counts we started
+    * with.
+    */
+   exec_list removed;
 
    struct hash_entry *e;
-   hash_table_foreach(v.ht, e) {
+   hash_table_foreach(refs->ht, e) {
       ir_variable_refcount_entry *entry = (ir_variable_refcount_entry *)e->data;
 
       /* Since each assignment is a reference, the refereneced count must be
@@ -83,6 +112,7 @@ do_dead_code(exec_list *instructions, bool uniform_locations_assigned)
 	     entry->var->data.mode != ir_var_function_inout &&
              entry->var->data.mode != ir_var_shader_out && entry->var->data.mode != ir_var_shader_inout) {
 	    entry->assign->remove();
+	    removed.push_tail(new(refs->mem_ctx) removed_instruction(entry->assign));
 	    progress = true;
 
 	    if (debug) {
@@ -126,6 +156,7 @@ do_dead_code(exec_list *instructions, bool uniform_locations_assigned)
          }
 
 	 entry->var->remove();
+	 removed.push_tail(new(refs->mem_ctx) removed_instruction(entry->var));
 	 progress = true;
 
 	 if (debug) {
@@ -135,6 +166,11 @@ do_dead_code(exec_list *instructions, bool uniform_locations_assigned)
       }
    }
 
+   foreach_in_list(removed_instruction, r, &removed) {
+      refs->update(r->ir, -1);
+   }
+
+   delete local_refs;
    return progress;
 }
 
@@ -159,7 +195,7 @@ do_dead_code_unlinked(exec_list *instructions)
 	     * inside the body of the function, something has already gone
 	     * terribly, terribly wrong.
 	     */
-	    if (do_dead_code(&sig->body, false))
+	    if (do_dead_code(&sig->body, false, NULL))
 	       progress = true;
 	 }
       }
@@ -292,7 +292,7 @@ dead_code_local_basic_block(ir_instruction *first,
    bool *out_progress = (bool *)data;
    bool progress = false;
 
-   void *ctx = ralloc_context(NULL);
+   void *ctx = ralloc_arena_context(NULL);
    /* Safe looping, since process_assignment */
    for (ir = first, ir_next = (ir_instruction *)first->next;;
 	ir = ir_next, ir_next = (ir_instruction *)ir->next) {
@@ -313,7 +313,8 @@ dead_code_local_basic_block(ir_instruction *first,
       if (ir == last)
 	 break;
    }
-   *out_progress = progress;
+   if (progress)
+      *out_progress = true;
    ralloc_free(ctx);
 }
 
@@ -0,0 +1,134 @@
+/**
+ * \file opt_dead_stores.cpp
+ *
+ * Global dead store elimination.
+ *
+ * Removes assignments, and channels of assignments, whose value is not live
+ * right after them according to \c ir_liveness: on every path it gets
+ * overwritten, or the function ends, before anything reads it.  Unlike
+ * do_dead_code_local this sees across ifs and loops, and unlike do_dead_code
+ * it looks at each store and channel rather than at whole variables.
+ */
+
+#include "ir.h"
+#include "ir_liveness.h"
+#include "ir_optimization.h"
+#include "glsl_types.h"
+
+namespace {
+
+class dead_store_remover {
+public:
+   dead_store_remover(ir_liveness *liveness)
+      : liveness(liveness), progress(false)
+   {
+   }
+
+   void run(exec_list *list);
+   void process_assignment(ir_assignment *ir);
+
+   ir_liveness *liveness;
+   bool progress;
+};
+
+} /* anonymous namespace */
+
+
+void
+dead_store_remover::process_assignment(ir_assignment *ir)
+{
+   ir_variable *var = ir->lhs->variable_referenced();
+   int index = var ? liveness->get_index(var) : -1;
+   ir_liveness_point *point = liveness->get_point(ir);
+   if (index < 0 || point == NULL)
+      return;
+
+   const unsigned live = point->live[index];
+   const bool per_channel = ir->lhs->as_dereference_variable() != NULL &&
+      (var->type->is_scalar() || var->type->is_vector());
+
+   if (!per_channel) {
+      if (live == 0) {
+         ir->remove();
+         this->progress = true;
+      }
+      return;
+   }
+
+   const unsigned remove = ir->write_mask & ~live;
+   if (remove == 0)
+      return;
+   if (remove == ir->write_mask) {
+      ir->remove();
+      this->progress = true;
+      return;
+   }
+
+   /* A write of the whole variable stays one: tree grafting and copy
+    * propagation only handle those, and a vector write costs the same as
+    * one of fewer channels on most hardware.
+    */
+   if (ir->whole_variable_written() != NULL)
+      return;
+
+   /* Reswizzle the RHS for the channels that stay, the way
+    * do_dead_code_local does.
+    */
+   unsigned components[4];
+   unsigned channels = 0;
+   unsigned next = 0;
+   for (int i = 0; i < 4; i++) {
+      if (ir->write_mask & (1 << i)) {
+         if (!(remove & (1 << i)))
+            components[channels++] = next;
+         next++;
+      }
+   }
+
+   void *mem_ctx = ralloc_parent(ir);
+   ir->write_mask &= ~remove;
+   ir->rhs = new(mem_ctx) ir_swizzle(ir->rhs, components, channels);
+   this->progress = true;
+}
+
+
+void
+dead_store_remover::run(exec_list *list)
+{
+   foreach_in_list_safe(ir_instruction, ir, list) {
+      switch (ir->ir_type) {
+      case ir_type_assignment:
+         process_assignment((ir_assignment *) ir);
+         break;
+      case ir_type_if:
+         run(&((ir_if *) ir)->then_instructions);
+         run(&((ir_if *) ir)->else_instructions);
+         break;
+      case ir_type_loop:
+         run(&((ir_loop *) ir)->body_instructions);
+         break;
+      case ir_type_function:
+         foreach_in_list(ir_function_signature, sig,
+                         &((ir_function *) ir)->signatures)
+            run(&sig->body);
+         break;
+      default:
+         break;
+      }
+   }
+}
+
+
+/**
+ * Removes stores, and channels of stores, that no path reads.
+ */
+bool
+do_dead_stores(exec_list *instructions)
+{
+   ir_liveness liveness(true);
+   liveness.run(instructions);
+
+   dead_store_remover v(&liveness);
+   v.run(instructions);
+   return v.progress;
+}
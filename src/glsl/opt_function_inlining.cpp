@@ -31,8 +31,12 @@
 #include "ir_visitor.h"
 #include "ir_function_inlining.h"
 #include "ir_expression_flattening.h"
+#include "ir_optimization.h"
+#include "ir_stats.h"
 #include "glsl_types.h"
 #include "program/hash_table.h"
+#include "util/hash_table.h"
+#include "main/mtypes.h"
 
 static void
 do_variable_replacement(exec_list *instructions,
@@ -41,12 +45,58 @@ do_variable_replacement(exec_list *instructions,
 
 namespace {
 
+/* What inlining every call to a function would cost. */
+struct inline_callee {
+   int size;
+   /* Instructions inlining all calls adds, less the function body */
+   int growth;
+};
+
+/**
+ * Cost model deciding which calls get inlined.
+ *
+ * Inlining a call grows the code by the size of the callee, less the
+ * parameter copies and call it replaces; constant arguments make it smaller
+ * still, by InlineConstantArgBonus percent of the callee each, as the
+ * constant folding passes get to work on the inlined copy.  Once all calls
+ * are inlined the function itself is gone.
+ *
+ * A call is inlined if the callee is at most MaxInlineSize after that
+ * discount, or if inlining all calls to it adds at most MaxInlineGrowth
+ * instructions; otherwise the call, and the function, stay.
+ */
+class inline_cost_model : public ir_hierarchical_visitor {
+public:
+   inline_cost_model(const struct gl_shader_compiler_options *options)
+      : options(options)
+   {
+      mem_ctx = ralloc_context(NULL);
+      callees = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+   }
+
+   ~inline_cost_model()
+   {
+      ralloc_free(mem_ctx);
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *);
+
+   inline_callee *get_callee(ir_function_signature *sig);
+   int call_size(ir_call *call, const inline_callee *callee);
+   bool should_inline(ir_call *call);
+
+   const struct gl_shader_compiler_options *options;
+   void *mem_ctx;
+   struct hash_table *callees;
+};
+
 class ir_function_inlining_visitor : public ir_hierarchical_visitor {
 public:
-   ir_function_inlining_visitor()
+   ir_function_inlining_visitor(inline_cost_model *cost)
    {
       progress = false;
 	  current_function = NULL;
+      this->cost = cost;
    }
 
    virtual ~ir_function_inlining_visitor()
@@ -72,19 +122,103 @@ public:
    }
 
    ir_function_signature* current_function;
+   inline_cost_model *cost;
    bool progress;
 
 };
 
 } /* unnamed namespace */
 
+
+inline_callee *
+inline_cost_model::get_callee(ir_function_signature *sig)
+{
+   hash_entry *entry =
+      _mesa_hash_table_search(callees, _mesa_hash_pointer(sig), sig);
+   if (entry != NULL)
+      return (inline_callee *) entry->data;
+
+   ir_stats_counter_visitor stats;
+   stats.run(&sig->body);
+
+   inline_callee *callee = ralloc(mem_ctx, inline_callee);
+   callee->size = stats.math + stats.tex + stats.flow;
+   callee->growth = -callee->size;
+   _mesa_hash_table_insert(callees, _mesa_hash_pointer(sig), sig, callee);
+   return callee;
+}
+
+
+int
+inline_cost_model::call_size(ir_call *call, const inline_callee *callee)
+{
+   int constant_args = 0;
+   foreach_two_lists(formal_node, &call->callee->parameters,
+                     actual_node, &call->actual_parameters) {
+      ir_variable *sig_param = (ir_variable *) formal_node;
+      ir_rvalue *param = (ir_rvalue *) actual_node;
+
+      if ((sig_param->data.mode == ir_var_function_in ||
+           sig_param->data.mode == ir_var_const_in) &&
+          param->as_constant() != NULL)
+         constant_args++;
+   }
+
+   const int percent =
+      MAX2(100 - constant_args * (int) options->InlineConstantArgBonus, 0);
+   return callee->size * percent / 100;
+}
+
+
+ir_visitor_status
+inline_cost_model::visit_enter(ir_call *ir)
+{
+   if (!can_inline(ir))
+      return visit_continue;
+
+   inline_callee *callee = get_callee(ir->callee);
+   /* Copying the parameters in and out, and the call itself */
+   const int call_cost = 1 + ir->actual_parameters.length();
+   callee->growth += call_size(ir, callee) - call_cost;
+   return visit_continue;
+}
+
+
+bool
+inline_cost_model::should_inline(ir_call *call)
+{
+   /* Built-in functions have no GLSL to print them as. */
+   if (call->callee->is_builtin())
+      return true;
+
+   const inline_callee *callee = get_callee(call->callee);
+   return call_size(call, callee) <= (int) options->MaxInlineSize ||
+          callee->growth <= (int) options->MaxInlineGrowth;
+}
+
+
+/**
+ * Inlines calls to functions.
+ *
+ * Without \c options, or with a MaxInlineGrowth of ~0 (no limit), every call
+ * that can be inlined is; otherwise the ones the cost model picks.  A
+ * MaxInlineGrowth of 0 still inlines calls that don't grow the shader.
+ */
 bool
-do_function_inlining(exec_list *instructions)
+do_function_inlining(exec_list *instructions,
+                     const struct gl_shader_compiler_options *options)
 {
-   ir_function_inlining_visitor v;
+   inline_cost_model *cost = NULL;
+   if (options != NULL && options->MaxInlineGrowth != ~0u) {
+      cost = new inline_cost_model(options);
+      cost->run(instructions);
+   }
+
+   ir_function_inlining_visitor v(cost);
 
    v.run(instructions);
 
+   delete cost;
    return v.progress;
 }
 
@@ -266,7 +400,7 @@ ir_function_inlining_visitor::visit_enter(ir_swizzle *ir)
 ir_visitor_status
 ir_function_inlining_visitor::visit_enter(ir_call *ir)
 {
-   if (can_inline(ir)) {
+   if (can_inline(ir) && (cost == NULL || cost->should_inline(ir))) {
       ir->generate_inline(ir);
       ir->remove();
       this->progress = true;
@@ -0,0 +1,329 @@
+/**
+ * \file opt_if_pre.cpp
+ *
+ * Partial redundancy elimination across the branches of ifs.
+ *
+ * An expression or texture fetch that both the then and the else branch
+ * compute, from values neither branch changed before computing it, is
+ * computed once into a temporary in front of the if instead.  Every path
+ * through the if evaluated it already, so nothing is evaluated more often;
+ * when both sides of an if run (divergent branches on a GPU), it's
+ * evaluated half as often.
+ *
+ * Each branch is only looked at up to its first call or jump, nested ones
+ * included: calls can change values the pass cannot see, and past a jump the
+ * branch no longer computes the expression on every path through it.
+ */
+
+#include "ir.h"
+#include "ir_hierarchical_visitor.h"
+#include "ir_optimization.h"
+#include "ir_builder.h"
+#include "glsl_types.h"
+#include "util/hash_table.h"
+
+using namespace ir_builder;
+
+namespace {
+
+/* One expression or texture fetch in a branch. */
+struct pre_slot {
+   ir_rvalue **rvalue;
+   /* Index of the first slot after the ones nested in this one */
+   unsigned end;
+   /* Computable in front of the if */
+   bool anticipated;
+   bool done;
+};
+
+/* The slots of one branch, in prefix order. */
+class pre_branch {
+public:
+   pre_branch(void *mem_ctx)
+      : mem_ctx(mem_ctx), slots(NULL), count(0), size(0)
+   {
+      killed = _mesa_hash_table_create(mem_ctx, _mesa_key_pointer_equal);
+   }
+
+   void collect(exec_list *instructions);
+   void collect_rvalue(ir_rvalue **rvalue);
+   bool is_anticipated(ir_rvalue *ir);
+
+   void *mem_ctx;
+   pre_slot *slots;
+   unsigned count, size;
+   /* Variables the branch assigned so far */
+   struct hash_table *killed;
+};
+
+
+/* Adds the variables assigned by statements to a branch's killed set, and
+ * finds calls and jumps.
+ */
+class pre_kill_visitor : public ir_hierarchical_visitor {
+public:
+   pre_kill_visitor(struct hash_table *killed)
+      : killed(killed), opaque(false)
+   {
+   }
+
+   void kill(ir_variable *var)
+   {
+      if (var != NULL)
+         _mesa_hash_table_insert(killed, _mesa_hash_pointer(var), var, var);
+   }
+
+   virtual ir_visitor_status visit_leave(ir_assignment *ir)
+   {
+      kill(ir->lhs->variable_referenced());
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *)
+   {
+      opaque = true;
+      return visit_stop;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_return *)
+   {
+      opaque = true;
+      return visit_stop;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_discard *)
+   {
+      opaque = true;
+      return visit_stop;
+   }
+
+   virtual ir_visitor_status visit(ir_loop_jump *)
+   {
+      opaque = true;
+      return visit_stop;
+   }
+
+   struct hash_table *killed;
+   /* Found a call, which can change anything, or a jump */
+   bool opaque;
+};
+
+
+/* Checks that an rvalue reads variables, and none that were killed. */
+class pre_anticipated_visitor : public ir_hierarchical_visitor {
+public:
+   pre_anticipated_visitor(struct hash_table *killed)
+      : killed(killed), reads_variables(false), killed_read(false)
+   {
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      reads_variables = true;
+      if (_mesa_hash_table_search(killed, _mesa_hash_pointer(ir->var),
+                                  ir->var)) {
+         /* visit_stop does not make it out of every ir_expression::accept,
+          * so remember it here.
+          */
+         killed_read = true;
+         return visit_stop;
+      }
+      return visit_continue;
+   }
+
+   struct hash_table *killed;
+   bool reads_variables;
+   bool killed_read;
+};
+
+} /* anonymous namespace */
+
+
+bool
+pre_branch::is_anticipated(ir_rvalue *ir)
+{
+   pre_anticipated_visitor v(killed);
+   ir->accept(&v);
+   return v.reads_variables && !v.killed_read;
+}
+
+
+void
+pre_branch::collect_rvalue(ir_rvalue **rvalue)
+{
+   ir_rvalue *ir = *rvalue;
+   if (ir == NULL)
+      return;
+
+   unsigned slot = count;
+   bool is_slot = ir->ir_type == ir_type_expression ||
+                  ir->ir_type == ir_type_texture;
+   if (is_slot) {
+      if (count == size) {
+         size = size ? size * 2 : 16;
+         slots = reralloc(mem_ctx, slots, pre_slot, size);
+      }
+      slots[slot].rvalue = rvalue;
+      slots[slot].anticipated = is_anticipated(ir);
+      slots[slot].done = false;
+      count++;
+   }
+
+   switch (ir->ir_type) {
+   case ir_type_expression: {
+      ir_expression *expr = (ir_expression *) ir;
+      for (unsigned i = 0; i < expr->get_num_operands(); i++)
+         collect_rvalue(&expr->operands[i]);
+      break;
+   }
+   case ir_type_texture: {
+      ir_texture *tex = (ir_texture *) ir;
+      collect_rvalue(&tex->coordinate);
+      collect_rvalue(&tex->offset);
+      switch (tex->op) {
+      case ir_txb:
+         collect_rvalue(&tex->lod_info.bias);
+         break;
+      case ir_txf:
+      case ir_txl:
+      case ir_txs:
+         collect_rvalue(&tex->lod_info.lod);
+         break;
+      case ir_txf_ms:
+         collect_rvalue(&tex->lod_info.sample_index);
+         break;
+      case ir_txd:
+         collect_rvalue(&tex->lod_info.grad.dPdx);
+         collect_rvalue(&tex->lod_info.grad.dPdy);
+         break;
+      case ir_tg4:
+         collect_rvalue(&tex->lod_info.component);
+         break;
+      default:
+         break;
+      }
+      break;
+   }
+   case ir_type_swizzle:
+      collect_rvalue(&((ir_swizzle *) ir)->val);
+      break;
+   case ir_type_dereference_array:
+      collect_rvalue(&((ir_dereference_array *) ir)->array);
+      collect_rvalue(&((ir_dereference_array *) ir)->array_index);
+      break;
+   case ir_type_dereference_record:
+      collect_rvalue(&((ir_dereference_record *) ir)->record);
+      break;
+   default:
+      break;
+   }
+
+   if (is_slot)
+      slots[slot].end = count;
+}
+
+
+void
+pre_branch::collect(exec_list *instructions)
+{
+   foreach_in_list(ir_instruction, ir, instructions) {
+      /* Nothing using variables declared in the branch can move out. */
+      ir_variable *var = ir->as_variable();
+      if (var != NULL) {
+         _mesa_hash_table_insert(killed, _mesa_hash_pointer(var), var, var);
+         continue;
+      }
+
+      ir_assignment *assign = ir->as_assignment();
+      if (assign != NULL) {
+         collect_rvalue(&assign->rhs);
+         collect_rvalue(&assign->condition);
+      } else if (ir->ir_type != ir_type_if && ir->ir_type != ir_type_loop) {
+         return;
+      }
+
+      pre_kill_visitor v(killed);
+      ir->accept(&v);
+      if (v.opaque)
+         return;
+   }
+}
+
+
+namespace {
+
+class if_pre_visitor : public ir_hierarchical_visitor {
+public:
+   if_pre_visitor()
+      : progress(false)
+   {
+   }
+
+   virtual ir_visitor_status visit_leave(ir_if *ir);
+
+   bool progress;
+};
+
+} /* anonymous namespace */
+
+
+ir_visitor_status
+if_pre_visitor::visit_leave(ir_if *ir)
+{
+   if (ir->then_instructions.is_empty() || ir->else_instructions.is_empty())
+      return visit_continue;
+
+   void *mem_ctx = ralloc_context(NULL);
+   pre_branch then_branch(mem_ctx), else_branch(mem_ctx);
+   then_branch.collect(&ir->then_instructions);
+   else_branch.collect(&ir->else_instructions);
+
+   for (unsigned i = 0; i < then_branch.count; i++) {
+      pre_slot *a = &then_branch.slots[i];
+      if (!a->anticipated)
+         continue;
+      ir_rvalue *value = *a->rvalue;
+
+      for (unsigned j = 0; j < else_branch.count; j++) {
+         pre_slot *b = &else_branch.slots[j];
+         if (!b->anticipated || b->done)
+            continue;
+         ir_rvalue *other = *b->rvalue;
+         if (other->type != value->type ||
+             other->get_precision() != value->get_precision() ||
+             !value->equals(other))
+            continue;
+
+         ir_variable *var = new(ir) ir_variable(value->type, "pre",
+                                                ir_var_temporary,
+                                                value->get_precision());
+         ir->insert_before(var);
+         ir->insert_before(assign(var, value));
+         *a->rvalue = new(ir) ir_dereference_variable(var);
+         *b->rvalue = new(ir) ir_dereference_variable(var);
+
+         /* What was nested in them is gone now. */
+         for (unsigned k = j; k < b->end; k++)
+            else_branch.slots[k].done = true;
+         i = a->end - 1;
+         this->progress = true;
+         break;
+      }
+   }
+
+   ralloc_free(mem_ctx);
+   return visit_continue;
+}
+
+
+/**
+ * Computes expressions found in both branches of an if in front of it.
+ */
+bool
+do_if_pre(exec_list *instructions)
+{
+   if_pre_visitor v;
+
+   v.run(instructions);
+   return v.progress;
+}
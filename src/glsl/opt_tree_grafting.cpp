@@ -47,10 +47,12 @@
  * move those expressions safely.
  */
 
+#include <string.h>
 #include "ir.h"
 #include "ir_visitor.h"
 #include "ir_variable_refcount.h"
 #include "ir_basic_block.h"
+#include "ir_liveness.h"
 #include "ir_optimization.h"
 #include "glsl_types.h"
 
@@ -61,11 +63,14 @@ static bool debug = false;
 class ir_tree_grafting_visitor : public ir_hierarchical_visitor {
 public:
    ir_tree_grafting_visitor(ir_assignment *graft_assign,
-			    ir_variable *graft_var)
+			    ir_variable *graft_var,
+			    ir_variable_refcount_visitor *refs)
    {
       this->progress = false;
       this->graft_assign = graft_assign;
       this->graft_var = graft_var;
+      this->refs = refs;
+      this->current_lhs = NULL;
    }
 
    virtual ir_visitor_status visit_leave(class ir_assignment *);
@@ -86,6 +91,10 @@ public:
    bool progress;
    ir_variable *graft_var;
    ir_assignment *graft_assign;
+   ir_variable_refcount_visitor *refs;
+
+   /** LHS variable of the assignment being visited, if any. */
+   ir_variable *current_lhs;
 };
 
 struct find_deref_info {
@@ -144,6 +153,14 @@ ir_tree_grafting_visitor::do_graft(ir_rvalue **rvalue)
    this->graft_assign->remove();
    *rvalue = this->graft_assign->rhs;
 
+   /* The assignment is gone, and its RHS now sits where the variable was
+    * read.
+    */
+   this->refs->update(this->graft_assign, -1);
+   this->refs->update(deref, -1, this->current_lhs, this->in_assignee);
+   this->refs->update(this->graft_assign->rhs, 1, this->current_lhs,
+		      this->in_assignee);
+
    this->progress = true;
    return true;
 }
@@ -186,6 +203,7 @@ ir_tree_grafting_visitor::visit_enter(ir_assignment *ir)
 	// if we're entering into assignment of different precision, leave now
 	if (ir->lhs->get_precision() != this->graft_var->data.precision && ir->lhs->get_precision() != glsl_precision_undefined && this->graft_var->data.precision != glsl_precision_undefined)
 		return visit_continue_with_parent;
+	this->current_lhs = ir->lhs->variable_referenced();
 	return visit_continue;
 }
 
@@ -196,6 +214,8 @@ ir_tree_grafting_visitor::visit_leave(ir_assignment *ir)
        do_graft(&ir->condition))
       return visit_stop;
 
+   this->current_lhs = NULL;
+
    /* If this assignment updates a variable used in the assignment
     * we're trying to graft, then we're done.
     */
@@ -316,17 +336,128 @@ ir_tree_grafting_visitor::visit_enter(ir_texture *ir)
    return visit_continue;
 }
 
+/** A single use variable the pass may graft, see \c graft_variable. */
+struct graft_candidate {
+   ir_assignment *assign;
+   int index;
+   /** Components of other variables its RHS reads */
+   unsigned char *reads;
+};
+
 struct tree_grafting_info {
    ir_variable_refcount_visitor *refs;
+   ir_liveness *liveness;
    bool progress;
+
+   /* Candidates of the current basic block, when limiting pressure */
+   graft_candidate *candidates;
+   unsigned num_candidates;
 };
 
+/**
+ * Finds the statement in the basic block using the value \c assign writes
+ * to \c var.  Returns \c NULL if there is none.
+ */
+static ir_instruction *
+find_graft_use(ir_assignment *assign, ir_variable *var,
+               ir_instruction *bb_last)
+{
+   for (ir_instruction *ir = (ir_instruction *)assign->next;
+        ir != bb_last->next;
+        ir = (ir_instruction *)ir->next) {
+      if (dereferences_variable(ir, var))
+         return ir;
+   }
+   return NULL;
+}
+
+/**
+ * Checks that grafting candidate \c c into \c use does not push register
+ * pressure over the peak of the function.
+ *
+ * While the value of the candidate is live, the variables its RHS reads
+ * become live in its place; where those were not live already, pressure
+ * goes up.  Unless another candidate live at the same point reads them too:
+ * grafting that one would make them live there anyway, and a series of
+ * grafts that only pays off once all of them are done is common (several
+ * products of one vector, summed up later).
+ */
+static bool
+graft_keeps_pressure(const tree_grafting_info *info, const graft_candidate *c,
+                     ir_instruction *use)
+{
+   ir_liveness *liveness = info->liveness;
+
+   for (ir_instruction *ir = c->assign; ir != use;
+        ir = (ir_instruction *)ir->next) {
+      ir_liveness_point *point = liveness->get_point(ir);
+      if (point == NULL)
+         continue;
+
+      unsigned components = point->components;
+      for (unsigned i = 0; i < liveness->num_variables(); i++) {
+         const unsigned live = point->live[i];
+         if ((int) i == c->index) {
+            components -= liveness->mask_components(i, live);
+            continue;
+         }
+
+         unsigned added = c->reads[i] & ~live;
+         for (unsigned j = 0; added && j < info->num_candidates; j++) {
+            const graft_candidate *other = &info->candidates[j];
+            if (other != c && other->index >= 0 && point->live[other->index])
+               added &= ~other->reads[i];
+         }
+         if (added)
+            components += liveness->mask_components(i, live | added) -
+                          liveness->mask_components(i, live);
+      }
+      if (components > *point->function_peak)
+         return false;
+   }
+   return true;
+}
+
+/**
+ * Updates the recorded liveness from \c first up to \c use after the value
+ * of candidate \c c got grafted into \c use.
+ */
+static void
+graft_update_liveness(tree_grafting_info *info, const graft_candidate *c,
+                      ir_instruction *first, ir_instruction *use)
+{
+   ir_liveness *liveness = info->liveness;
+
+   for (ir_instruction *ir = first; ir != use;
+        ir = (ir_instruction *)ir->next) {
+      ir_liveness_point *point = liveness->get_point(ir);
+      if (point == NULL)
+         continue;
+
+      for (unsigned i = 0; i < liveness->num_variables(); i++)
+         point->live[i] |= c->reads[i];
+      if (c->index >= 0)
+         point->live[c->index] = 0;
+      point->components = liveness->count_components(point->live);
+   }
+
+   /* The RHS it went into reads different variables now. */
+   for (unsigned j = 0; j < info->num_candidates; j++) {
+      graft_candidate *other = &info->candidates[j];
+      if (other->assign == use) {
+         memset(other->reads, 0, liveness->num_variables());
+         liveness->add_uses(other->assign->rhs, other->reads);
+      }
+   }
+}
+
 static bool
 try_tree_grafting(ir_assignment *start,
 		  ir_variable *lhs_var,
-		  ir_instruction *bb_last)
+		  ir_instruction *bb_last,
+		  ir_variable_refcount_visitor *refs)
 {
-   ir_tree_grafting_visitor v(start, lhs_var);
+   ir_tree_grafting_visitor v(start, lhs_var, refs);
 
    if (debug) {
       fprintf(stderr, "trying to graft: ");
@@ -352,6 +483,43 @@ try_tree_grafting(ir_assignment *start,
    return false;
 }
 
+/**
+ * Returns the variable \c ir assigns if it is one the pass may graft into
+ * its only use, \c NULL otherwise.
+ */
+static ir_variable *
+graft_variable(ir_instruction *ir, ir_variable_refcount_visitor *refs)
+{
+   ir_assignment *assign = ir->as_assignment();
+
+   if (!assign)
+      return NULL;
+
+   ir_variable *lhs_var = assign->whole_variable_written();
+   if (!lhs_var)
+      return NULL;
+
+   if (lhs_var->data.mode == ir_var_function_out ||
+       lhs_var->data.mode == ir_var_function_inout ||
+       lhs_var->data.mode == ir_var_shader_out)
+      return NULL;
+
+   ir_variable_refcount_entry *entry = refs->get_variable_entry(lhs_var);
+
+   if (!entry->declaration ||
+       entry->assigned_count != 1 ||
+       entry->referenced_count != 2)
+      return NULL;
+
+	  glsl_precision var_prec = (glsl_precision)lhs_var->data.precision;
+	  glsl_precision rhs_prec = assign->rhs->get_precision();
+	  if (var_prec != rhs_prec && var_prec != glsl_precision_undefined && rhs_prec != glsl_precision_undefined)
+		  return NULL;
+
+   assert(assign == entry->assign);
+   return lhs_var;
+}
+
 static void
 tree_grafting_basic_block(ir_instruction *bb_first,
 			  ir_instruction *bb_last,
@@ -359,63 +527,106 @@ tree_grafting_basic_block(ir_instruction *bb_first,
 {
    struct tree_grafting_info *info = (struct tree_grafting_info *)data;
    ir_instruction *ir, *next;
+   void *mem_ctx = NULL;
+
+   info->candidates = NULL;
+   info->num_candidates = 0;
+   if (info->liveness) {
+      mem_ctx = ralloc_context(NULL);
+      unsigned count = 0;
+      for (ir = bb_first; ir != bb_last->next; ir = (ir_instruction *)ir->next)
+	 count += graft_variable(ir, info->refs) != NULL;
+      info->candidates = ralloc_array(mem_ctx, graft_candidate, count);
+      for (ir = bb_first; ir != bb_last->next; ir = (ir_instruction *)ir->next) {
+	 ir_variable *var = graft_variable(ir, info->refs);
+	 if (!var)
+	    continue;
+	 graft_candidate *c = &info->candidates[info->num_candidates++];
+	 c->assign = ir->as_assignment();
+	 c->index = info->liveness->get_index(var);
+	 c->reads = rzalloc_array(mem_ctx, unsigned char,
+				  info->liveness->num_variables() + 1);
+	 info->liveness->add_uses(c->assign->rhs, c->reads);
+      }
+   }
 
+   unsigned candidate = 0;
    for (ir = bb_first, next = (ir_instruction *)ir->next;
 	ir != bb_last->next;
 	ir = next, next = (ir_instruction *)ir->next) {
-      ir_assignment *assign = ir->as_assignment();
-
-      if (!assign)
-	 continue;
-
-      ir_variable *lhs_var = assign->whole_variable_written();
+      ir_variable *lhs_var = graft_variable(ir, info->refs);
       if (!lhs_var)
 	 continue;
 
-      if (lhs_var->data.mode == ir_var_function_out ||
-	  lhs_var->data.mode == ir_var_function_inout ||
-          lhs_var->data.mode == ir_var_shader_out)
-	 continue;
-
-      ir_variable_refcount_entry *entry = info->refs->get_variable_entry(lhs_var);
-
-      if (!entry->declaration ||
-	  entry->assigned_count != 1 ||
-	  entry->referenced_count != 2)
-	 continue;
-
-	  glsl_precision var_prec = (glsl_precision)lhs_var->data.precision;
-	  glsl_precision rhs_prec = assign->rhs->get_precision();
-	  if (var_prec != rhs_prec && var_prec != glsl_precision_undefined && rhs_prec != glsl_precision_undefined)
-		  continue;
+      ir_assignment *assign = ir->as_assignment();
 
-      assert(assign == entry->assign);
+      /* Leave the value in its variable if computing it at the use would
+       * keep more live than the function needs anywhere else.
+       */
+      graft_candidate *c = NULL;
+      ir_instruction *use = NULL;
+      if (info->liveness) {
+	 unsigned k = candidate;
+	 while (k < info->num_candidates && info->candidates[k].assign != assign)
+	    k++;
+	 if (k < info->num_candidates) {
+	    candidate = k + 1;
+	    c = &info->candidates[k];
+	    use = find_graft_use(assign, lhs_var, bb_last);
+	    if (use && !graft_keeps_pressure(info, c, use))
+	       continue;
+	 }
+      }
 
       /* Found a possibly graftable assignment.  Now, walk through the
        * rest of the BB seeing if the deref is here, and if nothing interfered with
        * pasting its expression's values in between.
        */
-      info->progress |= try_tree_grafting(assign, lhs_var, bb_last);
+      ir_instruction *after = (ir_instruction *)assign->next;
+      if (try_tree_grafting(assign, lhs_var, bb_last, info->refs)) {
+	 if (use)
+	    graft_update_liveness(info, c, after, use);
+	 info->progress = true;
+      }
    }
+
+   ralloc_free(mem_ctx);
 }
 
 } /* unnamed namespace */
 
 /**
  * Does a copy propagation pass on the code present in the instruction stream.
+ *
+ * If \c refs is given, it must hold the current counts of \c instructions;
+ * it is used instead of counting them again, and is updated for every graft.
+ *
+ * With \c limit_pressure, grafts that would raise the peak number of live
+ * components of a function (see \c ir_liveness) are not done.
  */
 bool
-do_tree_grafting(exec_list *instructions)
+do_tree_grafting(exec_list *instructions, ir_variable_refcount_visitor *refs,
+                 bool limit_pressure)
 {
-   ir_variable_refcount_visitor refs;
+   ir_variable_refcount_visitor *local_refs = NULL;
    struct tree_grafting_info info;
 
-   info.progress = false;
-   info.refs = &refs;
+   if (!refs) {
+      refs = local_refs = new ir_variable_refcount_visitor;
+      visit_list_elements(refs, instructions);
+   }
 
-   visit_list_elements(info.refs, instructions);
+   info.progress = false;
+   info.refs = refs;
+   info.liveness = NULL;
+   if (limit_pressure) {
+      info.liveness = new ir_liveness(true);
+      info.liveness->run(instructions);
+   }
 
    call_for_basic_blocks(instructions, tree_grafting_basic_block, &info);
 
+   delete info.liveness;
+   delete local_refs;
    return info.progress;
 }
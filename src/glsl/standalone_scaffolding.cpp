@@ -154,6 +154,9 @@ void initialize_context_to_defaults(struct gl_context *ctx, gl_api api)
    struct gl_shader_compiler_options options;
    memset(&options, 0, sizeof(options));
    options.MaxUnrollIterations = 8;
+   options.MaxUnrollSizePerIteration = 25;
+   options.UnrollTextureCost = 8;
+   options.UnrollBranchCost = 2;
    options.MaxIfDepth = UINT_MAX;
 
    /* Default pragma settings */
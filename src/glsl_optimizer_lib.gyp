@@ -66,6 +66,8 @@
         'glsl/ir_hierarchical_visitor.h',
         'glsl/ir_hv_accept.cpp',
         'glsl/ir_import_prototypes.cpp',
+        'glsl/ir_liveness.cpp',
+        'glsl/ir_liveness.h',
         'glsl/ir_optimization.h',
         'glsl/ir_print_glsl_visitor.cpp',
         'glsl/ir_print_glsl_visitor.h',
@@ -98,6 +100,7 @@
         'glsl/loop_analysis.cpp',
         'glsl/loop_analysis.h',
         'glsl/loop_controls.cpp',
+        'glsl/loop_invariant.cpp',
         'glsl/loop_unroll.cpp',
         'glsl/lower_clip_distance.cpp',
         'glsl/lower_discard.cpp',
@@ -128,8 +131,10 @@
         'glsl/opt_dead_code_local.cpp',
         'glsl/opt_dead_builtin_variables.cpp',
         'glsl/opt_dead_functions.cpp',
+        'glsl/opt_dead_stores.cpp',
         'glsl/opt_flatten_nested_if_blocks.cpp',
         'glsl/opt_function_inlining.cpp',
+        'glsl/opt_if_pre.cpp',
         'glsl/opt_if_simplification.cpp',
         'glsl/opt_noop_swizzle.cpp',
         'glsl/opt_redundant_jumps.cpp',
@@ -167,10 +172,15 @@
         'mesa/program/prog_statevars.h',
         'mesa/program/symbol_table.c',
         'mesa/program/symbol_table.h',
+        '../include/c11/threads.h',
         'util/hash_table.c',
         'util/hash_table.h',
         'util/ralloc.c',
         'util/ralloc.h',
+        'util/blob.c',
+        'util/blob.h',
+        'util/mesa-sha1.c',
+        'util/mesa-sha1.h',
       ],
       'conditions': [
         ['OS=="win"', {
@@ -188,6 +198,13 @@
           ],
           'msvs_disabled_warnings': [4028, 4244, 4267, 4996],
         }],
+        ['OS!="win"', {
+          'link_settings': {
+            'libraries': [
+              '-lpthread',
+            ],
+          },
+        }],
       ],
     }
   ]
@@ -1020,6 +1020,31 @@ struct gl_shader_compiler_options
    GLuint MaxIfDepth;               /**< Maximum nested IF blocks */
    GLuint MaxUnrollIterations;
 
+   /**
+    * \name Loop unrolling cost model, see loop_unroll.cpp.
+    *
+    * Costs are in estimated ALU instructions.
+    */
+   /*@{*/
+   GLuint MaxUnrollSizePerIteration; /**< Unrolled code may have this times MaxUnrollIterations instructions */
+   GLuint MaxUnrollTemps;    /**< Temporary components unrolled code may declare, 0 for no limit */
+   GLuint MaxUnrollFactor;   /**< Largest factor loops get partially unrolled by, < 2 for never */
+   GLuint MinUnrollGain;     /**< Percent of loop run time partial unrolling has to save */
+   GLuint UnrollTextureCost; /**< Cost of a texture fetch */
+   GLuint UnrollBranchCost;  /**< Cost of a branch */
+   /*@}*/
+
+   /**
+    * \name Function inlining cost model, see opt_function_inlining.cpp.
+    *
+    * Sizes are in instructions counted by ir_stats_counter_visitor.
+    */
+   /*@{*/
+   GLuint MaxInlineGrowth;   /**< Instructions inlining all calls to a function may add, ~0 for no limit */
+   GLuint MaxInlineSize;     /**< Callees up to this size are inlined regardless of growth */
+   GLuint InlineConstantArgBonus; /**< Percent of the callee size each constant argument saves */
+   /*@}*/
+
    /**
     * Optimize code for array of structures backends.
     *
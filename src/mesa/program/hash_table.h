@@ -52,11 +52,12 @@ typedef int (*hash_compare_func_t)(const void *key1, const void *key2);
 /**
  * Hash table constructor
  *
- * Creates a hash table with the specified number of buckets.  The supplied
- * \c hash and \c compare routines are used when adding elements to the table
- * and when searching for elements in the table.
+ * Creates a hash table with room for about the specified number of buckets.
+ * The table grows as needed, so this is only a hint.  The supplied \c hash
+ * and \c compare routines are used when adding elements to the table and
+ * when searching for elements in the table.
  *
- * \param num_buckets  Number of buckets (bins) in the hash table.
+ * \param num_buckets  Initial number of buckets (slots) in the hash table.
  * \param hash         Function used to compute hash value of input keys.
  * \param compare      Function used to compare keys.
  */
@@ -181,6 +182,12 @@ hash_table_pointer_hash(const void *key);
 int
 hash_table_pointer_compare(const void *key1, const void *key2);
 
+/**
+ * Call \c callback on every element of a hash table
+ *
+ * The callback may remove the element it is called on from the table, but
+ * must not add any.
+ */
 void
 hash_table_call_foreach(struct hash_table *ht,
 			void (*callback)(const void *key,
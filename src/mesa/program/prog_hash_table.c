@@ -25,32 +25,61 @@
  * \file hash_table.c
  * \brief Implementation of a generic, opaque hash table data type.
  *
+ * Open addressing with linear probing, in a power-of-two sized array of
+ * slots that doubles whenever three quarters of it are in use.  Each slot
+ * keeps the hash value of its key, so probing only compares keys that are
+ * likely to match, and growing the table never hashes a key again.
+ *
  * \author Ian Romanick <ian.d.romanick@intel.com>
  */
 
 #include "main/errors.h"
-#include "main/simple_list.h"
 #include "hash_table.h"
 
-struct node {
-   struct node *next;
-   struct node *prev;
+struct hash_slot {
+   const void *key;
+   void *data;
+   unsigned hash;
 };
 
 struct hash_table {
-    hash_func_t    hash;
-    hash_compare_func_t  compare;
+   hash_func_t hash;
+   hash_compare_func_t compare;
 
-    unsigned num_buckets;
-    struct node buckets[1];
+   unsigned size_log2;
+   unsigned entries;    /**< Slots holding an element */
+   unsigned deleted;    /**< Slots of removed elements, still probed past */
+   struct hash_slot *slots;
 };
 
+/**
+ * Key of the slots of removed elements.  Free slots have a \c NULL key.
+ */
+static const char deleted_key_value = 0;
+#define deleted_key ((const void *) &deleted_key_value)
 
-struct hash_node {
-    struct node link;
-    const void *key;
-    void *data;
-};
+static inline bool
+slot_is_used(const struct hash_slot *slot)
+{
+   return slot->key != NULL && slot->key != deleted_key;
+}
+
+/**
+ * First slot to probe for a hash value.  The multiplication spreads hash
+ * functions with poor low bits, like that of aligned pointers, over the
+ * whole table.
+ */
+static inline unsigned
+home_slot(const struct hash_table *ht, unsigned hash)
+{
+   return (unsigned) (((uint32_t) hash * 2654435769u) >> (32 - ht->size_log2));
+}
+
+static inline unsigned
+next_slot(const struct hash_table *ht, unsigned i)
+{
+   return (i + 1) & ((1u << ht->size_log2) - 1);
+}
 
 
 struct hash_table *
@@ -58,22 +87,24 @@ hash_table_ctor(unsigned num_buckets, hash_func_t hash,
                 hash_compare_func_t compare)
 {
     struct hash_table *ht;
-    unsigned i;
+    unsigned size_log2 = 4;
 
 
-    if (num_buckets < 16) {
-        num_buckets = 16;
+    while ((1u << size_log2) < num_buckets && size_log2 < 31) {
+        size_log2++;
     }
 
-    ht = malloc(sizeof(*ht) + ((num_buckets - 1) 
-				     * sizeof(ht->buckets[0])));
+    ht = malloc(sizeof(*ht));
     if (ht != NULL) {
         ht->hash = hash;
         ht->compare = compare;
-        ht->num_buckets = num_buckets;
-
-        for (i = 0; i < num_buckets; i++) {
-            make_empty_list(& ht->buckets[i]);
+        ht->size_log2 = size_log2;
+        ht->entries = 0;
+        ht->deleted = 0;
+        ht->slots = calloc(1u << size_log2, sizeof(ht->slots[0]));
+        if (ht->slots == NULL) {
+            free(ht);
+            ht = NULL;
         }
     }
 
@@ -86,7 +117,7 @@ hash_table_dtor(struct hash_table *ht)
 {
    if (!ht)
       return;
-   hash_table_clear(ht);
+   free(ht->slots);
    free(ht);
 }
 
@@ -94,105 +125,199 @@ hash_table_dtor(struct hash_table *ht)
 void
 hash_table_clear(struct hash_table *ht)
 {
-   struct node *node;
-   struct node *temp;
+   memset(ht->slots, 0, (1u << ht->size_log2) * sizeof(ht->slots[0]));
+   ht->entries = 0;
+   ht->deleted = 0;
+}
+
+
+/**
+ * Find the slot of the most recently added instance of \c key.
+ */
+static struct hash_slot *
+find_slot(struct hash_table *ht, const void *key, unsigned hash)
+{
    unsigned i;
 
+   /* There always is a free slot to stop at; see make_room. */
+   for (i = home_slot(ht, hash); ht->slots[i].key != NULL;
+        i = next_slot(ht, i)) {
+      struct hash_slot *slot = &ht->slots[i];
 
-   for (i = 0; i < ht->num_buckets; i++) {
-      foreach_s(node, temp, & ht->buckets[i]) {
-	 remove_from_list(node);
-	 free(node);
+      if (slot->key != deleted_key && slot->hash == hash &&
+          (*ht->compare)(slot->key, key) == 0) {
+         return slot;
       }
-
-      assert(is_empty_list(& ht->buckets[i]));
    }
-}
 
+   return NULL;
+}
 
-static struct hash_node *
-get_node(struct hash_table *ht, const void *key)
+/**
+ * Put an element into the first free slot along its probe sequence.
+ */
+static void
+add_slot(struct hash_table *ht, const void *key, void *data, unsigned hash)
 {
-    const unsigned hash_value = (*ht->hash)(key);
-    const unsigned bucket = hash_value % ht->num_buckets;
-    struct node *node;
+   unsigned i = home_slot(ht, hash);
 
-    foreach(node, & ht->buckets[bucket]) {
-       struct hash_node *hn = (struct hash_node *) node;
+   while (slot_is_used(&ht->slots[i]))
+      i = next_slot(ht, i);
 
-       if ((*ht->compare)(hn->key, key) == 0) {
-	  return hn;
-       }
-    }
+   if (ht->slots[i].key == deleted_key)
+      ht->deleted--;
+   ht->entries++;
 
-    return NULL;
+   ht->slots[i].key = key;
+   ht->slots[i].data = data;
+   ht->slots[i].hash = hash;
+}
+
+/**
+ * Make sure one more element can be added while a quarter of the slots
+ * stays free, growing the table or clearing it of removed elements.
+ */
+static bool
+make_room(struct hash_table *ht)
+{
+   const unsigned size = 1u << ht->size_log2;
+   struct hash_slot *old_slots = ht->slots;
+   unsigned size_log2 = ht->size_log2;
+   unsigned first, i;
+
+   if ((ht->entries + ht->deleted + 1) * 4 <= size * 3)
+      return true;
+
+   if ((ht->entries + 1) * 2 > size) {
+      if (size_log2 == 31)
+         return false;
+      size_log2++;
+   }
+
+   ht->slots = calloc(1u << size_log2, sizeof(ht->slots[0]));
+   if (ht->slots == NULL) {
+      ht->slots = old_slots;
+      return false;
+   }
+   ht->size_log2 = size_log2;
+   ht->entries = 0;
+   ht->deleted = 0;
+
+   /* Starting right after a free slot, every run of used slots is moved in
+    * probe order, which keeps instances of the same key in the order
+    * hash_table_find and hash_table_remove expect them in.
+    */
+   for (first = 0; old_slots[first].key != NULL; first++)
+      ;
+   for (i = 1; i <= size; i++) {
+      const struct hash_slot *slot = &old_slots[(first + i) & (size - 1)];
+
+      if (slot_is_used(slot))
+         add_slot(ht, slot->key, slot->data, slot->hash);
+   }
+
+   free(old_slots);
+   return true;
 }
 
 void *
 hash_table_find(struct hash_table *ht, const void *key)
 {
-   struct hash_node *hn = get_node(ht, key);
+   struct hash_slot *slot = find_slot(ht, key, (*ht->hash)(key));
 
-   return (hn == NULL) ? NULL : hn->data;
+   return (slot == NULL) ? NULL : slot->data;
 }
 
 void
 hash_table_insert(struct hash_table *ht, void *data, const void *key)
 {
-    const unsigned hash_value = (*ht->hash)(key);
-    const unsigned bucket = hash_value % ht->num_buckets;
-    struct hash_node *node;
+    const unsigned hash = (*ht->hash)(key);
+    struct hash_slot *slot;
+
+    assert(key != NULL);
 
-    node = calloc(1, sizeof(*node));
-    if (node == NULL) {
+    if (!make_room(ht)) {
        _mesa_error_no_memory(__func__);
        return;
     }
 
-    node->data = data;
-    node->key = key;
+    slot = find_slot(ht, key, hash);
+    if (slot == NULL) {
+       add_slot(ht, key, data, hash);
+       return;
+    }
 
-    insert_at_head(& ht->buckets[bucket], & node->link);
+    /* The new instance takes the place of the most recent one, which moves
+     * further along the probe sequence, and so on for older instances, until
+     * one lands in a free slot.
+     */
+    for (;;) {
+       struct hash_slot older = *slot;
+       unsigned i = slot - ht->slots;
+
+       slot->key = key;
+       slot->data = data;
+
+       do {
+          i = next_slot(ht, i);
+          slot = &ht->slots[i];
+       } while (slot_is_used(slot) &&
+                !(slot->hash == hash &&
+                  (*ht->compare)(slot->key, older.key) == 0));
+
+       key = older.key;
+       data = older.data;
+
+       if (!slot_is_used(slot)) {
+          if (slot->key == deleted_key)
+             ht->deleted--;
+          ht->entries++;
+
+          slot->key = key;
+          slot->data = data;
+          slot->hash = hash;
+          return;
+       }
+    }
 }
 
 bool
 hash_table_replace(struct hash_table *ht, void *data, const void *key)
 {
-    const unsigned hash_value = (*ht->hash)(key);
-    const unsigned bucket = hash_value % ht->num_buckets;
-    struct node *node;
-    struct hash_node *hn;
-
-    foreach(node, & ht->buckets[bucket]) {
-       hn = (struct hash_node *) node;
+    const unsigned hash = (*ht->hash)(key);
+    struct hash_slot *slot = find_slot(ht, key, hash);
 
-       if ((*ht->compare)(hn->key, key) == 0) {
-	  hn->data = data;
-	  return true;
-       }
+    if (slot != NULL) {
+       slot->data = data;
+       return true;
     }
 
-    hn = calloc(1, sizeof(*hn));
-    if (hn == NULL) {
+    assert(key != NULL);
+
+    if (!make_room(ht)) {
        _mesa_error_no_memory(__func__);
        return false;
     }
 
-    hn->data = data;
-    hn->key = key;
-
-    insert_at_head(& ht->buckets[bucket], & hn->link);
+    add_slot(ht, key, data, hash);
     return false;
 }
 
 void
 hash_table_remove(struct hash_table *ht, const void *key)
 {
-   struct node *node = (struct node *) get_node(ht, key);
-   if (node != NULL) {
-      remove_from_list(node);
-      free(node);
-      return;
+   struct hash_slot *slot = find_slot(ht, key, (*ht->hash)(key));
+
+   if (slot != NULL) {
+      /* Nothing is probed for past a slot followed by a free one. */
+      if (ht->slots[next_slot(ht, slot - ht->slots)].key == NULL) {
+         slot->key = NULL;
+      } else {
+         slot->key = deleted_key;
+         ht->deleted++;
+      }
+      slot->data = NULL;
+      ht->entries--;
    }
 }
 
@@ -203,15 +328,13 @@ hash_table_call_foreach(struct hash_table *ht,
 					 void *closure),
 			void *closure)
 {
-   unsigned bucket;
+   unsigned i;
 
-   for (bucket = 0; bucket < (int)ht->num_buckets; bucket++) {
-      struct node *node, *temp;
-      foreach_s(node, temp, &ht->buckets[bucket]) {
-	 struct hash_node *hn = (struct hash_node *) node;
+   for (i = 0; i < (1u << ht->size_log2); i++) {
+      struct hash_slot *slot = &ht->slots[i];
 
-	 callback(hn->key, hn->data, closure);
-      }
+      if (slot_is_used(slot))
+	 callback(slot->key, slot->data, closure);
    }
 }
 
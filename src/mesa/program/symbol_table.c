@@ -414,6 +414,112 @@ _mesa_symbol_table_ctor(void)
 }
 
 
+/**
+ * Make a copy of a symbol table, with the same symbols in the same scopes,
+ * so that adding to, looking up in and popping scopes off the copy works
+ * exactly as in the original.
+ *
+ * \param clone_data  Called on the data of each symbol to get that of its
+ *                    copy.
+ */
+struct _mesa_symbol_table *
+_mesa_symbol_table_clone(struct _mesa_symbol_table *table,
+                         void *(*clone_data)(void *data, void *closure),
+                         void *closure)
+{
+   struct _mesa_symbol_table *copy = _mesa_symbol_table_ctor();
+   struct hash_table *copies;
+   struct scope_level **scopes;
+   struct scope_level *scope;
+   struct symbol_header *hdr;
+   unsigned num_scopes = 0;
+   unsigned i;
+
+   if (copy == NULL)
+      return NULL;
+
+   for (scope = table->current_scope; scope != NULL; scope = scope->next)
+      num_scopes++;
+
+   scopes = malloc(num_scopes * sizeof(*scopes));
+   copies = hash_table_ctor(0, hash_table_pointer_hash,
+                            hash_table_pointer_compare);
+   if (scopes == NULL || copies == NULL) {
+      free(scopes);
+      if (copies != NULL)
+         hash_table_dtor(copies);
+      _mesa_symbol_table_dtor(copy);
+      _mesa_error_no_memory(__func__);
+      return NULL;
+   }
+
+   /* The constructor pushed the outermost scope already. */
+   for (i = 1; i < num_scopes; i++)
+      _mesa_symbol_table_push_scope(copy);
+
+   i = num_scopes;
+   for (scope = table->current_scope; scope != NULL; scope = scope->next)
+      scopes[--i] = scope;
+
+   /* Copy the symbols of each scope, keeping their order in it... */
+   for (scope = copy->current_scope, i = num_scopes; i-- > 0;
+        scope = scope->next) {
+      struct symbol **tail = &scope->symbols;
+      struct symbol *sym;
+
+      for (sym = scopes[i]->symbols; sym != NULL;
+           sym = sym->next_with_same_scope) {
+         struct symbol *sym_copy = calloc(1, sizeof(*sym_copy));
+
+         if (sym_copy == NULL) {
+            _mesa_error_no_memory(__func__);
+            break;
+         }
+
+         sym_copy->name_space = sym->name_space;
+         sym_copy->depth = sym->depth;
+         sym_copy->data = clone_data(sym->data, closure);
+         hash_table_insert(copies, sym_copy, sym);
+
+         *tail = sym_copy;
+         tail = &sym_copy->next_with_same_scope;
+      }
+   }
+
+   /* ...and then the order of the symbols with each name. */
+   for (hdr = table->hdr; hdr != NULL; hdr = hdr->next) {
+      struct symbol_header *hdr_copy = calloc(1, sizeof(*hdr_copy));
+      struct symbol **tail;
+      struct symbol *sym;
+
+      if (hdr_copy == NULL) {
+         _mesa_error_no_memory(__func__);
+         break;
+      }
+
+      hdr_copy->name = strdup(hdr->name);
+      hash_table_insert(copy->ht, hdr_copy, hdr_copy->name);
+      hdr_copy->next = copy->hdr;
+      copy->hdr = hdr_copy;
+
+      tail = &hdr_copy->symbols;
+      for (sym = hdr->symbols; sym != NULL; sym = sym->next_with_same_name) {
+         struct symbol *sym_copy = hash_table_find(copies, sym);
+
+         sym_copy->hdr = hdr_copy;
+         *tail = sym_copy;
+         tail = &sym_copy->next_with_same_name;
+      }
+   }
+
+   hash_table_dtor(copies);
+   free(scopes);
+
+   check_symbol_table(copy);
+   return copy;
+}
+
+
 void
 _mesa_symbol_table_dtor(struct _mesa_symbol_table *table)
 {
@@ -46,4 +46,8 @@ extern struct _mesa_symbol_table *_mesa_symbol_table_ctor(void);
 
 extern void _mesa_symbol_table_dtor(struct _mesa_symbol_table *);
 
+extern struct _mesa_symbol_table *_mesa_symbol_table_clone(
+    struct _mesa_symbol_table *table,
+    void *(*clone_data)(void *data, void *closure), void *closure);
+
 #endif /* MESA_SYMBOL_TABLE_H */
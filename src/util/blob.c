@@ -0,0 +1,172 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "blob.h"
+
+#define BLOB_INITIAL_SIZE 4096
+
+static bool
+grow_to_fit(struct blob *blob, size_t additional)
+{
+   size_t to_allocate;
+   uint8_t *new_data;
+
+   if (blob->out_of_memory)
+      return false;
+
+   if (blob->size + additional <= blob->allocated)
+      return true;
+
+   if (blob->allocated == 0)
+      to_allocate = BLOB_INITIAL_SIZE;
+   else
+      to_allocate = blob->allocated * 2;
+
+   if (to_allocate < blob->size + additional)
+      to_allocate = blob->size + additional;
+
+   new_data = (uint8_t *) realloc(blob->data, to_allocate);
+   if (new_data == NULL) {
+      blob->out_of_memory = true;
+      return false;
+   }
+
+   blob->data = new_data;
+   blob->allocated = to_allocate;
+
+   return true;
+}
+
+void
+blob_init(struct blob *blob)
+{
+   blob->data = NULL;
+   blob->allocated = 0;
+   blob->size = 0;
+   blob->out_of_memory = false;
+}
+
+void
+blob_finish(struct blob *blob)
+{
+   free(blob->data);
+   blob_init(blob);
+}
+
+bool
+blob_write_bytes(struct blob *blob, const void *bytes, size_t to_write)
+{
+   if (!grow_to_fit(blob, to_write))
+      return false;
+
+   memcpy(blob->data + blob->size, bytes, to_write);
+   blob->size += to_write;
+
+   return true;
+}
+
+bool
+blob_write_uint32(struct blob *blob, uint32_t value)
+{
+   return blob_write_bytes(blob, &value, sizeof(value));
+}
+
+bool
+blob_write_uint64(struct blob *blob, uint64_t value)
+{
+   return blob_write_bytes(blob, &value, sizeof(value));
+}
+
+bool
+blob_write_string(struct blob *blob, const char *str)
+{
+   return blob_write_bytes(blob, str, strlen(str) + 1);
+}
+
+void
+blob_reader_init(struct blob_reader *blob, const void *data, size_t size)
+{
+   blob->data = (const uint8_t *) data;
+   blob->end = blob->data + size;
+   blob->current = blob->data;
+   blob->overrun = false;
+}
+
+const void *
+blob_read_bytes(struct blob_reader *blob, size_t size)
+{
+   const void *ret;
+
+   if (blob->overrun || (size_t) (blob->end - blob->current) < size) {
+      blob->overrun = true;
+      return NULL;
+   }
+
+   ret = blob->current;
+   blob->current += size;
+
+   return ret;
+}
+
+uint32_t
+blob_read_uint32(struct blob_reader *blob)
+{
+   uint32_t value = 0;
+   const void *bytes = blob_read_bytes(blob, sizeof(value));
+   if (bytes)
+      memcpy(&value, bytes, sizeof(value));
+   return value;
+}
+
+uint64_t
+blob_read_uint64(struct blob_reader *blob)
+{
+   uint64_t value = 0;
+   const void *bytes = blob_read_bytes(blob, sizeof(value));
+   if (bytes)
+      memcpy(&value, bytes, sizeof(value));
+   return value;
+}
+
+const char *
+blob_read_string(struct blob_reader *blob)
+{
+   const uint8_t *nul;
+   const char *ret;
+
+   if (blob->overrun || blob->current >= blob->end) {
+      blob->overrun = true;
+      return NULL;
+   }
+
+   nul = (const uint8_t *) memchr(blob->current, 0, blob->end - blob->current);
+   if (nul == NULL) {
+      blob->overrun = true;
+      return NULL;
+   }
+
+   ret = (const char *) blob->current;
+   blob->current = nul + 1;
+
+   return ret;
+}
@@ -0,0 +1,83 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BLOB_H
+#define BLOB_H
+
+#include <stddef.h>
+#include <inttypes.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \file blob.h
+ * Growable byte buffer for serializing data, and a matching reader.
+ *
+ * Values are written in host byte order; blobs are meant to be read back by
+ * the same build of the library, not exchanged between machines.
+ */
+
+struct blob {
+   uint8_t *data;
+   size_t allocated;
+   size_t size;
+
+   /** Set when growing the buffer failed; all later writes are dropped. */
+   bool out_of_memory;
+};
+
+struct blob_reader {
+   const uint8_t *data;
+   const uint8_t *end;
+   const uint8_t *current;
+
+   /** Set when a read went past the end; all later reads return zeros. */
+   bool overrun;
+};
+
+void blob_init(struct blob *blob);
+void blob_finish(struct blob *blob);
+
+bool blob_write_bytes(struct blob *blob, const void *bytes, size_t to_write);
+bool blob_write_uint32(struct blob *blob, uint32_t value);
+bool blob_write_uint64(struct blob *blob, uint64_t value);
+
+/** Writes a NUL-terminated string, including the terminator. */
+bool blob_write_string(struct blob *blob, const char *str);
+
+void blob_reader_init(struct blob_reader *blob, const void *data, size_t size);
+
+/** Returns a pointer into the blob data, or NULL on overrun. */
+const void *blob_read_bytes(struct blob_reader *blob, size_t size);
+uint32_t blob_read_uint32(struct blob_reader *blob);
+uint64_t blob_read_uint64(struct blob_reader *blob);
+
+/** Returns a pointer to the string inside the blob data, or NULL on overrun. */
+const char *blob_read_string(struct blob_reader *blob);
+
+#ifdef __cplusplus
+} /* extern C */
+#endif
+
+#endif /* BLOB_H */
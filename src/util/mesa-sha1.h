@@ -0,0 +1,58 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MESA_SHA1_H
+#define MESA_SHA1_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Incremental SHA-1 (FIPS 180-1) state.
+ *
+ * Used to build content keys for caches; not meant for anything security
+ * sensitive.
+ */
+struct mesa_sha1 {
+   uint32_t state[5];
+   uint64_t count;            /**< number of bytes hashed so far */
+   unsigned char buffer[64];  /**< pending partial block */
+};
+
+void _mesa_sha1_init(struct mesa_sha1 *ctx);
+void _mesa_sha1_update(struct mesa_sha1 *ctx, const void *data, size_t size);
+void _mesa_sha1_final(struct mesa_sha1 *ctx, unsigned char result[20]);
+
+/**
+ * Writes the 40 character hexadecimal form of \c sha1 plus a terminating
+ * NUL into \c buf, and returns \c buf.
+ */
+char *_mesa_sha1_format(char *buf, const unsigned char *sha1);
+
+#ifdef __cplusplus
+} /* extern C */
+#endif
+
+#endif /* MESA_SHA1_H */
@@ -68,10 +68,60 @@ struct ralloc_header
    struct ralloc_header *next;
 
    void (*destructor)(void *);
+
+   /* The arena this block was carved out of, or NULL for blocks that came
+    * straight from calloc.  An arena context's own header points at the
+    * arena it owns.
+    */
+   struct ralloc_arena *arena;
 };
 
 typedef struct ralloc_header ralloc_header;
 
+/* Arena slabs start small and double up to this size; larger requests get
+ * a slab of their own.
+ */
+#define ARENA_MIN_SLAB_SIZE (8 * 1024)
+#define ARENA_MAX_SLAB_SIZE (64 * 1024)
+
+struct ralloc_slab
+{
+   struct ralloc_slab *next;
+};
+
+/* Destructors of arena blocks are not run when a block is freed on its own
+ * (its subtree is not visited); they are recorded here and run when the
+ * arena goes away instead.
+ */
+struct ralloc_deferred
+{
+   ralloc_header *block;
+   struct ralloc_deferred *next;
+};
+
+struct ralloc_arena
+{
+   /* The arena context; freeing it releases every slab. */
+   struct ralloc_header *root;
+
+   struct ralloc_slab *slabs;
+   char *next;
+   char *end;
+   size_t slab_size;
+
+   struct ralloc_deferred *destructors;
+
+   /* Set once a block in the arena adopts a calloc'd child (or another
+    * arena).  Until then freeing arena memory never needs to visit the
+    * blocks themselves.
+    */
+   bool needs_walk;
+};
+
+/* Every arena block is preceded by its usable size, for resize(). */
+#define ARENA_BLOCK_OVERHEAD (sizeof(size_t) + sizeof(ralloc_header))
+#define ARENA_ALIGN(n) (((n) + 7) & ~(size_t) 7)
+
 static void unlink_block(ralloc_header *info);
 static void unsafe_free(ralloc_header *info);
 
@@ -88,6 +138,18 @@ get_header(const void *ptr)
 
 #define PTR_FROM_HEADER(info) (((char *) info) + sizeof(ralloc_header))
 
+static inline bool
+is_arena_block(const ralloc_header *info)
+{
+   return info->arena != NULL && info->arena->root != info;
+}
+
+static inline size_t *
+arena_block_size(ralloc_header *info)
+{
+   return (size_t *) (((char *) info) - sizeof(size_t));
+}
+
 static void
 add_child(ralloc_header *parent, ralloc_header *info)
 {
@@ -98,6 +160,110 @@ add_child(ralloc_header *parent, ralloc_header *info)
 
       if (info->next != NULL)
 	 info->next->prev = info;
+
+      /* A calloc'd block (or another arena) hanging off this arena has to
+       * be found and freed when the arena goes away.
+       */
+      if (parent->arena != NULL && info->arena != parent->arena)
+	 parent->arena->needs_walk = true;
+   }
+}
+
+/* Take \p total bytes (already aligned) from the current slab, starting a
+ * new one if needed.  Slabs come from calloc and arena memory is never
+ * handed out twice, so the result is always zeroed.
+ */
+static void *
+arena_bump(struct ralloc_arena *arena, size_t total)
+{
+   const size_t slab_header = ARENA_ALIGN(sizeof(struct ralloc_slab));
+   struct ralloc_slab *slab;
+   char *ptr;
+
+   if ((size_t) (arena->end - arena->next) >= total) {
+      ptr = arena->next;
+      arena->next += total;
+      return ptr;
+   }
+
+   /* Big requests get a slab of their own, leaving the current one be. */
+   if (total > ARENA_MAX_SLAB_SIZE / 4) {
+      slab = calloc(1, slab_header + total);
+      if (unlikely(slab == NULL))
+	 return NULL;
+
+      slab->next = arena->slabs;
+      arena->slabs = slab;
+      return (char *) slab + slab_header;
+   }
+
+   slab = calloc(1, arena->slab_size);
+   if (unlikely(slab == NULL))
+      return NULL;
+
+   slab->next = arena->slabs;
+   arena->slabs = slab;
+   arena->next = (char *) slab + slab_header + total;
+   arena->end = (char *) slab + arena->slab_size;
+
+   if (arena->slab_size < ARENA_MAX_SLAB_SIZE)
+      arena->slab_size *= 2;
+
+   return (char *) slab + slab_header;
+}
+
+static ralloc_header *
+arena_alloc(struct ralloc_arena *arena, size_t size)
+{
+   size_t total = ARENA_ALIGN(ARENA_BLOCK_OVERHEAD + size);
+   ralloc_header *info;
+   char *ptr;
+
+   if (unlikely(total < size))
+      return NULL;
+
+   ptr = arena_bump(arena, total);
+   if (unlikely(ptr == NULL))
+      return NULL;
+
+   info = (ralloc_header *) (ptr + sizeof(size_t));
+   *arena_block_size(info) = size;
+   info->arena = arena;
+#ifdef DEBUG
+   info->canary = CANARY;
+#endif
+   return info;
+}
+
+static void
+arena_defer_destructor(ralloc_header *info)
+{
+   struct ralloc_arena *arena = info->arena;
+   struct ralloc_deferred *d =
+      arena_bump(arena, ARENA_ALIGN(sizeof(struct ralloc_deferred)));
+
+   /* Out of memory: fall back to visiting every block on free. */
+   if (unlikely(d == NULL)) {
+      arena->needs_walk = true;
+      return;
+   }
+
+   d->block = info;
+   d->next = arena->destructors;
+   arena->destructors = d;
+}
+
+static void
+call_destructor(ralloc_header *info)
+{
+   void (*destructor)(void *) = info->destructor;
+
+   /* Arena blocks can be reached twice (on their own and through the
+    * deferred list), so a destructor only ever runs once.
+    */
+   if (destructor != NULL) {
+      info->destructor = NULL;
+      destructor(PTR_FROM_HEADER(info));
    }
 }
 
@@ -107,18 +273,52 @@ ralloc_context(const void *ctx)
    return ralloc_size(ctx, 0);
 }
 
+void *
+ralloc_arena_context(const void *ctx)
+{
+   struct ralloc_arena *arena;
+   ralloc_header *info;
+
+   /* The arena context itself is a regular calloc'd block, so that it can
+    * be freed or stolen like any other context, with the arena bookkeeping
+    * stored right behind it.
+    */
+   info = calloc(1, sizeof(ralloc_header) + sizeof(struct ralloc_arena));
+   if (unlikely(info == NULL))
+      return NULL;
+
+   arena = (struct ralloc_arena *) PTR_FROM_HEADER(info);
+   arena->root = info;
+   arena->slab_size = ARENA_MIN_SLAB_SIZE;
+   info->arena = arena;
+#ifdef DEBUG
+   info->canary = CANARY;
+#endif
+
+   add_child(ctx != NULL ? get_header(ctx) : NULL, info);
+   return arena;
+}
+
 void *
 ralloc_size(const void *ctx, size_t size)
 {
-   void *block = calloc(1, size + sizeof(ralloc_header));
    ralloc_header *info;
    ralloc_header *parent;
 
-   if (unlikely(block == NULL))
-      return NULL;
-   info = (ralloc_header *) block;
    parent = ctx != NULL ? get_header(ctx) : NULL;
 
+   if (parent != NULL && parent->arena != NULL) {
+      info = arena_alloc(parent->arena, size);
+      if (unlikely(info == NULL))
+	 return NULL;
+      add_child(parent, info);
+      return PTR_FROM_HEADER(info);
+   }
+
+   info = calloc(1, size + sizeof(ralloc_header));
+   if (unlikely(info == NULL))
+      return NULL;
+
    add_child(parent, info);
 
 #ifdef DEBUG
@@ -137,6 +337,47 @@ rzalloc_size(const void *ctx, size_t size)
    return ptr;
 }
 
+/* Grow an arena block.  The most recent allocation is extended in place;
+ * anything else is copied into a new block and the old one is abandoned.
+ * Copies at least double the capacity so that strings built up by
+ * repeated appends stay linear in size.
+ */
+static ralloc_header *
+arena_resize(ralloc_header *old, size_t size)
+{
+   struct ralloc_arena *arena = old->arena;
+   size_t old_size = *arena_block_size(old);
+   char *old_end = (char *) old - sizeof(size_t) +
+		   ARENA_ALIGN(ARENA_BLOCK_OVERHEAD + old_size);
+   ralloc_header *info;
+
+   if (size <= old_size)
+      return old;
+
+   if (old_end == arena->next) {
+      size_t total = ARENA_ALIGN(ARENA_BLOCK_OVERHEAD + size);
+      char *new_end = (char *) old - sizeof(size_t) + total;
+      if (total >= size && new_end <= arena->end) {
+	 arena->next = new_end;
+	 *arena_block_size(old) = size;
+	 return old;
+      }
+   }
+
+   info = arena_alloc(arena, size < old_size * 2 ? old_size * 2 : size);
+   if (unlikely(info == NULL))
+      return NULL;
+
+   memcpy(info, old, sizeof(ralloc_header));
+   memcpy(PTR_FROM_HEADER(info), PTR_FROM_HEADER(old), old_size);
+
+   if (info->destructor != NULL) {
+      old->destructor = NULL;
+      arena_defer_destructor(info);
+   }
+   return info;
+}
+
 /* helper function - assumes ptr != NULL */
 static void *
 resize(void *ptr, size_t size)
@@ -144,7 +385,14 @@ resize(void *ptr, size_t size)
    ralloc_header *child, *old, *info;
 
    old = get_header(ptr);
-   info = realloc(old, size + sizeof(ralloc_header));
+
+   /* An arena context keeps its bookkeeping where its data would be. */
+   assert(old->arena == NULL || old->arena->root != old);
+
+   if (old->arena != NULL)
+      info = arena_resize(old, size);
+   else
+      info = realloc(old, size + sizeof(ralloc_header));
 
    if (info == NULL)
       return NULL;
@@ -240,17 +488,45 @@ unlink_block(ralloc_header *info)
 static void
 unsafe_free(ralloc_header *info)
 {
-   /* Recursively free any children...don't waste time unlinking them. */
+   struct ralloc_arena *arena = info->arena;
+   bool arena_block = is_arena_block(info);
+
+   /* Recursively free any children...don't waste time unlinking them.
+    * Unless calloc'd blocks were stolen into the arena, its subtrees hold
+    * nothing but arena memory and deferred destructors, so they are
+    * skipped altogether.
+    */
    ralloc_header *temp;
-   while (info->child != NULL) {
-      temp = info->child;
-      info->child = temp->next;
-      unsafe_free(temp);
+   if (arena == NULL || arena->needs_walk) {
+      while (info->child != NULL) {
+	 temp = info->child;
+	 info->child = temp->next;
+	 unsafe_free(temp);
+      }
+   }
+
+   /* Arena memory is only reclaimed when the whole arena goes. */
+   if (arena_block) {
+      call_destructor(info);
+      return;
+   }
+
+   if (arena != NULL) {
+      struct ralloc_deferred *d;
+      for (d = arena->destructors; d != NULL; d = d->next)
+	 call_destructor(d->block);
    }
 
    /* Free the block itself.  Call the destructor first, if any. */
-   if (info->destructor != NULL)
-      info->destructor(PTR_FROM_HEADER(info));
+   call_destructor(info);
+
+   if (arena != NULL) {
+      while (arena->slabs != NULL) {
+	 struct ralloc_slab *slab = arena->slabs;
+	 arena->slabs = slab->next;
+	 free(slab);
+      }
+   }
 
    free(info);
 }
@@ -264,7 +540,7 @@ ralloc_steal(const void *new_ctx, void *ptr)
       return;
 
    info = get_header(ptr);
-   parent = get_header(new_ctx);
+   parent = new_ctx ? get_header(new_ctx) : NULL;
 
    unlink_block(info);
 
@@ -306,6 +582,8 @@ ralloc_set_destructor(const void *ptr, void(*destructor)(void *))
 {
    ralloc_header *info = get_header(ptr);
    info->destructor = destructor;
+   if (destructor != NULL && is_arena_block(info))
+      arena_defer_destructor(info);
 }
 
 char *
@@ -381,6 +659,24 @@ ralloc_strncat(char **dest, const char *str, size_t n)
    return cat(dest, str, n);
 }
 
+bool
+ralloc_str_append(char **dest, const char *str,
+                  size_t existing_length, size_t str_size)
+{
+   char *both;
+   assert(dest != NULL && *dest != NULL);
+
+   both = resize(*dest, existing_length + str_size + 1);
+   if (unlikely(both == NULL))
+      return false;
+
+   memcpy(both + existing_length, str, str_size);
+   both[existing_length + str_size] = '\0';
+
+   *dest = both;
+   return true;
+}
+
 char *
 ralloc_asprintf(const void *ctx, const char *fmt, ...)
 {
@@ -91,6 +91,23 @@ extern "C" {
  */
 void *ralloc_context(const void *ctx);
 
+/**
+ * Allocate a new arena context.
+ *
+ * This behaves like ralloc_context(), except that everything allocated out
+ * of it, directly or through any of its descendants, is carved out of large
+ * slabs owned by the arena instead of being calloc'd one at a time.
+ *
+ * Calling ralloc_free() on memory from an arena only unlinks it; nothing is
+ * returned until the arena context itself is freed, at which point all of
+ * its slabs are released at once.  Destructors still run, but those of
+ * blocks that were freed along with a parent are postponed until then.
+ *
+ * Arena memory may be stolen into contexts outside of the arena, but the
+ * arena must be freed after them.
+ */
+void *ralloc_arena_context(const void *ctx);
+
 /**
  * Allocate memory chained off of the given context.
  *
@@ -294,6 +311,20 @@ bool ralloc_strcat(char **dest, const char *str);
  */
 bool ralloc_strncat(char **dest, const char *str, size_t n);
 
+/**
+ * Append \p str_size bytes of \p str to \p *dest, which is
+ * \p existing_length bytes long.
+ *
+ * Like \c ralloc_strncat, but neither string gets measured, which makes it
+ * the cheap way to build a long string from many small pieces.
+ *
+ * The result will always be null-terminated.
+ *
+ * \return True unless allocation failed.
+ */
+bool ralloc_str_append(char **dest, const char *str,
+                       size_t existing_length, size_t str_size);
+
 /**
  * Print to a string.
  *
@@ -0,0 +1,492 @@
+// Throughput benchmark over the tests/ corpus.
+//
+// Every *-in*.txt shader under tests/vertex and tests/fragment is loaded once,
+// and then compiled N times for each target the test suite uses it with
+// (-inES: ES2, -inES3: ES3 and Metal, -in: GL). Reports per-shader median/p95
+// latency, shaders/sec, heap allocations per compile and peak memory; with
+// -json also writes all of that to a file, for tracking across commits.
+//
+// With -symbols N, also times generated shaders with N uniforms and with N
+// macros, per compile phase: these stress the symbol and hash tables of the
+// front end rather than the optimization passes.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../../src/glsl/glsl_optimizer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <dirent.h>
+#include <sys/resource.h>
+#endif
+
+
+// ---- Allocation counting
+//
+// With glibc, malloc & friends can be replaced in the executable and forwarded
+// to the real implementation; elsewhere allocation counts are not available.
+
+#if defined(__GLIBC__)
+#define HAVE_ALLOCATION_COUNT 1
+static size_t s_Allocations = 0;
+extern "C" {
+void* __libc_malloc (size_t size);
+void* __libc_calloc (size_t n, size_t size);
+void* __libc_realloc (void* ptr, size_t size);
+void* malloc (size_t size) { ++s_Allocations; return __libc_malloc (size); }
+void* calloc (size_t n, size_t size) { ++s_Allocations; return __libc_calloc (n, size); }
+void* realloc (void* ptr, size_t size) { ++s_Allocations; return __libc_realloc (ptr, size); }
+}
+#else
+#define HAVE_ALLOCATION_COUNT 0
+static size_t s_Allocations = 0;
+#endif
+
+
+static double GetTimeMs ()
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, t;
+	QueryPerformanceFrequency (&freq);
+	QueryPerformanceCounter (&t);
+	return t.QuadPart * 1000.0 / freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1.0e6;
+#endif
+}
+
+// Peak resident memory of the process so far, in KB
+static long GetPeakMemoryKB ()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo (GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+	return (long)(pmc.PeakWorkingSetSize / 1024);
+#else
+	struct rusage ru;
+	getrusage (RUSAGE_SELF, &ru);
+	#ifdef __APPLE__
+	return ru.ru_maxrss / 1024; // bytes on OS X
+	#else
+	return ru.ru_maxrss;
+	#endif
+#endif
+}
+
+
+// ---- Corpus loading; same file naming and GLES input massaging as glsl_test
+
+typedef std::vector<std::string> StringVector;
+
+static bool ReadStringFromFile (const std::string& pathName, std::string& output)
+{
+	FILE* file = fopen (pathName.c_str(), "rb");
+	if (file == NULL)
+		return false;
+	fseek (file, 0, SEEK_END);
+	long length = ftell (file);
+	fseek (file, 0, SEEK_SET);
+	if (length < 0)
+	{
+		fclose (file);
+		return false;
+	}
+	output.resize (length);
+	size_t readLength = length ? fread (&output[0], 1, length, file) : 0;
+	fclose (file);
+	if (readLength != (size_t)length)
+		return false;
+
+	size_t p = 0;
+	while ((p = output.find ("\r\n", p)) != std::string::npos)
+		output.erase (p, 1);
+	return true;
+}
+
+static bool EndsWith (const std::string& str, const std::string& sub)
+{
+	return (str.size() >= sub.size()) && (strncmp (str.c_str()+str.size()-sub.size(), sub.c_str(), sub.size())==0);
+}
+
+static StringVector GetFiles (const std::string& folder, const std::string& endsWith)
+{
+	StringVector res;
+	#ifdef _WIN32
+	WIN32_FIND_DATAA findData;
+	HANDLE hFind = FindFirstFileA ((folder+"/*"+endsWith).c_str(), &findData);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return res;
+	do {
+		res.push_back (findData.cFileName);
+	} while (FindNextFileA (hFind, &findData));
+	FindClose (hFind);
+	#else
+	DIR* dirp = opendir (folder.c_str());
+	if (dirp == NULL)
+		return res;
+	while (struct dirent* dp = readdir (dirp))
+	{
+		std::string fname = dp->d_name;
+		if (EndsWith (fname, endsWith))
+			res.push_back (fname);
+	}
+	closedir (dirp);
+	#endif
+	// directory order is arbitrary; keep runs comparable
+	std::sort (res.begin(), res.end());
+	return res;
+}
+
+static void MassageVertexForGLES (std::string& s)
+{
+	if (s.find ("_glesVertex") != std::string::npos)
+		return;
+	const char* kind = "attribute";
+	std::string version = "#version 300 es\n";
+	size_t insertPoint = s.find (version);
+	if (insertPoint != std::string::npos)
+	{
+		insertPoint += version.size();
+		kind = "in";
+	}
+	else
+		insertPoint = 0;
+	std::string pre;
+	pre += std::string("#define gl_Vertex _glesVertex\n") + kind + " highp vec4 _glesVertex;\n";
+	pre += std::string("#define gl_Normal _glesNormal\n") + kind + " mediump vec3 _glesNormal;\n";
+	pre += std::string("#define gl_MultiTexCoord0 _glesMultiTexCoord0\n") + kind + " highp vec4 _glesMultiTexCoord0;\n";
+	pre += std::string("#define gl_MultiTexCoord1 _glesMultiTexCoord1\n") + kind + " highp vec4 _glesMultiTexCoord1;\n";
+	pre += std::string("#define gl_Color _glesColor\n") + kind + " lowp vec4 _glesColor;\n";
+	s.insert (insertPoint, pre);
+}
+
+
+// ---- Benchmark
+
+static const int kTargetCount = 4;
+static const glslopt_target kTargets[kTargetCount] = {
+	kGlslTargetOpenGLES20, kGlslTargetOpenGLES30, kGlslTargetOpenGL, kGlslTargetMetal,
+};
+static const char* kTargetNames[kTargetCount] = { "ES2", "ES3", "GL", "Metal" };
+
+struct BenchShader
+{
+	std::string name;
+	glslopt_shader_type type;
+	int target;
+	std::string source;
+
+	bool ok;
+	double medianMs;
+	double p95Ms;
+	double allocations; // per compile
+};
+typedef std::vector<BenchShader> BenchShaderVector;
+
+static void LoadCorpus (const std::string& baseFolder, BenchShaderVector& shaders)
+{
+	static const char* kTypeName[2] = { "vertex", "fragment" };
+	static const char* kApiIn[3] = { "-inES.txt", "-inES3.txt", "-in.txt" };
+	for (int type = 0; type < 2; ++type)
+	{
+		const std::string folder = baseFolder + "/" + kTypeName[type];
+		for (int api = 0; api < 3; ++api)
+		{
+			StringVector files = GetFiles (folder, kApiIn[api]);
+			for (size_t i = 0; i < files.size(); ++i)
+			{
+				BenchShader sh;
+				sh.name = std::string(kTypeName[type]) + "/" + files[i];
+				sh.type = type == 0 ? kGlslOptShaderVertex : kGlslOptShaderFragment;
+				sh.ok = false;
+				sh.medianMs = sh.p95Ms = sh.allocations = 0.0;
+				if (!ReadStringFromFile (folder + "/" + files[i], sh.source))
+				{
+					printf ("  %s: failed to read\n", sh.name.c_str());
+					continue;
+				}
+				if (api <= 1 && type == 0)
+					MassageVertexForGLES (sh.source);
+				sh.target = api;
+				shaders.push_back (sh);
+				// ES3 inputs also go through the Metal target
+				if (api == 1)
+				{
+					sh.target = 3;
+					shaders.push_back (sh);
+				}
+			}
+		}
+	}
+}
+
+static double Percentile (std::vector<double>& sorted, double p)
+{
+	size_t idx = (size_t)(p * (sorted.size() - 1) + 0.5);
+	return sorted[idx];
+}
+
+static void RunShader (glslopt_ctx* ctx, BenchShader& sh, int iterations)
+{
+	// one untimed compile first, so that lazily created builtins don't skew results
+	glslopt_shader_delete (glslopt_optimize (ctx, sh.type, sh.source.c_str(), 0));
+
+	std::vector<double> times (iterations);
+	size_t allocations = 0;
+	for (int i = 0; i < iterations; ++i)
+	{
+		const size_t alloc0 = s_Allocations;
+		const double t0 = GetTimeMs();
+		glslopt_shader* shader = glslopt_optimize (ctx, sh.type, sh.source.c_str(), 0);
+		sh.ok = glslopt_get_status (shader);
+		glslopt_shader_delete (shader);
+		times[i] = GetTimeMs() - t0;
+		allocations += s_Allocations - alloc0;
+	}
+	std::sort (times.begin(), times.end());
+	sh.medianMs = Percentile (times, 0.5);
+	sh.p95Ms = Percentile (times, 0.95);
+	sh.allocations = double(allocations) / iterations;
+}
+
+static void WriteJson (FILE* f, const BenchShaderVector& shaders, int iterations, long peakKB)
+{
+	fprintf (f, "{\n  \"iterations\": %d,\n  \"peak_memory_kb\": %ld,\n  \"allocation_counts\": %s,\n  \"targets\": [", iterations, peakKB, HAVE_ALLOCATION_COUNT ? "true" : "false");
+	for (int t = 0; t < kTargetCount; ++t)
+	{
+		int count = 0, failed = 0;
+		double sumMedian = 0.0, sumAllocs = 0.0;
+		for (size_t i = 0; i < shaders.size(); ++i)
+		{
+			if (shaders[i].target != t)
+				continue;
+			++count;
+			failed += !shaders[i].ok;
+			sumMedian += shaders[i].medianMs;
+			sumAllocs += shaders[i].allocations;
+		}
+		fprintf (f, "%s\n    { \"target\": \"%s\", \"shaders\": %d, \"failed\": %d, \"total_median_ms\": %.4f, \"shaders_per_sec\": %.1f, \"allocations_per_shader\": %.1f }",
+				 t ? "," : "", kTargetNames[t], count, failed, sumMedian,
+				 sumMedian > 0.0 ? count * 1000.0 / sumMedian : 0.0, count ? sumAllocs / count : 0.0);
+	}
+	fprintf (f, "\n  ],\n  \"shaders\": [");
+	for (size_t i = 0; i < shaders.size(); ++i)
+	{
+		const BenchShader& sh = shaders[i];
+		fprintf (f, "%s\n    { \"name\": \"%s\", \"target\": \"%s\", \"ok\": %s, \"median_ms\": %.4f, \"p95_ms\": %.4f, \"allocations\": %.1f }",
+				 i ? "," : "", sh.name.c_str(), kTargetNames[sh.target], sh.ok ? "true" : "false", sh.medianMs, sh.p95Ms, sh.allocations);
+	}
+	fprintf (f, "\n  ]\n}\n");
+}
+
+// ---- Generated shaders with many symbols
+
+static std::string MakeUniformsShader (int count)
+{
+	std::string src;
+	char buffer[256];
+	for (int i = 0; i < count; ++i)
+	{
+		snprintf (buffer, sizeof(buffer), "uniform mediump vec4 u_%d;\n", i);
+		src += buffer;
+	}
+	src += "varying mediump vec4 c;\nvoid main() {\n  mediump vec4 r = c;\n";
+	for (int i = 0; i < count; ++i)
+	{
+		snprintf (buffer, sizeof(buffer), "  r = r * u_%d + c;\n", i);
+		src += buffer;
+	}
+	src += "  gl_FragColor = r;\n}\n";
+	return src;
+}
+
+static std::string MakeMacrosShader (int count)
+{
+	std::string src;
+	char buffer[256];
+	for (int i = 0; i < count; ++i)
+	{
+		snprintf (buffer, sizeof(buffer), "#define M_%d(x) (x * %d.0)\n", i, i);
+		src += buffer;
+	}
+	src += "varying mediump vec4 c;\nvoid main() {\n  mediump vec4 r = c;\n";
+	for (int i = 0; i < count; ++i)
+	{
+		snprintf (buffer, sizeof(buffer), "  r = M_%d(r) + c;\n", i);
+		src += buffer;
+	}
+	src += "  gl_FragColor = r;\n}\n";
+	return src;
+}
+
+// Best time of each profile entry over all compiles, in profile order
+static void RunProfiled (glslopt_ctx* ctx, const char* title, const std::string& source, int iterations)
+{
+	std::vector<std::string> names;
+	std::vector<double> best;
+	for (int run = 0; run < iterations; ++run)
+	{
+		glslopt_shader* shader = glslopt_optimize (ctx, kGlslOptShaderFragment, source.c_str(), 0);
+		if (!glslopt_get_status (shader))
+		{
+			printf ("  %s: failed to compile\n%s\n", title, glslopt_get_log (shader));
+			glslopt_shader_delete (shader);
+			return;
+		}
+		const int count = glslopt_shader_get_profile_count (shader);
+		for (int i = 0; i < count; ++i)
+		{
+			const char* name;
+			double ms;
+			int invocations, progress;
+			glslopt_shader_get_profile (shader, i, &name, &ms, &invocations, &progress);
+			if (run == 0)
+			{
+				names.push_back (name);
+				best.push_back (ms);
+			}
+			else if (i < (int)best.size())
+				best[i] = std::min (best[i], ms);
+		}
+		glslopt_shader_delete (shader);
+	}
+	printf ("\n%s (best of %i, entries over 0.5 ms):\n", title, iterations);
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		if (best[i] >= 0.5)
+			printf ("  %-28s %8.2f ms\n", names[i].c_str(), best[i]);
+	}
+}
+
+static void RunSymbols (int count, int iterations)
+{
+	glslopt_ctx* ctx = glslopt_initialize (kGlslTargetOpenGLES20);
+	glslopt_set_profiling (ctx, true);
+	char title[100];
+	snprintf (title, sizeof(title), "%i uniforms", count);
+	RunProfiled (ctx, title, MakeUniformsShader (count), iterations);
+	snprintf (title, sizeof(title), "%i macros", count);
+	RunProfiled (ctx, title, MakeMacrosShader (count), iterations);
+	glslopt_cleanup (ctx);
+}
+
+
+static int PrintHelp ()
+{
+	printf ("USAGE: glsl_benchmark testfolder [-n iterations] [-json output.json] [-symbols count]\n");
+	printf ("\t-n : compiles of each shader per target (default 5)\n");
+	printf ("\t-json : also write results as JSON\n");
+	printf ("\t-symbols : also time shaders with this many uniforms, and macros\n");
+	return 1;
+}
+
+static bool CompareMedian (const BenchShader* a, const BenchShader* b)
+{
+	return a->medianMs > b->medianMs;
+}
+
+int main (int argc, const char** argv)
+{
+	const char* baseFolder = NULL;
+	const char* jsonPath = NULL;
+	int iterations = 5;
+	int symbols = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (0 == strcmp (argv[i], "-n") && i+1 < argc)
+			iterations = atoi (argv[++i]);
+		else if (0 == strcmp (argv[i], "-json") && i+1 < argc)
+			jsonPath = argv[++i];
+		else if (0 == strcmp (argv[i], "-symbols") && i+1 < argc)
+			symbols = atoi (argv[++i]);
+		else if (argv[i][0] != '-' && !baseFolder)
+			baseFolder = argv[i];
+		else
+			return PrintHelp ();
+	}
+	if (!baseFolder || iterations < 1)
+		return PrintHelp ();
+
+	BenchShaderVector shaders;
+	LoadCorpus (baseFolder, shaders);
+	if (shaders.empty())
+	{
+		printf ("No shaders found in %s\n", baseFolder);
+		return 1;
+	}
+
+	glslopt_ctx* ctx[kTargetCount];
+	for (int t = 0; t < kTargetCount; ++t)
+		ctx[t] = glslopt_initialize (kTargets[t]);
+
+	printf ("%i shaders, %i compiles each\n\n", (int)shaders.size(), iterations);
+	printf ("%-6s %8s %7s %12s %12s %14s\n", "target", "shaders", "failed", "median ms", "shaders/s", "allocs/shader");
+	int totalCount = 0;
+	double totalMedian = 0.0;
+	for (int t = 0; t < kTargetCount; ++t)
+	{
+		int count = 0, failed = 0;
+		double sumMedian = 0.0, sumAllocs = 0.0;
+		for (size_t i = 0; i < shaders.size(); ++i)
+		{
+			BenchShader& sh = shaders[i];
+			if (sh.target != t)
+				continue;
+			RunShader (ctx[t], sh, iterations);
+			++count;
+			failed += !sh.ok;
+			sumMedian += sh.medianMs;
+			sumAllocs += sh.allocations;
+		}
+		totalCount += count;
+		totalMedian += sumMedian;
+		if (!count)
+			continue;
+		printf ("%-6s %8i %7i %12.2f %12.1f", kTargetNames[t], count, failed, sumMedian, sumMedian > 0.0 ? count * 1000.0 / sumMedian : 0.0);
+		if (HAVE_ALLOCATION_COUNT)
+			printf (" %14.0f\n", sumAllocs / count);
+		else
+			printf (" %14s\n", "n/a");
+	}
+	const long peakKB = GetPeakMemoryKB ();
+	printf ("%-6s %8i %7s %12.2f %12.1f\n", "total", totalCount, "", totalMedian, totalMedian > 0.0 ? totalCount * 1000.0 / totalMedian : 0.0);
+	printf ("\npeak memory: %ld KB\n", peakKB);
+
+	std::vector<const BenchShader*> slowest;
+	for (size_t i = 0; i < shaders.size(); ++i)
+		slowest.push_back (&shaders[i]);
+	std::sort (slowest.begin(), slowest.end(), CompareMedian);
+	printf ("\nslowest shaders (median / p95 ms):\n");
+	for (size_t i = 0; i < slowest.size() && i < 10; ++i)
+		printf ("  %8.3f %8.3f  %s (%s)\n", slowest[i]->medianMs, slowest[i]->p95Ms, slowest[i]->name.c_str(), kTargetNames[slowest[i]->target]);
+
+	if (jsonPath)
+	{
+		FILE* f = fopen (jsonPath, "wb");
+		if (!f)
+		{
+			printf ("Failed to open %s for writing\n", jsonPath);
+			return 1;
+		}
+		WriteJson (f, shaders, iterations, peakKB);
+		fclose (f);
+	}
+
+	if (symbols > 0)
+		RunSymbols (symbols, iterations);
+
+	for (int t = 0; t < kTargetCount; ++t)
+		glslopt_cleanup (ctx[t]);
+	return 0;
+}
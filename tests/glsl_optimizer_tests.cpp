@@ -1,7 +1,12 @@
+#include <algorithm>
 #include <string>
 #include <vector>
+#include <ctype.h>
 #include <time.h>
+#include <math.h>
 #include "../src/glsl/glsl_optimizer.h"
+#include "../src/mesa/program/hash_table.h"
+#include "../include/c11/threads.h"
 
 #define GL_GLEXT_PROTOTYPES 1
 
@@ -70,6 +75,7 @@ static bool s_GL3Active = false;
 
 #ifndef _MSC_VER
 #include <unistd.h>
+#include <sys/stat.h>
 #endif
 
 
@@ -419,6 +425,48 @@ static void DeleteFile (const std::string& path)
 	#endif
 }
 
+static void MakeDirectory (const std::string& path)
+{
+	#ifdef _MSC_VER
+	CreateDirectoryA (path.c_str(), NULL);
+	#else
+	mkdir (path.c_str(), 0777);
+	#endif
+}
+
+static void RemoveDirectory (const std::string& path)
+{
+	#ifdef _MSC_VER
+	RemoveDirectoryA (path.c_str());
+	#else
+	rmdir (path.c_str());
+	#endif
+}
+
+static bool ReadBinaryFile (const std::string& path, std::string& output)
+{
+	FILE* file = fopen (path.c_str(), "rb");
+	if (file == NULL)
+		return false;
+	char buffer[4096];
+	size_t readLength;
+	output.clear();
+	while ((readLength = fread (buffer, 1, sizeof(buffer), file)) > 0)
+		output.append (buffer, readLength);
+	fclose (file);
+	return true;
+}
+
+static bool WriteBinaryFile (const std::string& path, const std::string& data)
+{
+	FILE* file = fopen (path.c_str(), "wb");
+	if (file == NULL)
+		return false;
+	const bool ok = fwrite (data.data(), 1, data.size(), file) == data.size();
+	fclose (file);
+	return ok;
+}
+
 static void MassageVertexForGLES (std::string& s)
 {
 	if (s.find ("_glesVertex") != std::string::npos)
@@ -472,6 +520,19 @@ static const char* kGlslPrecNames[kGlslPrecCount] = {
 };
 
 
+// When not NULL, compile profiles of all tests get written here as a JSON array
+static FILE* s_ProfileFile = NULL;
+static int s_ProfileCount = 0;
+
+static void WriteProfile (const std::string& outputPath, glslopt_shader* shader)
+{
+	const char* json = glslopt_shader_get_profile_json (shader);
+	if (!s_ProfileFile || !json)
+		return;
+	fprintf (s_ProfileFile, "%s{ \"test\": \"%s\", \"profile\": %s }", s_ProfileCount ? ",\n" : "", outputPath.c_str(), json);
+	++s_ProfileCount;
+}
+
 static bool TestFile (glslopt_ctx* ctx, bool vertex,
 	const std::string& testName,
 	const std::string& inputPath,
@@ -504,6 +565,7 @@ static bool TestFile (glslopt_ctx* ctx, bool vertex,
 
 	glslopt_shader_type type = vertex ? kGlslOptShaderVertex : kGlslOptShaderFragment;
 	glslopt_shader* shader = glslopt_optimize (ctx, type, input.c_str(), 0);
+	WriteProfile (outputPath, shader);
 
 	bool optimizeOk = glslopt_get_status(shader);
 	if (optimizeOk)
@@ -623,11 +685,907 @@ static bool TestFile (glslopt_ctx* ctx, bool vertex,
 }
 
 
+// ---- Multi-threaded stress test: compile the whole corpus from several
+// threads at once, and check results match a single threaded run.
+
+static const int kThreadedTestThreads = 4;
+static const int kThreadedTestTargets = 4;
+static const glslopt_target kThreadedTestTarget[kThreadedTestTargets] = {
+	kGlslTargetOpenGLES20, kGlslTargetOpenGLES30, kGlslTargetOpenGL, kGlslTargetMetal,
+};
+
+struct ThreadedJob
+{
+	int target;
+	glslopt_shader_type type;
+	std::string name;
+	std::string source;
+	std::string expected;
+};
+typedef std::vector<ThreadedJob> ThreadedJobVector;
+
+struct ThreadedWorker
+{
+	ThreadedJobVector* jobs;
+	glslopt_ctx** sharedCtx; // NULL: create own contexts
+	size_t start;
+	int mismatches;
+};
+
+static std::string GetThreadedTestResult (glslopt_shader* shader)
+{
+	std::string res;
+	if (glslopt_get_status (shader))
+	{
+		res = glslopt_get_raw_output (shader);
+		res += glslopt_get_output (shader);
+	}
+	else
+	{
+		res = "ERROR: ";
+		res += glslopt_get_log (shader);
+	}
+	glslopt_shader_delete (shader);
+	return res;
+}
+
+static std::string CompileForThreadedTest (glslopt_ctx* ctx, const ThreadedJob& job)
+{
+	return GetThreadedTestResult (glslopt_optimize (ctx, job.type, job.source.c_str(), 0));
+}
+
+static int ThreadedWorkerMain (void* data)
+{
+	ThreadedWorker* worker = (ThreadedWorker*)data;
+	glslopt_ctx* ownCtx[kThreadedTestTargets];
+	glslopt_ctx** ctx = worker->sharedCtx;
+	if (!ctx)
+	{
+		for (int i = 0; i < kThreadedTestTargets; ++i)
+			ownCtx[i] = glslopt_initialize (kThreadedTestTarget[i]);
+		ctx = ownCtx;
+	}
+
+	// each thread starts at a different spot in the job list, so that
+	// different shaders are in flight at the same time
+	const ThreadedJobVector& jobs = *worker->jobs;
+	const size_t n = jobs.size();
+	for (size_t i = 0; i < n; ++i)
+	{
+		const ThreadedJob& job = jobs[(worker->start + i) % n];
+		if (CompileForThreadedTest (ctx[job.target], job) != job.expected)
+		{
+			printf ("\n  %s: threaded result does not match single threaded one\n", job.name.c_str());
+			++worker->mismatches;
+		}
+	}
+
+	if (!worker->sharedCtx)
+	{
+		for (int i = 0; i < kThreadedTestTargets; ++i)
+			glslopt_cleanup (ownCtx[i]);
+	}
+	return 0;
+}
+
+static int RunThreadedWorkers (ThreadedJobVector& jobs, glslopt_ctx** sharedCtx)
+{
+	thrd_t threads[kThreadedTestThreads];
+	ThreadedWorker workers[kThreadedTestThreads];
+	for (int i = 0; i < kThreadedTestThreads; ++i)
+	{
+		workers[i].jobs = &jobs;
+		workers[i].sharedCtx = sharedCtx;
+		workers[i].start = jobs.size() * i / kThreadedTestThreads;
+		workers[i].mismatches = 0;
+		if (thrd_create (&threads[i], ThreadedWorkerMain, &workers[i]) != thrd_success)
+		{
+			printf ("\n  failed to create test thread\n");
+			return 1;
+		}
+	}
+	int mismatches = 0;
+	for (int i = 0; i < kThreadedTestThreads; ++i)
+	{
+		thrd_join (threads[i], NULL);
+		mismatches += workers[i].mismatches;
+	}
+	return mismatches;
+}
+
+static int RunBatch (ThreadedJobVector& jobs, glslopt_ctx** ctx)
+{
+	int mismatches = 0;
+	for (int target = 0; target < kThreadedTestTargets; ++target)
+	{
+		std::vector<glslopt_job> batch;
+		std::vector<const ThreadedJob*> batchJobs;
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			if (jobs[i].target != target)
+				continue;
+			glslopt_job job;
+			job.type = jobs[i].type;
+			job.shaderSource = jobs[i].source.c_str();
+			job.options = 0;
+			batch.push_back (job);
+			batchJobs.push_back (&jobs[i]);
+		}
+		if (batch.empty())
+			continue;
+
+		std::vector<glslopt_shader*> shaders (batch.size());
+		glslopt_optimize_batch (ctx[target], &batch[0], (int)batch.size(), &shaders[0], kThreadedTestThreads);
+		for (size_t i = 0; i < shaders.size(); ++i)
+		{
+			if (GetThreadedTestResult (shaders[i]) != batchJobs[i]->expected)
+			{
+				printf ("\n  %s: batch result does not match single threaded one\n", batchJobs[i]->name.c_str());
+				++mismatches;
+			}
+		}
+	}
+	return mismatches;
+}
+
+// Compiles slices of one buffer holding all sources back to back, without
+// terminators in between, like a memory-mapped shader pack.
+static int RunPack (ThreadedJobVector& jobs, glslopt_ctx** ctx)
+{
+	std::vector<size_t> offsets;
+	std::string packed;
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		offsets.push_back (packed.size());
+		packed += jobs[i].source;
+	}
+	std::vector<char> pack (packed.begin(), packed.end());
+
+	int mismatches = 0;
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		const ThreadedJob& job = jobs[i];
+		glslopt_shader* shader = glslopt_optimize_n (ctx[job.target], job.type, &pack[offsets[i]], job.source.size(), 0);
+		if (GetThreadedTestResult (shader) != job.expected)
+		{
+			printf ("\n  %s: result from a shader pack slice does not match\n", job.name.c_str());
+			++mismatches;
+		}
+	}
+	return mismatches;
+}
+
+// Compiles each shader as variants of itself: defines that it does not use
+// must not change anything. Then checks a small uber-shader against pasting
+// the defines in front of it.
+static int RunVariants (ThreadedJobVector& jobs, glslopt_ctx** ctx)
+{
+	static const char* kUnusedDefines[3] = { NULL, "", "#define GLSLOPT_UNUSED 1\n" };
+	int mismatches = 0;
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		const ThreadedJob& job = jobs[i];
+		glslopt_shader* shaders[3];
+		glslopt_optimize_variants (ctx[job.target], job.type, job.source.c_str(), job.source.size(), kUnusedDefines, 3, 0, shaders, kThreadedTestThreads);
+		for (int j = 0; j < 3; ++j)
+		{
+			if (GetThreadedTestResult (shaders[j]) != job.expected)
+			{
+				printf ("\n  %s: variant %i does not match single threaded result\n", job.name.c_str(), j);
+				++mismatches;
+			}
+		}
+	}
+
+	static const char* kUberShader =
+		"uniform sampler2D tex;\n"
+		"varying highp vec2 uv;\n"
+		"#if defined(FOG) && FOG_MODE == 2\n"
+		"varying highp float fog;\n"
+		"#endif\n"
+		"void main() {\n"
+		"  lowp vec4 c = texture2D (tex, uv);\n"
+		"#ifdef TINT\n"
+		"  c *= TINT;\n"
+		"#endif\n"
+		"#if defined(FOG) && FOG_MODE == 2\n"
+		"  c.rgb = mix (c.rgb, vec3(0.5), fog);\n"
+		"#elif defined(FOG)\n"
+		"  c.rgb *= 0.5;\n"
+		"#endif\n"
+		"  gl_FragColor = c;\n"
+		"}\n";
+	static const char* kUberDefines[4] = {
+		NULL,
+		"#define TINT vec4(1.0,0.5,0.5,1.0)\n",
+		"#define FOG\n#define FOG_MODE 2\n",
+		"#define FOG\n#define FOG_MODE 1\n#define TINT 2.0\n",
+	};
+	glslopt_shader* shaders[4];
+	glslopt_optimize_variants (ctx[0], kGlslOptShaderFragment, kUberShader, strlen (kUberShader), kUberDefines, 4, 0, shaders, kThreadedTestThreads);
+	for (int j = 0; j < 4; ++j)
+	{
+		std::string source = kUberDefines[j] ? kUberDefines[j] : "";
+		source += kUberShader;
+		if (GetThreadedTestResult (shaders[j]) != GetThreadedTestResult (glslopt_optimize (ctx[0], kGlslOptShaderFragment, source.c_str(), 0)))
+		{
+			printf ("\n  uber-shader variant %i does not match pasted defines\n", j);
+			++mismatches;
+		}
+	}
+	return mismatches;
+}
+
+// The source with defines pasted in front, after #version if there is one;
+// outLineShift gets how many lines that moved the source down
+static std::string PasteDefines (const std::string& source, const char* defines, int* outLineShift)
+{
+	*outLineShift = 0;
+	if (!defines)
+		return source;
+	for (const char* d = defines; *d; ++d)
+		*outLineShift += *d == '\n';
+	if (source.compare (0, 8, "#version") == 0)
+	{
+		const size_t eol = source.find ('\n');
+		if (eol != std::string::npos)
+			return source.substr (0, eol + 1) + defines + source.substr (eol + 1);
+	}
+	return defines + source;
+}
+
+// Moves line numbers in a compile log ("0:line(column)" from the
+// preprocessor, "(line,column)" from the compiler) up by shift lines, or
+// removes them
+static std::string AdjustLogLines (const std::string& log, int shift, bool remove)
+{
+	std::string res;
+	size_t pos = 0;
+	while (pos < log.size())
+	{
+		size_t eol = log.find ('\n', pos);
+		if (eol == std::string::npos)
+			eol = log.size() - 1;
+		std::string line = log.substr (pos, eol + 1 - pos);
+		pos = eol + 1;
+		const size_t start = line.compare (0, 7, "ERROR: ") == 0 ? 7 : 0;
+		const size_t number = line.compare (start, 2, "0:") == 0 ? start + 2 : line.compare (start, 1, "(") == 0 ? start + 1 : std::string::npos;
+		if (number != std::string::npos && isdigit (line[number]))
+		{
+			size_t end = number;
+			while (end < line.size() && isdigit (line[end]))
+				++end;
+			char buffer[20];
+			sprintf (buffer, "%i", atoi (line.c_str() + number) - shift);
+			line.replace (number, end - number, remove ? "" : buffer);
+		}
+		res += line;
+	}
+	return res;
+}
+
+// Names tested by #ifdef, #ifndef, #if, #elif and defined() in a source
+static StringVector GetConditionNames (const std::string& source)
+{
+	static const char* kKeywords[] = { "#ifdef", "#ifndef", "#if", "#elif", "defined" };
+	StringVector names;
+	for (size_t i = 0; i < sizeof(kKeywords)/sizeof(kKeywords[0]); ++i)
+	{
+		const size_t length = strlen (kKeywords[i]);
+		for (size_t pos = source.find (kKeywords[i]); pos != std::string::npos; pos = source.find (kKeywords[i], pos + length))
+		{
+			size_t start = pos + length;
+			while (start < source.size() && (source[start] == ' ' || source[start] == '('))
+				++start;
+			size_t end = start;
+			while (end < source.size() && (isalnum (source[end]) || source[end] == '_'))
+				++end;
+			if (end == start || isdigit (source[start]))
+				continue;
+			const std::string name = source.substr (start, end - start);
+			if (name.compare (0, 3, "GL_") == 0 || name.compare (0, 2, "__") == 0 || name == "defined")
+				continue;
+			if (std::find (names.begin(), names.end(), name) == names.end())
+				names.push_back (name);
+		}
+	}
+	return names;
+}
+
+// Compiles variants of a source, and each of them again with glslopt_optimize
+// on the source with its defines pasted in; counts results that differ, other
+// than by the lines the pasted defines take up
+static int CompareVariants (glslopt_ctx* ctx, glslopt_shader_type type, const std::string& name, const std::string& source, const StringVector& defineSets)
+{
+	std::vector<const char*> defines;
+	for (size_t i = 0; i < defineSets.size(); ++i)
+		defines.push_back (defineSets[i].empty() ? NULL : defineSets[i].c_str());
+	std::vector<glslopt_shader*> shaders (defines.size());
+	glslopt_optimize_variants (ctx, type, source.c_str(), source.size(), &defines[0], (int)defines.size(), 0, &shaders[0], kThreadedTestThreads);
+
+	// past a #line, the pasted defines don't move line numbers any more
+	const bool hasLine = source.find ("#line") != std::string::npos;
+	int mismatches = 0;
+	for (size_t i = 0; i < defines.size(); ++i)
+	{
+		int lineShift;
+		const std::string pasted = PasteDefines (source, defines[i], &lineShift);
+		const std::string expected = AdjustLogLines (GetThreadedTestResult (glslopt_optimize (ctx, type, pasted.c_str(), 0)), lineShift, hasLine);
+		const std::string result = AdjustLogLines (GetThreadedTestResult (shaders[i]), 0, hasLine);
+		if (result != expected)
+		{
+			printf ("\n  %s: variant with defines\n%s  does not match pasted defines:\n%s\n  instead of\n%s\n", name.c_str(), defineSets[i].c_str(), result.c_str(), expected.c_str());
+			++mismatches;
+		}
+	}
+	return mismatches;
+}
+
+// Differential test of glslopt_optimize_variants against plain glslopt_optimize:
+// the test shaders with the names they test for defined, and generated sources
+// full of preprocessor directives
+static int RunVariantsDifferential (ThreadedJobVector& jobs, glslopt_ctx** ctx)
+{
+	int mismatches = 0;
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		const ThreadedJob& job = jobs[i];
+		const StringVector names = GetConditionNames (job.source);
+		StringVector defineSets;
+		defineSets.push_back ("");
+		defineSets.push_back ("#define FOO 1\n#define BAR(x) (x)\n");
+		std::string all;
+		for (size_t j = 0; j < names.size(); ++j)
+		{
+			if (j < 4)
+				defineSets.push_back ("#define " + names[j] + " 1\n");
+			all += "#define " + names[j] + " 2\n";
+		}
+		if (!all.empty())
+			defineSets.push_back (all);
+		mismatches += CompareVariants (ctx[job.target], job.type, job.name, job.source, defineSets);
+	}
+
+	static const char* kPieces[] = {
+		"#define A 1\n",
+		"#define B(x) ((x) + float(A))\n",
+		"#define C\n",
+		"#  define   D   \\\n  3.0\n",
+		"#undef A\n",
+		"#undef C\n",
+		"#ifdef A\n",
+		"#ifndef C\n",
+		"#if defined(A) && A > 0\n",
+		"#if D > 2.0\n",
+		"#elif defined C\n",
+		"#else\n",
+		"#endif\n",
+		"  c += vec4(B(1.0));\n",
+		"  c *= float(A);\n",
+		"  c.x += float(__LINE__);\n",
+		"  c.y = D;\n",
+		"#line 20\n",
+		"/* a comment\n   over lines */\n",
+		"  c = c // trailing comment\n    * 2.0;\n",
+		"#pragma optimize(off)\n",
+		"  c.z = 1.0;\n",
+		"#error stop\n",
+	};
+	const int pieceCount = sizeof(kPieces)/sizeof(kPieces[0]);
+	StringVector defineSets;
+	defineSets.push_back ("");
+	defineSets.push_back ("#define A 2\n");
+	defineSets.push_back ("#define C 1\n#define D 1.0\n");
+	defineSets.push_back ("#define B(x) (x)\n");
+	unsigned seed = 1;
+	for (int i = 0; i < 200; ++i)
+	{
+		std::string source = "void main() {\n  mediump vec4 c = vec4(0.0);\n";
+		const int count = 4 + i % 12;
+		for (int j = 0; j < count; ++j)
+		{
+			seed = seed * 1103515245 + 12345;
+			source += kPieces[(seed >> 16) % pieceCount];
+		}
+		source += "  gl_FragColor = c;\n}\n";
+		char name[100];
+		sprintf (name, "generated source %i", i);
+		mismatches += CompareVariants (ctx[i % 2], kGlslOptShaderFragment, name, source, defineSets);
+	}
+	return mismatches;
+}
+
+static int RunPrelude (glslopt_ctx* ctx)
+{
+	static const char* kPrelude =
+		"#define SATURATE(x) clamp (x, 0.0, 1.0)\n"
+		"#define GAMMA 2.2\n"
+		"struct Light { mediump vec3 dir; lowp vec3 color; };\n"
+		"uniform Light light;\n"
+		"uniform mediump float exposure;\n"
+		"mediump vec3 shade (mediump vec3 n) {\n"
+		"  return light.color * SATURATE (dot (n, light.dir)) * exposure;\n"
+		"}\n";
+	struct PreludeShader { glslopt_shader_type type; const char* defines; const char* source; };
+	static const PreludeShader kShaders[] = {
+		{ kGlslOptShaderVertex, NULL,
+			"attribute highp vec4 pos;\n"
+			"attribute mediump vec3 nrm;\n"
+			"varying lowp vec3 col;\n"
+			"void main() { gl_Position = pos; col = shade (nrm); }\n" },
+		{ kGlslOptShaderFragment, NULL,
+			"varying mediump vec3 n;\n"
+			"void main() { gl_FragColor = vec4 (pow (shade (normalize (n)), vec3 (1.0 / GAMMA)), 1.0); }\n" },
+		{ kGlslOptShaderFragment, "#define GAMMA_OFF\n#undef GAMMA\n#define GAMMA 1.0\n",
+			"varying mediump vec3 n;\n"
+			"void main() { gl_FragColor = vec4 (pow (shade (n), vec3 (1.0 / GAMMA)), 1.0); }\n" },
+		// errors, with line numbers counting from the shader's first line
+		{ kGlslOptShaderFragment, NULL,
+			"void main() {\n"
+			"  gl_FragColor = vec4 (shade (missing), 1.0);\n"
+			"}\n" },
+		// changes the extensions the prelude was compiled with
+		{ kGlslOptShaderFragment, NULL,
+			"#extension GL_OES_standard_derivatives : enable\n"
+			"varying mediump vec3 n;\n"
+			"void main() { gl_FragColor = vec4 (shade (dFdx (n)), 1.0); }\n" },
+	};
+	const int count = sizeof(kShaders) / sizeof(kShaders[0]);
+
+	std::string expected[count];
+	for (int i = 0; i < count; ++i)
+	{
+		std::string source = kPrelude;
+		if (kShaders[i].defines)
+			source += kShaders[i].defines;
+		source += "#line 0\n";
+		source += kShaders[i].source;
+		expected[i] = GetThreadedTestResult (glslopt_optimize (ctx, kShaders[i].type, source.c_str(), 0));
+	}
+
+	int mismatches = 0;
+	glslopt_set_prelude (ctx, kPrelude);
+	for (int i = 0; i < count; ++i)
+	{
+		glslopt_shader* shader;
+		if (kShaders[i].defines)
+			glslopt_optimize_variants (ctx, kShaders[i].type, kShaders[i].source, strlen (kShaders[i].source), &kShaders[i].defines, 1, 0, &shader, 1);
+		else
+			shader = glslopt_optimize (ctx, kShaders[i].type, kShaders[i].source, 0);
+		if (GetThreadedTestResult (shader) != expected[i])
+		{
+			printf ("\n  prelude shader %i does not match pasted prelude\n", i);
+			++mismatches;
+		}
+	}
+	glslopt_set_prelude (ctx, NULL);
+	return mismatches;
+}
+
+// Names and types of a shader's inputs, uniforms and textures, as text
+static std::string GetReflection (glslopt_shader* shader)
+{
+	typedef void (*GetDescFunc) (glslopt_shader*, int, const char**, glslopt_basic_type*, glslopt_precision*, int*, int*, int*, int*);
+	const int counts[3] = { glslopt_shader_get_input_count (shader), glslopt_shader_get_uniform_count (shader), glslopt_shader_get_texture_count (shader) };
+	const GetDescFunc getDesc[3] = { glslopt_shader_get_input_desc, glslopt_shader_get_uniform_desc, glslopt_shader_get_texture_desc };
+	std::string res;
+	char buffer[1000];
+	for (int kind = 0; kind < 3; ++kind)
+	{
+		sprintf (buffer, "%i:", counts[kind]);
+		res += buffer;
+		for (int i = 0; i < counts[kind]; ++i)
+		{
+			const char* parName;
+			glslopt_basic_type parType;
+			glslopt_precision parPrec;
+			int parVecSize, parMatSize, parArrSize, location;
+			getDesc[kind] (shader, i, &parName, &parType, &parPrec, &parVecSize, &parMatSize, &parArrSize, &location);
+			sprintf (buffer, " %s (%s %s) %ix%i [%i] loc %i;", parName, kGlslPrecNames[parPrec], kGlslTypeNames[parType], parVecSize, parMatSize, parArrSize, location);
+			res += buffer;
+		}
+		res += "\n";
+	}
+	return res;
+}
+
+// prog_hash_table, which the front end's symbol tables use: a key inserted
+// again shadows the earlier element until that one is removed, elements can
+// be removed while iterating, and all of it holds across the table growing.
+// Run with the pointer hash and with a hash that collides a lot.
+
+static void* HashTestKey (int i) { return (void*)(uintptr_t)((i + 1) * 16); }
+static int HashTestIndex (const void* key) { return (int)((uintptr_t)key / 16) - 1; }
+static void* HashTestValue (int i, int version) { return (void*)(uintptr_t)((i * 2 + version + 1) * 8); }
+static unsigned HashTestWeakHash (const void* key) { return (unsigned)((uintptr_t)key / 16 % 7); }
+
+struct HashTestForeach
+{
+	hash_table* ht;
+	int visited;
+	int removed;
+};
+
+// removes the elements with odd indices
+static void HashTestRemoveOdd (const void* key, void* data, void* closure)
+{
+	HashTestForeach* state = (HashTestForeach*)closure;
+	++state->visited;
+	if (HashTestIndex (key) & 1)
+	{
+		hash_table_remove (state->ht, key);
+		++state->removed;
+	}
+}
+
+static int CheckHashTable (hash_table* ht, int count, const char* stage, void* (*expected) (int))
+{
+	for (int i = 0; i < count; ++i)
+	{
+		void* found = hash_table_find (ht, HashTestKey (i));
+		if (found != expected (i))
+		{
+			printf ("\n  hash table: after %s, key %i has %p, expected %p\n", stage, i, found, expected (i));
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void* ExpectShadowed (int i) { return HashTestValue (i, i % 3 == 0 ? 1 : 0); }
+static void* ExpectRemoved (int i) { return i % 5 == 1 ? NULL : HashTestValue (i, 0); }
+static void* ExpectForeachRemoved (int i) { return (i % 5 == 1 || (i & 1)) ? NULL : HashTestValue (i, 0); }
+
+static bool TestProgHashTable ()
+{
+	printf ("\n** running hash table tests...\n");
+	int failures = 0;
+	for (int weak = 0; weak < 2; ++weak)
+	{
+		const int count = weak ? 1000 : 20000;
+		hash_table* ht = hash_table_ctor (0, weak ? HashTestWeakHash : hash_table_pointer_hash, hash_table_pointer_compare);
+
+		// growth from empty, and every third key inserted again
+		for (int i = 0; i < count; ++i)
+			hash_table_insert (ht, HashTestValue (i, 0), HashTestKey (i));
+		for (int i = 0; i < count; i += 3)
+			hash_table_insert (ht, HashTestValue (i, 1), HashTestKey (i));
+		failures += CheckHashTable (ht, count, "inserts", ExpectShadowed);
+
+		// removing the second insert uncovers the first; removing that the key
+		for (int i = 0; i < count; i += 3)
+			hash_table_remove (ht, HashTestKey (i));
+		for (int i = 1; i < count; i += 5)
+			hash_table_remove (ht, HashTestKey (i));
+		failures += CheckHashTable (ht, count, "removes", ExpectRemoved);
+
+		HashTestForeach state = { ht, 0, 0 };
+		hash_table_call_foreach (ht, HashTestRemoveOdd, &state);
+		const int remaining = count - (count + 3) / 5;
+		int odd = 0;
+		for (int i = 0; i < count; ++i)
+			odd += (i & 1) && i % 5 != 1;
+		if (state.visited != remaining || state.removed != odd)
+		{
+			printf ("\n  hash table: foreach visited %i and removed %i, expected %i and %i\n", state.visited, state.removed, remaining, odd);
+			++failures;
+		}
+		failures += CheckHashTable (ht, count, "removes in foreach", ExpectForeachRemoved);
+
+		hash_table_dtor (ht);
+	}
+	return failures == 0;
+}
+
+// Cost estimates of a few small shaders on every target: a plain fetch, a
+// dependent fetch under a branch, and a loop of unknown trip count
+static bool TestCost ()
+{
+	static const char* kPrefix[kThreadedTestTargets] = {
+		"",
+		"#version 300 es\n#define varying in\n#define texture2D texture\n#define gl_FragColor fragColor\nout mediump vec4 fragColor;\n",
+		"#version 130\n",
+		"#version 300 es\n#define varying in\n#define texture2D texture\n#define gl_FragColor fragColor\nout mediump vec4 fragColor;\n",
+	};
+	static const char* kShaders[] = {
+		"uniform sampler2D tex;\n"
+		"uniform mediump vec4 tint;\n"
+		"varying highp vec2 uv;\n"
+		"void main() {\n"
+		"  gl_FragColor = texture2D (tex, uv) * tint;\n"
+		"}\n",
+
+		"uniform sampler2D tex;\n"
+		"uniform sampler2D ramp;\n"
+		"varying highp vec2 uv;\n"
+		"void main() {\n"
+		"  lowp vec4 c = texture2D (tex, uv);\n"
+		"  if (c.w > 0.5)\n"
+		"    c = texture2D (ramp, c.xy);\n"
+		"  else\n"
+		"    c.xyz = sqrt (c.xyz);\n"
+		"  gl_FragColor = c;\n"
+		"}\n",
+
+		"uniform sampler2D tex;\n"
+		"uniform highp vec4 offsets[16];\n"
+		"uniform int count;\n"
+		"varying highp vec2 uv;\n"
+		"void main() {\n"
+		"  mediump vec4 sum = vec4(0.0);\n"
+		"  for (int i = 0; i < count; ++i)\n"
+		"    sum += texture2D (tex, uv + offsets[i].xy);\n"
+		"  gl_FragColor = sum;\n"
+		"}\n",
+	};
+	struct ExpectedCost {
+		int shader, target;
+		float cycles, alu, tex, flow;
+		int fetches, dependent, depth, liveComponents, liveVec4s;
+	};
+	static const ExpectedCost kExpected[] = {
+		{ 0, 0, 8.5f, 0.5f, 8, 0, 1, 0, 1, 4, 1 },
+		{ 0, 1, 6, 2, 4, 0, 1, 0, 1, 4, 1 },
+		{ 0, 2, 8, 4, 4, 0, 1, 0, 1, 4, 1 },
+		{ 0, 3, 6, 2, 4, 0, 1, 0, 1, 4, 1 },
+		{ 1, 0, 28.5f, 0.5f, 24, 4, 2, 1, 2, 7, 2 },
+		{ 1, 1, 12.5f, 6.5f, 4, 2, 1, 0, 2, 7, 2 },
+		{ 1, 2, 19, 13, 4, 2, 1, 0, 2, 7, 2 },
+		{ 1, 3, 11.5f, 6.5f, 4, 1, 1, 0, 2, 7, 2 },
+		{ 2, 0, 252, 28, 128, 96, 8, 8, 1, 9, 3 },
+		{ 2, 1, 144, 48, 48, 48, 8, 8, 1, 9, 3 },
+		{ 2, 2, 144, 64, 32, 48, 8, 8, 1, 9, 3 },
+		{ 2, 3, 112, 48, 40, 24, 8, 8, 1, 9, 3 },
+	};
+
+	printf ("\n** running cost tests...\n");
+	int failures = 0;
+	glslopt_ctx* ctx[kThreadedTestTargets];
+	for (int i = 0; i < kThreadedTestTargets; ++i)
+		ctx[i] = glslopt_initialize (kThreadedTestTarget[i]);
+	for (size_t i = 0; i < sizeof(kExpected)/sizeof(kExpected[0]); ++i)
+	{
+		const ExpectedCost& e = kExpected[i];
+		const std::string source = std::string(kPrefix[e.target]) + kShaders[e.shader];
+		glslopt_shader* shader = glslopt_optimize (ctx[e.target], kGlslOptShaderFragment, source.c_str(), 0);
+		if (!glslopt_get_status (shader))
+		{
+			printf ("\n  cost: shader %i on target %i failed to compile: %s\n", e.shader, e.target, glslopt_get_log (shader));
+			++failures;
+			glslopt_shader_delete (shader);
+			continue;
+		}
+		glslopt_shader_cost cost;
+		glslopt_shader_get_cost (shader, &cost);
+		glslopt_shader_delete (shader);
+		if (fabsf (cost.cycles - e.cycles) > 0.01f || fabsf (cost.aluCycles - e.alu) > 0.01f ||
+			fabsf (cost.textureCycles - e.tex) > 0.01f || fabsf (cost.flowCycles - e.flow) > 0.01f ||
+			cost.textureFetches != e.fetches || cost.dependentFetches != e.dependent || cost.textureDepth != e.depth ||
+			cost.liveComponents != e.liveComponents || cost.liveVec4s != e.liveVec4s)
+		{
+			printf ("\n  cost: shader %i on target %i: got %g (alu %g tex %g flow %g) fetches %i/%i depth %i live %i/%i,"
+				" expected %g (alu %g tex %g flow %g) fetches %i/%i depth %i live %i/%i\n", e.shader, e.target,
+				cost.cycles, cost.aluCycles, cost.textureCycles, cost.flowCycles, cost.textureFetches, cost.dependentFetches, cost.textureDepth, cost.liveComponents, cost.liveVec4s,
+				e.cycles, e.alu, e.tex, e.flow, e.fetches, e.dependent, e.depth, e.liveComponents, e.liveVec4s);
+			++failures;
+		}
+	}
+	for (int i = 0; i < kThreadedTestTargets; ++i)
+		glslopt_cleanup (ctx[i]);
+	return failures == 0;
+}
+
+// With kGlslOptionLimitRegisterPressure, grafts that would raise the peak
+// register pressure are skipped: the output keeps more statements, and the
+// reported pressure goes down
+static bool TestRegisterPressure ()
+{
+	static const char* kShader =
+		"uniform sampler2D tex;\n"
+		"uniform mediump vec4 params;\n"
+		"varying highp vec2 uv;\n"
+		"mediump float falloff (mediump float d, mediump float power, mediump float scale) {\n"
+		"  mediump float x = clamp (1.0 - d * scale, 0.0, 1.0);\n"
+		"  mediump float y = pow (x, power);\n"
+		"  mediump float s = y * y * (3.0 - 2.0 * y);\n"
+		"  return s * (1.0 - exp2 (-power * d)) + sin (d * scale) * 0.1;\n"
+		"}\n"
+		"void main() {\n"
+		"  lowp vec4 c = texture2D (tex, uv);\n"
+		"  mediump float a = falloff (c.x, params.x, params.y);\n"
+		"  mediump float b = falloff (c.y, params.z, params.w);\n"
+		"  mediump float d = falloff (c.z, params.x, params.w);\n"
+		"  gl_FragColor = vec4 (a, b, d, 1.0);\n"
+		"}\n";
+
+	printf ("\n** running register pressure tests...\n");
+	glslopt_ctx* ctx = glslopt_initialize (kGlslTargetOpenGLES20);
+	glslopt_shader_cost cost[2];
+	int statements[2] = { 0, 0 };
+	int failures = 0;
+	for (int i = 0; i < 2; ++i)
+	{
+		glslopt_shader* shader = glslopt_optimize (ctx, kGlslOptShaderFragment, kShader, i ? kGlslOptionLimitRegisterPressure : 0);
+		if (!glslopt_get_status (shader))
+		{
+			printf ("\n  register pressure: failed to compile: %s\n", glslopt_get_log (shader));
+			++failures;
+		}
+		else
+		{
+			glslopt_shader_get_cost (shader, &cost[i]);
+			for (const char* s = glslopt_get_output (shader); *s; ++s)
+				statements[i] += *s == ';';
+		}
+		glslopt_shader_delete (shader);
+	}
+	glslopt_cleanup (ctx);
+	if (failures)
+		return false;
+
+	if (statements[1] <= statements[0])
+	{
+		printf ("\n  register pressure: %i statements with the limit, %i without; expected fewer grafts\n", statements[1], statements[0]);
+		++failures;
+	}
+	if (cost[1].liveComponents >= cost[0].liveComponents || cost[1].liveVec4s >= cost[0].liveVec4s)
+	{
+		printf ("\n  register pressure: peak of %i components, %i vec4s with the limit, %i and %i without; expected lower\n",
+			cost[1].liveComponents, cost[1].liveVec4s, cost[0].liveComponents, cost[0].liveVec4s);
+		++failures;
+	}
+	return failures == 0;
+}
+
+// A disk cache entry that is cut short anywhere must not be used, nor leave
+// anything behind in the shader that gets compiled instead
+static bool TestDiskCache (const std::string& baseFolder)
+{
+	static const char* kShader =
+		"uniform sampler2D tex;\n"
+		"uniform mediump vec4 tint;\n"
+		"uniform mediump vec4 fog;\n"
+		"varying highp vec2 uv;\n"
+		"varying lowp vec4 color;\n"
+		"void main() {\n"
+		"  gl_FragColor = mix (texture2D (tex, uv) * tint * color, fog, 0.5);\n"
+		"}\n";
+
+	printf ("\n** running disk cache tests...\n");
+	const std::string folder = baseFolder + "/disk-cache-test";
+	MakeDirectory (folder);
+
+	glslopt_ctx* ctx = glslopt_initialize (kGlslTargetOpenGLES20);
+	glslopt_set_cache (ctx, 0, folder.c_str());
+	glslopt_shader* shader = glslopt_optimize (ctx, kGlslOptShaderFragment, kShader, 0);
+	// GetThreadedTestResult deletes the shader, so take the reflection first
+	std::string expected = GetReflection (shader);
+	expected += GetThreadedTestResult (shader);
+
+	int failures = 0;
+	StringVector files = GetFiles (folder, ".glslopt");
+	std::string entry;
+	if (files.size() != 1 || !ReadBinaryFile (folder + "/" + files[0], entry))
+	{
+		printf ("\n  disk cache: no entry written\n");
+		++failures;
+	}
+	for (size_t size = 0; size < entry.size(); ++size)
+	{
+		WriteBinaryFile (folder + "/" + files[0], entry.substr (0, size));
+		shader = glslopt_optimize (ctx, kGlslOptShaderFragment, kShader, 0);
+		const std::string reflection = GetReflection (shader);
+		if (reflection + GetThreadedTestResult (shader) != expected)
+		{
+			printf ("\n  disk cache: entry cut to %i of %i bytes gives a different result\n", (int)size, (int)entry.size());
+			++failures;
+		}
+	}
+	int hits, misses;
+	glslopt_get_cache_stats (ctx, &hits, &misses);
+	if (hits != 0)
+	{
+		printf ("\n  disk cache: %i cut entries were used\n", hits);
+		++failures;
+	}
+	glslopt_cleanup (ctx);
+
+	files = GetFiles (folder, "");
+	for (size_t i = 0; i < files.size(); ++i)
+		DeleteFile (folder + "/" + files[i]);
+	RemoveDirectory (folder);
+	return failures == 0;
+}
+
+static bool TestThreaded (const std::string& baseFolder)
+{
+	static const char* kTypeName[2] = { "vertex", "fragment" };
+	static const char* kApiIn[3] = {"-inES.txt", "-inES3.txt", "-in.txt"};
+
+	glslopt_ctx* ctx[kThreadedTestTargets];
+	for (int i = 0; i < kThreadedTestTargets; ++i)
+		ctx[i] = glslopt_initialize (kThreadedTestTarget[i]);
+
+	ThreadedJobVector jobs;
+	for (int type = 0; type < 2; ++type)
+	{
+		std::string testFolder = baseFolder + "/" + kTypeName[type];
+		for (int api = 0; api < 3; ++api)
+		{
+			StringVector inputFiles = GetFiles (testFolder, kApiIn[api]);
+			for (size_t i = 0; i < inputFiles.size(); ++i)
+			{
+				ThreadedJob job;
+				job.name = inputFiles[i];
+				job.type = type == 0 ? kGlslOptShaderVertex : kGlslOptShaderFragment;
+				if (!ReadStringFromFile ((testFolder + "/" + job.name).c_str(), job.source))
+					continue;
+				if (api <= 1)
+				{
+					if (type == 0)
+						MassageVertexForGLES (job.source);
+					else
+						MassageFragmentForGLES (job.source);
+				}
+				// ES3 inputs also run through the Metal target, like the main tests do
+				for (int target = 0; target < kThreadedTestTargets; ++target)
+				{
+					if (target != api && !(target == 3 && api == 1))
+						continue;
+					job.target = target;
+					job.expected = CompileForThreadedTest (ctx[target], job);
+					jobs.push_back (job);
+				}
+			}
+		}
+	}
+
+	printf ("\n** running threaded tests (%i threads, %i shaders)...\n", kThreadedTestThreads, (int)jobs.size());
+	int mismatches = RunThreadedWorkers (jobs, ctx);
+	mismatches += RunThreadedWorkers (jobs, NULL);
+	mismatches += RunBatch (jobs, ctx);
+	mismatches += RunPack (jobs, ctx);
+	mismatches += RunVariants (jobs, ctx);
+	mismatches += RunVariantsDifferential (jobs, ctx);
+	mismatches += RunPrelude (ctx[0]);
+
+	// same again with result cache on; once everything is in the cache, a
+	// second run should not have any misses
+	for (int i = 0; i < kThreadedTestTargets; ++i)
+		glslopt_set_cache (ctx[i], 4096, NULL);
+	mismatches += RunThreadedWorkers (jobs, ctx);
+	int missesBefore = 0, missesAfter = 0;
+	for (int i = 0; i < kThreadedTestTargets; ++i)
+	{
+		int hits, misses;
+		glslopt_get_cache_stats (ctx[i], &hits, &misses);
+		missesBefore += misses;
+	}
+	mismatches += RunBatch (jobs, ctx);
+	for (int i = 0; i < kThreadedTestTargets; ++i)
+	{
+		int hits, misses;
+		glslopt_get_cache_stats (ctx[i], &hits, &misses);
+		missesAfter += misses;
+	}
+	if (missesAfter != missesBefore)
+	{
+		printf ("\n  result cache: %i unexpected misses\n", missesAfter - missesBefore);
+		++mismatches;
+	}
+
+	for (int i = 0; i < kThreadedTestTargets; ++i)
+		glslopt_cleanup (ctx[i]);
+
+	return mismatches == 0;
+}
+
+
 int main (int argc, const char** argv)
 {
 	if (argc < 2)
 	{
-		printf ("USAGE: glsloptimizer testfolder\n");
+		printf ("USAGE: glsloptimizer testfolder [profile.json]\n");
 		return 1;
 	}
 
@@ -642,10 +1600,21 @@ int main (int argc, const char** argv)
 
 	std::string baseFolder = argv[1];
 
-	clock_t time0 = clock();
+	if (argc > 2)
+	{
+		s_ProfileFile = fopen (argv[2], "wb");
+		if (!s_ProfileFile)
+		{
+			printf ("Failed to open %s for writing\n", argv[2]);
+			return 1;
+		}
+		fputs ("[\n", s_ProfileFile);
+		for (int i = 0; i < 3; ++i)
+			glslopt_set_profiling (ctx[i], true);
+		glslopt_set_profiling (ctxMetal, true);
+	}
 
-	// 2.39s
-	// ralloc fix 256 initial: 1.35s
+	clock_t time0 = clock();
 
 	static const char* kTypeName[2] = { "vertex", "fragment" };
 	size_t tests = 0;
@@ -672,7 +1641,13 @@ int main (int argc, const char** argv)
 				std::string outname = inname.substr (0,inname.size()-strlen(kApiIn[api])) + kApiOut[api];
 				std::string outnameMetal = inname.substr (0,inname.size()-strlen(kApiIn[api])) + kApiOutMetal[api];
 				const bool useMetal = (api == 1);
+				// inlinebudget-* tests run with a small inlining budget, so that some functions stay functions
+				const bool inlineBudget = inname.compare (0, 13, "inlinebudget-") == 0;
+				if (inlineBudget)
+					glslopt_set_inline_budget (ctx[api], 8, 4, 50);
 				bool ok = TestFile (ctx[api], type==0, inname, testFolder + "/" + inname, testFolder + "/" + outname, api<=1, hasOpenGL, false);
+				if (inlineBudget)
+					glslopt_set_inline_budget (ctx[api], kGlslInlineAll, 0, 0);
 				if (!ok)
 				{
 					++errors;
@@ -692,15 +1667,29 @@ int main (int argc, const char** argv)
 	clock_t time1 = clock();
 	float timeDelta = float(time1-time0)/CLOCKS_PER_SEC;
 
+	if (s_ProfileFile)
+	{
+		fputs ("\n]\n", s_ProfileFile);
+		fclose (s_ProfileFile);
+	}
+
+	if (!TestThreaded (baseFolder))
+		++errors;
+	if (!TestDiskCache (baseFolder))
+		++errors;
+	if (!TestCost ())
+		++errors;
+	if (!TestRegisterPressure ())
+		++errors;
+	if (!TestProgHashTable ())
+		++errors;
+
 	if (errors != 0)
 		printf ("\n**** %i tests (%.2fsec), %i !!!FAILED!!!\n", (int)tests, timeDelta, (int)errors);
 	else
 		printf ("\n**** %i tests (%.2fsec) succeeded\n", (int)tests, timeDelta);
-	
-	// 3.25s
-	// with builtin call linking, 3.84s
 
-	for (int i = 0; i < 2; ++i)
+	for (int i = 0; i < 3; ++i)
 		glslopt_cleanup (ctx[i]);
 	glslopt_cleanup (ctxMetal);
 	CleanupGL();